@@ -22,6 +22,7 @@
 #pragma once
 
 #include <defines.h>
+#include <renderer_types.h>
 
 struct game;  // Forward declaration
 
@@ -31,9 +32,23 @@ typedef struct {
   i16 start_width;
   i16 start_height;
   char *name;
+  // Presentation policy, can be changed later with `renderer_set_present_config`
+  renderer_present_config present_config;
+  // Rendered frames per second, 0 leaves it unlimited (or up to the present mode)
+  u16 target_frame_rate;
+  // Frame rate while the window is not focused, 0 keeps `target_frame_rate`
+  u16 unfocused_frame_rate;
+  // Fixed `game.update` steps per second, 0 picks the default
+  u16 update_rate;
 } application_config;
 
 KAPI b8 application_create(struct game *game_inst);
 KAPI b8 application_run(void);
 
+KAPI void application_set_target_frame_rate(u16 target_frame_rate);
+
+// Fraction of a fixed update step the rendered frame is past the last `game.update`, in [0, 1)
+// (the same value `game.render` receives)
+KAPI f32 application_get_frame_interpolation(void);
+
 void application_set_framebuffer_size(u32 *width, u32 *height);
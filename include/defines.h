@@ -136,3 +136,10 @@ STATIC_ASSERT(sizeof(f64) == 8, "ERROR: f64 :: 8B");
 #define KINLINE static inline
 #define KNOINLINE
 #endif  // _MSC_VER
+
+// Thread-local storage
+#ifdef _MSC_VER
+#define KTHREAD_LOCAL __declspec(thread)
+#else
+#define KTHREAD_LOCAL _Thread_local
+#endif  // _MSC_VER
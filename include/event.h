@@ -56,6 +56,8 @@ typedef enum {
   EVENT_CODE_MOUSE_MOVED      = 0x06,
   EVENT_CODE_MOUSE_WHEEL      = 0x07,
   EVENT_CODE_RESIZED          = 0x08,
+  // `data.u8[0]` is true when the window gained focus
+  EVENT_CODE_FOCUS_CHANGED    = 0x09,
   EVENT_CODE_DEBUG0           = 0x10,
   EVENT_CODE_DEBUG1           = 0x11,
   EVENT_CODE_DEBUG2           = 0x12,
@@ -68,3 +68,6 @@ KAPI b8 filesystem_write(file_handle *handle,
                          u64 size,
                          const void *data,
                          u64 *out_bytes_written);
+
+// Replaces `new_path` if it already exists
+KAPI b8 filesystem_rename(const char *old_path, const char *new_path);
@@ -0,0 +1,52 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+
+#define FRAME_PACER_SPIN_TIME 0.001  // seconds before the deadline spent spinning instead of sleeping
+#define FRAME_PACER_MAX_STEPS 8  // fixed updates per frame, the rest of a long stall is dropped
+
+typedef struct {
+  // Seconds per rendered frame, 0 leaves the frame rate unlimited
+  f64 target_frame_time;
+  // Seconds per simulation step
+  f64 fixed_step;
+  // Simulation time not consumed by a fixed step yet
+  f64 accumulator;
+  // Absolute time the current frame has to end at
+  f64 deadline;
+} frame_pacer;
+
+// A `target_rate` of 0 disables the limiter, `update_rate` must not be 0
+KAPI void frame_pacer_create(f64 target_rate, f64 update_rate, frame_pacer *out_pacer);
+
+KAPI void frame_pacer_set_target_rate(frame_pacer *pacer, f64 target_rate);
+
+// Adds `delta` seconds of simulation time and returns how many fixed steps to run
+KAPI u32 frame_pacer_accumulate(frame_pacer *pacer, f64 delta);
+
+// How far the render state is between the last two fixed steps, in [0, 1)
+KAPI f32 frame_pacer_interpolation(const frame_pacer *pacer);
+
+// Sleeps until the frame's deadline, then spins the last `FRAME_PACER_SPIN_TIME` for precision
+KAPI void frame_pacer_wait(frame_pacer *pacer);
@@ -32,12 +32,25 @@ KAPI void free_list_create(u32 total_size,
                            void *memory,
                            free_list *out_list);
 
+// Caps the bookkeeping nodes (i.e. how fragmented the free space may get) instead of deriving it from `total_size`
+KAPI void free_list_create_with_max_entries(u32 total_size,
+                                            u32 max_entries,
+                                            u64 *memory_requirements,
+                                            void *memory,
+                                            free_list *out_list);
+
 KAPI void free_list_destroy(free_list *list);
 
 KAPI b8 free_list_alloc(free_list *list, u32 size, u32 *out_offset);
 
+// Like `free_list_alloc`, but only considers blocks starting below `limit` (and does not warn on failure)
+KAPI b8 free_list_alloc_below(free_list *list, u32 size, u32 limit, u32 *out_offset);
+
 KAPI b8 free_list_free(free_list *list, u32 size, u32 offset);
 
+// Grows the managed range, the new space is appended as free (the node count stays the same)
+KAPI b8 free_list_resize(free_list *list, u32 new_total_size);
+
 KAPI void free_list_clear(free_list *list);
 
 KAPI u64 free_list_get_free_space(free_list *list);
@@ -29,6 +29,8 @@ typedef struct game {
   application_config app_config;
   b8 (*initialize)(struct game *game_inst);
   b8 (*update)(struct game *game_inst, f32 delta_time);
-  b8 (*render)(struct game *game_inst, f32 delta_time);
+  // `interpolation` is how far the frame is into the next fixed update step, in [0, 1):
+  // blend each object's previous and current simulated state by it
+  b8 (*render)(struct game *game_inst, f32 delta_time, f32 interpolation);
   void (*on_resize)(struct game *game_inst, u32 width, u32 height);
 } game;
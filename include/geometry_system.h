@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <handle_pool.h>
 #include <renderer_types.h>
 
 #define FALLBACK_GEOMETRY_NAME "fallback"
@@ -36,8 +37,8 @@ typedef struct {
   u32 index_size;
   u32 index_count;
   void *indices;
-  char name[GEOMETRY_NAME_MAX_LEN];
-  char material_name[MATERIAL_NAME_MAX_LEN];
+  kname name;
+  kname material_name;
 } geometry_config;
 
 b8 geometry_system_initialize(u64 *memory_requirements,
@@ -50,12 +51,18 @@ geometry *geometry_system_get(u32 id);
 
 geometry *geometry_system_get_from_cfg(geometry_config cfg, b8 auto_release);
 
+khandle geometry_system_get_handle_from_cfg(geometry_config cfg, b8 auto_release);
+
+geometry *geometry_system_resolve(khandle handle);
+
 geometry *geometry_system_get_fallback(void);
 
 geometry *geometry_system_get_fallback_2D(void);
 
 void geometry_system_release(geometry *geometry);
 
+void geometry_system_release_handle(khandle handle);
+
 geometry_config geometry_system_gen_plane_cfg(f32 width,
                                               f32 height,
                                               u32 x_segment_count,
@@ -0,0 +1,61 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+
+#define KHANDLE_INVALID ((khandle) { .index = INVALID_ID, .generation = INVALID_ID })
+
+// Slot index plus the generation it was acquired with (stale handles fail to resolve)
+typedef struct {
+  u32 index;
+  u32 generation;
+} khandle;
+
+typedef struct {
+  u32 capacity;
+  u32 count;
+  u32 free_head;
+  u32 *next_free;
+  u32 *generations;
+} handle_pool;
+
+KAPI void handle_pool_create(u32 capacity,
+                             u64 *memory_requirements,
+                             void *memory,
+                             handle_pool *out_pool);
+
+KAPI void handle_pool_destroy(handle_pool *pool);
+
+KAPI void handle_pool_clear(handle_pool *pool);
+
+KAPI b8 handle_pool_acquire(handle_pool *pool, khandle *out_handle);
+
+KAPI b8 handle_pool_release(handle_pool *pool, khandle handle);
+
+KAPI b8 handle_pool_is_valid(const handle_pool *pool, khandle handle);
+
+KAPI khandle handle_pool_from_index(const handle_pool *pool, u32 index);
+
+KINLINE b8 khandle_is_invalid(khandle handle) {
+  return handle.index == INVALID_ID;
+}
@@ -23,15 +23,22 @@
 
 #include <defines.h>
 
+#define HASH_TABLE_KEY_MAX_LEN 256
+#define HASH_TABLE_MAX_LOAD_FACTOR 90  // percentage of the (power of two) capacity
+
 typedef struct {
   u64 element_size;
   u32 element_count;
+  u32 capacity;
+  u32 length;
+  u64 slot_size;
   void *memory;
   b8 is_pointer_type;
 } hash_table;
 
 KAPI void hash_table_create(u64 element_size,
                             u32 element_count,
+                            u64 *memory_requirements,
                             void *memory,
                             b8 is_pointer_type,
                             hash_table *out_hash_table);
@@ -54,5 +61,8 @@ KAPI b8 hash_table_get_ptr(hash_table *table,
                            const char *name,
                            void **out_value);
 
+KAPI b8 hash_table_remove(hash_table *table,
+                          const char *name);
+
 KAPI b8 hash_table_fill(hash_table *table,
                         void *value);
@@ -0,0 +1,68 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+#include <katomic.h>
+
+#define JOB_SYSTEM_MAX_WORKERS 64
+#define JOB_SYSTEM_DEQUE_CAPACITY 4096  // must be a power of two
+
+typedef void (*job_fn)(void *data);
+
+typedef void (*job_range_fn)(u32 start, u32 end, void *data);
+
+// Number of unfinished jobs submitted against it (zero-initialize before use)
+typedef struct {
+  katomic_i64 pending;
+} job_counter;
+
+typedef struct {
+  job_fn fn;
+  void *data;
+  job_counter *counter;
+} job;
+
+typedef struct {
+  // 0 means one worker per core (the calling thread counts as worker 0)
+  u32 worker_count;
+} job_system_config;
+
+b8 job_system_initialize(u64 *memory_requirements,
+                         void *state,
+                         job_system_config config);
+
+void job_system_shutdown(void *state);
+
+KAPI u32 job_system_worker_count(void);
+
+KAPI void job_system_submit(job_fn fn, void *data, job_counter *counter);
+
+KAPI void job_system_wait(job_counter *counter);
+
+// Runs at most one queued job on the calling worker, returns false if there was none
+KAPI b8 job_system_try_run(void);
+
+KAPI void job_system_parallel_for(u32 count,
+                                  u32 batch_size,
+                                  job_range_fn fn,
+                                  void *data);
@@ -0,0 +1,68 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+#include <stdatomic.h>
+
+typedef _Atomic u8 katomic_b8;
+typedef _Atomic u32 katomic_u32;
+typedef _Atomic i32 katomic_i32;
+typedef _Atomic u64 katomic_u64;
+typedef _Atomic i64 katomic_i64;
+typedef _Atomic(void *) katomic_ptr;
+
+#define KATOMIC_RELAXED memory_order_relaxed
+#define KATOMIC_ACQUIRE memory_order_acquire
+#define KATOMIC_RELEASE memory_order_release
+#define KATOMIC_ACQ_REL memory_order_acq_rel
+#define KATOMIC_SEQ_CST memory_order_seq_cst
+
+// Sequentially consistent by default, `_explicit` variants take a KATOMIC_* order
+#define katomic_init(obj, value) atomic_init(obj, value)
+#define katomic_load(obj) atomic_load(obj)
+#define katomic_store(obj, value) atomic_store(obj, value)
+#define katomic_exchange(obj, value) atomic_exchange(obj, value)
+#define katomic_fetch_add(obj, value) atomic_fetch_add(obj, value)
+#define katomic_fetch_sub(obj, value) atomic_fetch_sub(obj, value)
+#define katomic_cas(obj, expected, desired) atomic_compare_exchange_strong(obj, expected, desired)
+#define katomic_fence() atomic_thread_fence(memory_order_seq_cst)
+
+#define katomic_load_explicit(obj, order) atomic_load_explicit(obj, order)
+#define katomic_store_explicit(obj, value, order) atomic_store_explicit(obj, value, order)
+#define katomic_exchange_explicit(obj, value, order) atomic_exchange_explicit(obj, value, order)
+#define katomic_fetch_add_explicit(obj, value, order) atomic_fetch_add_explicit(obj, value, order)
+#define katomic_fetch_sub_explicit(obj, value, order) atomic_fetch_sub_explicit(obj, value, order)
+#define katomic_cas_explicit(obj, expected, desired, success, failure) \
+  atomic_compare_exchange_strong_explicit(obj, expected, desired, success, failure)
+#define katomic_cas_weak_explicit(obj, expected, desired, success, failure) \
+  atomic_compare_exchange_weak_explicit(obj, expected, desired, success, failure)
+#define katomic_fence_explicit(order) atomic_thread_fence(order)
+
+// Spin-wait hint (lets the sibling hyperthread run and saves power)
+KINLINE void katomic_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
@@ -0,0 +1,47 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <defines.h>
+
+#define KHASH_DEFAULT_SEED 0
+#define KHASH_BLOCK_SIZE 48
+#define KHASH_HISTORY_SIZE 16
+
+// Incremental hashing state, produces the same result as `khash`
+typedef struct {
+  u64 seed;
+  u64 see1;
+  u64 see2;
+  u64 length;
+  u32 buffered;
+  u8 buffer[KHASH_HISTORY_SIZE + KHASH_BLOCK_SIZE];
+} khash_state;
+
+KAPI u64 khash(const void *data, u64 length, u64 seed);
+
+KAPI u64 khash_str(const char *str);
+
+KAPI void khash_begin(khash_state *state, u64 seed);
+
+KAPI void khash_update(khash_state *state, const void *data, u64 length);
+
+KAPI u64 khash_end(khash_state *state);
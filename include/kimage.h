@@ -0,0 +1,32 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+
+// Levels of a full mip chain down to 1x1
+KAPI u32 kimage_mip_count(u32 width, u32 height);
+
+KAPI u32 kimage_mip_extent(u32 extent, u32 level);
+
+// 2x2 box filter into the next mip level, `dst` may alias `src` (downsample in place)
+KAPI void kimage_downsample(const u8 *src, u32 width, u32 height, u8 channel_count, u8 *dst);
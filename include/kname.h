@@ -0,0 +1,54 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <defines.h>
+
+#define KNAME_NONE 0
+#define KNAME_MAX_LEN 256         // including '\0'
+#define KNAME_MAX_COUNT 16384        // >= texture + material + geometry registries
+#define KNAME_STORAGE_SIZE (2 * 1024 * 1024)  // 2MB
+#define KNAME_LOOKUP_CAPACITY (KNAME_MAX_COUNT * 2)  // power of two, keeps probe sequences short
+
+// Literal names interned first, in this order, at init. Their IDs are compile-time constants
+// (`KNAME_<id>`), usable in `switch` cases and static initializers
+#define KNAME_BUILTINS(X)   \
+  X(FALLBACK, "fallback")
+
+typedef u32 kname;
+
+#define KNAME_BUILTIN_ID(id, str) KNAME_##id,
+enum {
+  KNAME_BUILTIN_BEGIN = KNAME_NONE,
+  KNAME_BUILTINS(KNAME_BUILTIN_ID)
+  KNAME_BUILTIN_END  // first ID handed out at runtime
+};
+#undef KNAME_BUILTIN_ID
+
+b8 kname_system_initialize(u64 *memory_requirements, void *state);
+
+void kname_system_shutdown(void *state);
+
+KAPI kname kname_create(const char *str);
+
+KAPI kname kname_find(const char *str);
+
+KAPI const char *kname_str(kname name);
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <defines.h>
+#include <handle_pool.h>
 #include <resource_types.h>
 
 #define FALLBACK_MATERIAL_NAME "fallback"
@@ -42,4 +43,12 @@ material *material_system_get_fallback(void);
 
 material *material_system_get_from_cfg(material_config cfg);
 
+khandle material_system_get_handle_from_cfg(material_config cfg);
+
+material *material_system_resolve(khandle handle);
+
 void material_system_release(const char *name);
+
+void material_system_release_kname(kname name);
+
+void material_system_release_handle(khandle handle);
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <defines.h>
+#include <katomic.h>
 
 b8 platform_system_startup(u64 *memory_requirements,
                            void *state,
@@ -35,6 +36,9 @@ void platform_system_shutdown(void *plat_state);
 
 b8 platform_pump_messages();
 
+// Blocks until a window message is pending or `timeout_ms` passes, without pumping it
+void platform_wait_for_messages(u64 timeout_ms);
+
 void *platform_allocate(u64 size, b8 aligned);
 void platform_free(void *block, b8 aligned);
 void *platform_zero_memory(void *block, u64 size);
@@ -47,3 +51,46 @@ void platform_console_write_error(const char *message, u8 color);
 f64 platform_get_absolute_time(void);
 
 void platform_sleep(u64 ms);
+
+typedef u32 (*platform_thread_start)(void *params);
+
+typedef struct {
+  void *internal_data;
+  u64 thread_id;
+} platform_thread;
+
+// Futex-backed (0: unlocked, 1: locked, 2: locked with waiters)
+typedef struct {
+  katomic_u32 state;
+} platform_mutex;
+
+// Futex-backed counting semaphore
+typedef struct {
+  katomic_u32 count;
+  katomic_u32 waiter_count;
+} platform_semaphore;
+
+b8 platform_thread_create(platform_thread_start start, void *params, platform_thread *out_thread);
+void platform_thread_join(platform_thread *thread);
+void platform_thread_yield(void);
+u64 platform_thread_get_id(void);
+// Applies to the calling thread (names longer than 15 characters are truncated on Linux)
+void platform_thread_set_name(const char *name);
+b8 platform_thread_set_affinity(u32 core_index);
+
+u32 platform_get_processor_count(void);
+
+// Directory of the running executable (no trailing separator)
+b8 platform_get_executable_dir(char *out_path, u64 max_len);
+
+void platform_mutex_create(platform_mutex *out_mutex);
+void platform_mutex_destroy(platform_mutex *mutex);
+void platform_mutex_lock(platform_mutex *mutex);
+b8 platform_mutex_try_lock(platform_mutex *mutex);
+void platform_mutex_unlock(platform_mutex *mutex);
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore *out_semaphore);
+void platform_semaphore_destroy(platform_semaphore *semaphore);
+void platform_semaphore_signal(platform_semaphore *semaphore);
+void platform_semaphore_wait(platform_semaphore *semaphore);
+b8 platform_semaphore_try_wait(platform_semaphore *semaphore);
@@ -0,0 +1,70 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+
+// Key layout (most significant first):
+//   opaque:      pass (2) | 0 (1) | material (16) | geometry (16) | depth (29, front to back)
+//   transparent: pass (2) | 1 (1) | depth (29, back to front) | material (16) | geometry (16)
+//   sequence:    pass (2) | 1 (1) | submission index (32)
+// Ids wider than 16 bits are truncated, which only weakens the grouping
+#define RENDER_QUEUE_DEPTH_BITS 29
+
+typedef struct {
+  u64 key;
+  // Index of the draw in whatever array the caller submitted from
+  u32 index;
+} render_queue_entry;
+
+typedef struct {
+  u32 count;
+  u32 capacity;
+  render_queue_entry *entries;
+  render_queue_entry *scratch;
+} render_queue;
+
+KAPI void render_queue_create(u32 capacity, render_queue *out_queue);
+
+KAPI void render_queue_destroy(render_queue *queue);
+
+KAPI void render_queue_clear(render_queue *queue);
+
+// Grows the queue when full
+KAPI void render_queue_push(render_queue *queue, u64 key, u32 index);
+
+// Stable LSD radix sort on the keys
+KAPI void render_queue_sort(render_queue *queue);
+
+// `depth` is normalized to [0, 1] (values outside are clamped)
+KAPI u64 render_queue_make_key(u8 pass,
+                               b8 transparent,
+                               u32 material_id,
+                               u32 geometry_id,
+                               f32 depth);
+
+// Keeps submission order inside the pass (e.g. overlapping UI elements)
+KAPI u64 render_queue_make_sequence_key(u8 pass, u32 sequence);
+
+KINLINE u8 render_queue_key_pass(u64 key) {
+  return (u8) (key >> 62);
+}
@@ -25,12 +25,18 @@
 
 b8 renderer_system_initialize(u64 *memory_requirements,
                               void *state,
-                              const char *application_name);
+                              renderer_system_config config);
 
 void renderer_system_shutdown(void *state);
 
 void renderer_on_resized(u16 width, u16 height);
 
+// Mode and queue depth changes take effect on the next frame, through a swapchain recreation
+KAPI void renderer_set_present_config(renderer_present_config config);
+
+// Blocks until the GPU is within the configured frame latency, call it before sampling input
+void renderer_wait_for_latency(void);
+
 b8 renderer_draw_frame(render_packet *packet);
 
 // This function should not have external visibility, but it does for now :D
@@ -33,6 +33,29 @@ typedef enum {
   RENDERER_BACKEND_TYPE_DIRECTX
 } renderer_backend_type;
 
+typedef enum {
+  RENDERER_PRESENT_MODE_FIFO,          // VSync, lowest power
+  RENDERER_PRESENT_MODE_FIFO_RELAXED,  // VSync, late frames tear instead of waiting a whole VBLANK
+  RENDERER_PRESENT_MODE_MAILBOX,       // newest frame at each VBLANK, low latency without tearing
+  RENDERER_PRESENT_MODE_IMMEDIATE,     // no VSync, lowest latency
+  RENDERER_PRESENT_MODE_COUNT
+} renderer_present_mode;
+
+typedef struct {
+  renderer_present_mode mode;
+  // Swapchain images above the presentation engine minimum (0 picks the default)
+  u8 queue_depth;
+  // Frames the CPU may start before the GPU finishes the earlier ones (0 leaves it to `frames_in_flight`)
+  u8 max_frame_latency;
+} renderer_present_config;
+
+typedef struct {
+  const char *application_name;
+  // Frames the CPU may record ahead of the GPU, fewer means less latency and more means more overlap
+  u8 frames_in_flight;
+  renderer_present_config present;
+} renderer_system_config;
+
 typedef struct {
   Matrix4 model;
   geometry *geometry;
@@ -53,22 +76,27 @@ typedef struct {
 
 typedef struct renderer_backend {
   u64 frame_number;
-  b8 (*initialize)(struct renderer_backend *backend, const char *application_name);
+  b8 (*initialize)(struct renderer_backend *backend, const renderer_system_config *config);
   void (*shutdown)(struct renderer_backend *backend);
   void (*resized)(struct renderer_backend *backend, u16 width, u16 height);
+  void (*set_present_config)(struct renderer_backend *backend, const renderer_present_config *config);
+  void (*wait_for_latency)(struct renderer_backend *backend);
   b8 (*begin_frame)(struct renderer_backend *backend, f32 delta_time);
+  // `instance_count` is every world instance the frame will draw
   void (*update_world)(Matrix4 proj,
                        Matrix4 view,
                        Vector3 view_pos,
                        Vector4 ambient_color,
-                       i32 mode);
+                       i32 mode,
+                       u32 instance_count);
   void (*update_ui)(Matrix4 proj,
                     Matrix4 view,
                     i32 mode);
   b8 (*end_frame)(struct renderer_backend *backend, f32 delta_time);
   b8 (*begin_renderpass)(struct renderer_backend *backend, u8 renderpass_id);
   b8 (*end_renderpass)(struct renderer_backend *backend, u8 renderpass_id);
-  void (*draw_geometry)(geometry_render_data data);
+  // Draws `instance_count` copies of `geometry`, one per model matrix
+  void (*draw_geometry)(geometry *geometry, const Matrix4 *models, u32 instance_count);
   b8 (*create_geometry)(geometry *geometry,
                         u32 vertex_size,
                         u32 vertex_count,
@@ -21,12 +21,9 @@
 
 #pragma once
 
+#include <kname.h>
 #include <math_types.h>
 
-#define TEXTURE_NAME_MAX_LEN 92  // should be [256, 512], but it SIGSEGV's
-#define MATERIAL_NAME_MAX_LEN 256
-#define GEOMETRY_NAME_MAX_LEN 256
-
 typedef enum {
   RESOURCE_TYPE_TEXT,
   RESOURCE_TYPE_BINARY,
@@ -58,7 +55,7 @@ typedef struct {
   u8 channel_count;
   b8 has_transparency;
   u32 generation;
-  char name[TEXTURE_NAME_MAX_LEN];
+  kname name;
   void *data;
 } texture;
 
@@ -78,11 +75,11 @@ typedef enum {
 } material_type;
 
 typedef struct {
-  char name[MATERIAL_NAME_MAX_LEN];
+  kname name;
   material_type type;
   b8 auto_release;
   Vector4 diffuse_color;
-  char diffuse_map_name[TEXTURE_NAME_MAX_LEN];
+  kname diffuse_map_name;
 } material_config;
 
 typedef struct {
@@ -90,7 +87,7 @@ typedef struct {
   u32 generation;
   u32 internal_id;
   material_type type;
-  char name[MATERIAL_NAME_MAX_LEN];
+  kname name;
   Vector4 diffuse_color;
   texture_map diffuse_map;
 } material;
@@ -99,6 +96,6 @@ typedef struct {
   u32 id;
   u32 generation;
   u32 internal_id;
-  char name[GEOMETRY_NAME_MAX_LEN];
+  kname name;
   material *material;
 } geometry;
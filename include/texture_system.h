@@ -21,12 +21,15 @@
 
 #pragma once
 
+#include <handle_pool.h>
 #include <renderer_types.h>
 
 #define FALLBACK_TEXTURE_NAME "fallback"
 
 typedef struct {
   u32 max_texture_count;
+  // Quality tier: loaded textures skip this many top mip levels (halving each side per level)
+  u8 mip_drop_count;
 } texture_system_config;
 
 b8 texture_system_initialize(u64 *memory_requirements,
@@ -37,6 +40,24 @@ void texture_system_shutdown(void *state);
 
 texture *texture_system_get(const char *name, b8 auto_release);
 
+texture *texture_system_get_kname(kname name, b8 auto_release);
+
+khandle texture_system_get_handle(kname name, b8 auto_release);
+
+// Returns immediately, the texture renders as the fallback until its generation becomes valid
+texture *texture_system_get_async(const char *name, b8 auto_release);
+
+texture *texture_system_get_async_kname(kname name, b8 auto_release);
+
+// Uploads finished async loads, call once per frame from the main thread
+void texture_system_update(void);
+
+texture *texture_system_resolve(khandle handle);
+
 texture *texture_system_get_fallback(void);
 
 void texture_system_release(const char *name);
+
+void texture_system_release_kname(kname name);
+
+void texture_system_release_handle(khandle handle);
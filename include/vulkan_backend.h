@@ -24,19 +24,24 @@
 #include <resource_types.h>
 #include <renderer_backend.h>
 
-b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *application_name);
+b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const renderer_system_config *config);
 
 void vulkan_renderer_backend_shutdown(renderer_backend *backend);
 
 void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width, u16 height);
 
+void vulkan_renderer_backend_set_present_config(renderer_backend *backend, const renderer_present_config *config);
+
+void vulkan_renderer_backend_wait_for_latency(renderer_backend *backend);
+
 b8 vulkan_renderer_backend_begin_frame(renderer_backend *backend, f32 delta_time);
 
 void vulkan_renderer_backend_update_world(Matrix4 proj,
                                           Matrix4 view,
                                           Vector3 view_pos,
                                           Vector4 ambient_color,
-                                          i32 mode);
+                                          i32 mode,
+                                          u32 instance_count);
 
 void vulkan_renderer_backend_update_ui(Matrix4 proj, Matrix4 view, i32 mode);
 
@@ -46,7 +51,7 @@ b8 vulkan_renderer_backend_begin_renderpass(renderer_backend *backend, u8 render
 
 b8 vulkan_renderer_backend_end_renderpass(renderer_backend *backend, u8 renderpass_id);
 
-void vulkan_renderer_backend_draw_geometry(geometry_render_data data);
+void vulkan_renderer_backend_draw_geometry(geometry *geometry, const Matrix4 *models, u32 instance_count);
 
 b8 vulkan_renderer_backend_create_geometry(geometry *geometry,
                                            u32 vertex_size,
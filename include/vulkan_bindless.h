@@ -0,0 +1,39 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+// Leaves the table disabled (not an error) when the device lacks descriptor indexing
+b8 vulkan_bindless_textures_create(vulkan_context *context, vulkan_bindless_textures *out_table);
+
+void vulkan_bindless_textures_destroy(vulkan_context *context, vulkan_bindless_textures *table);
+
+// Writes the texture into a free slot once, materials then refer to it by index
+b8 vulkan_bindless_textures_register(vulkan_context *context,
+                                     vulkan_bindless_textures *table,
+                                     VkImageView view,
+                                     VkSampler sampler,
+                                     u32 *out_index);
+
+// Only call once no frame in flight can read the slot (see `vulkan_deletion_queue_push_bindless_slot`)
+void vulkan_bindless_textures_release(vulkan_bindless_textures *table, u32 index);
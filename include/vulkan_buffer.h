@@ -56,11 +56,10 @@ void vulkan_buffer_copy(vulkan_context *context,
                         u64 dst_offset,
                         u64 size);
 
+// Copies the contents on the GPU, the old buffer is destroyed once no frame in flight uses it
 b8 vulkan_buffer_resize(vulkan_context *context,
                         u64 new_size,
-                        vulkan_buffer *buffer,
-                        VkQueue queue,
-                        VkCommandPool pool);
+                        vulkan_buffer *buffer);
 
 void vulkan_buffer_bind(vulkan_context *context,
                         vulkan_buffer *buffer,
@@ -0,0 +1,65 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+void vulkan_deletion_queue_create(vulkan_deletion_queue *out_queue);
+
+// Destroys every queued resource, the device must be idle
+void vulkan_deletion_queue_destroy(vulkan_context *context, vulkan_deletion_queue *queue);
+
+// Queues a resource the frame being recorded may still use (takes ownership of it)
+void vulkan_deletion_queue_push_image(vulkan_deletion_queue *queue, const vulkan_image *image);
+
+void vulkan_deletion_queue_push_buffer(vulkan_deletion_queue *queue, const vulkan_buffer *buffer);
+
+// Returns a sub-range of `list` once no frame in flight reads it
+void vulkan_deletion_queue_push_range(vulkan_deletion_queue *queue, free_list *list, u32 offset, u32 size);
+
+void vulkan_deletion_queue_push_descriptor_sets(vulkan_deletion_queue *queue,
+                                                VkDescriptorPool pool,
+                                                u32 count,
+                                                const VkDescriptorSet *sets);
+
+void vulkan_deletion_queue_push_bindless_slot(vulkan_deletion_queue *queue, u32 slot);
+
+void vulkan_deletion_queue_push_image_view(vulkan_deletion_queue *queue, VkImageView view);
+
+void vulkan_deletion_queue_push_framebuffer(vulkan_deletion_queue *queue, VkFramebuffer framebuffer);
+
+// Retired swapchain (passed as `oldSwapchain`), its images may still be rendered to or presented
+void vulkan_deletion_queue_push_swapchain(vulkan_deletion_queue *queue, VkSwapchainKHR swapchain);
+
+void vulkan_deletion_queue_push_semaphore(vulkan_deletion_queue *queue, VkSemaphore semaphore);
+
+// Returns `handle` to `pool` once no frame in flight uses the slot
+void vulkan_deletion_queue_push_handle(vulkan_deletion_queue *queue, handle_pool *pool, khandle handle);
+
+// Call right after submitting the frame recorded in slot `frame`
+void vulkan_deletion_queue_frame_submitted(vulkan_deletion_queue *queue, u32 frame);
+
+// Call once the in-flight fence of slot `frame` has signaled
+void vulkan_deletion_queue_frame_completed(vulkan_context *context, vulkan_deletion_queue *queue, u32 frame);
+
+// Destroys the entries of every frame up to `serial` (e.g. all submitted ones after a device wait)
+void vulkan_deletion_queue_collect(vulkan_context *context, vulkan_deletion_queue *queue, u64 serial);
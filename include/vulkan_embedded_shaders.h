@@ -0,0 +1,36 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <defines.h>
+
+// SPIR-V linked into the engine, generated by `make EMBED_SHADERS=1`
+typedef struct {
+  const char *name;  // e.g. "builtin.material.vert"
+  const u8 *code;
+  u64 size;
+} vulkan_embedded_shader;
+
+#if defined(WGE_EMBED_SHADERS)
+extern const vulkan_embedded_shader vulkan_embedded_shaders[];
+extern const u32 vulkan_embedded_shader_count;
+#endif
@@ -27,6 +27,7 @@ void vulkan_image_create(vulkan_context *context,
                          VkImageType image_type,
                          u32 width,
                          u32 height,
+                         u32 mip_levels,
                          VkFormat format,
                          VkImageTiling tiling,
                          VkImageUsageFlags usage,
@@ -50,6 +51,13 @@ void vulkan_image_transition_layout(vulkan_context *context,
 void vulkan_image_copy(vulkan_context *context,
                        vulkan_image *image,
                        VkBuffer buffer,
+                       u64 buffer_offset,
                        vulkan_command_buffer *command_buffer);
 
+// Blits every level from the one above, the image must be in `VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL`
+// with level 0 written, and is left in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL`
+void vulkan_image_generate_mipmaps(vulkan_context *context,
+                                   vulkan_image *image,
+                                   vulkan_command_buffer *command_buffer);
+
 void vulkan_image_destroy(vulkan_context *context, vulkan_image *image);
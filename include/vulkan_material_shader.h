@@ -30,13 +30,25 @@ void vulkan_material_shader_destroy(vulkan_context *context, vulkan_material_sha
 
 void vulkan_material_shader_use(vulkan_context *context, vulkan_material_shader *shader);
 
+vulkan_material_shader_variant vulkan_material_shader_variant_for(const material *material);
+
+// Rebinds the pipeline only when the variant differs from the bound one
+void vulkan_material_shader_use_variant(vulkan_context *context,
+                                        vulkan_material_shader *shader,
+                                        vulkan_material_shader_variant variant);
+
+// Grows this frame's instance buffer to fit `instance_count` before anything binds it
 void vulkan_material_shader_update(vulkan_context *context,
                                    vulkan_material_shader *shader,
-                                   f32 delta_time);
-
-void vulkan_material_shader_set_model(vulkan_context *context,
-                                      vulkan_material_shader *shader,
-                                      Matrix4 model);
+                                   f32 delta_time,
+                                   u32 instance_count);
+
+// Copies the model matrices into this frame's instance buffer, returns the `firstInstance` to draw with
+b8 vulkan_material_shader_push_instances(vulkan_context *context,
+                                         vulkan_material_shader *shader,
+                                         const Matrix4 *models,
+                                         u32 count,
+                                         u32 *out_first_instance);
 
 void vulkan_material_shader_apply_material(vulkan_context *context,
                                            vulkan_material_shader *shader,
@@ -0,0 +1,44 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+b8 vulkan_memory_allocator_create(vulkan_context *context, vulkan_memory_allocator *out_allocator);
+
+void vulkan_memory_allocator_destroy(vulkan_context *context, vulkan_memory_allocator *allocator);
+
+// Reserves (but does not bind) memory for `buffer`, the memory type is stored in `out_allocation`
+b8 vulkan_memory_allocate_buffer(vulkan_context *context,
+                                 VkBuffer buffer,
+                                 u32 memory_property_flags,
+                                 vulkan_allocation *out_allocation);
+
+b8 vulkan_memory_allocate_image(vulkan_context *context,
+                                VkImage image,
+                                VkImageTiling tiling,
+                                u32 memory_property_flags,
+                                vulkan_allocation *out_allocation);
+
+void vulkan_memory_free(vulkan_context *context, vulkan_allocation *allocation);
+
+void vulkan_memory_log_usage(vulkan_context *context);
@@ -36,6 +36,7 @@ b8 vulkan_graphics_pipeline_create(vulkan_context *context,
                                    VkRect2D scissor,
                                    b8 is_wireframe,
                                    b8 depth_test_enabled,
+                                   b8 blend_enabled,
                                    vulkan_pipeline *out_pipeline);
 
 void vulkan_pipeline_destroy(vulkan_context *context, vulkan_pipeline *pipeline);
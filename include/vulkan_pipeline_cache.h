@@ -0,0 +1,30 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+// Seeds the cache from the file next to the executable when it matches the device and driver
+void vulkan_pipeline_cache_create(vulkan_context *context, VkPipelineCache *out_cache);
+
+// Writes the cache back to disk before destroying it
+void vulkan_pipeline_cache_destroy(vulkan_context *context, VkPipelineCache cache);
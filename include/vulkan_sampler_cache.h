@@ -0,0 +1,39 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+void vulkan_sampler_cache_create(vulkan_sampler_cache *out_cache);
+
+void vulkan_sampler_cache_destroy(vulkan_context *context, vulkan_sampler_cache *cache);
+
+// Returns the handle of a sampler matching `desc`, creating it on first use
+b8 vulkan_sampler_cache_acquire(vulkan_context *context,
+                                vulkan_sampler_cache *cache,
+                                const vulkan_sampler_desc *desc,
+                                u32 *out_handle);
+
+// Unreferenced samplers stay cached, there are only a handful of distinct states
+void vulkan_sampler_cache_release(vulkan_sampler_cache *cache, u32 handle);
+
+VkSampler vulkan_sampler_cache_get(vulkan_sampler_cache *cache, u32 handle);
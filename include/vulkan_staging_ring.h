@@ -0,0 +1,61 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+b8 vulkan_staging_ring_create(vulkan_context *context,
+                              u64 size,
+                              vulkan_staging_ring *out_ring);
+
+void vulkan_staging_ring_destroy(vulkan_context *context, vulkan_staging_ring *ring);
+
+// Copies `data` into the ring and records a copy into `dst` (runs on the next flush)
+b8 vulkan_staging_ring_upload_buffer(vulkan_context *context,
+                                     vulkan_staging_ring *ring,
+                                     vulkan_buffer *dst,
+                                     u64 dst_offset,
+                                     u64 size,
+                                     const void *data);
+
+// Fills level 0 and blits the rest of the mip chain, leaves `image` in
+// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` once the upload runs
+b8 vulkan_staging_ring_upload_image(vulkan_context *context,
+                                    vulkan_staging_ring *ring,
+                                    vulkan_image *image,
+                                    VkFormat format,
+                                    u64 size,
+                                    const void *pixels);
+
+// Records a GPU-side copy (regions must not overlap), returns the serial of the batch it runs in
+u64 vulkan_staging_ring_copy_buffer(vulkan_context *context,
+                                    vulkan_staging_ring *ring,
+                                    vulkan_buffer *src,
+                                    u64 src_offset,
+                                    vulkan_buffer *dst,
+                                    u64 dst_offset,
+                                    u64 size);
+
+b8 vulkan_staging_ring_is_complete(vulkan_context *context, vulkan_staging_ring *ring, u64 serial);
+
+// Submits the pending uploads without waiting for them
+void vulkan_staging_ring_flush(vulkan_context *context, vulkan_staging_ring *ring);
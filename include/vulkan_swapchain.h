@@ -25,10 +25,12 @@
 
 void vulkan_swapchain_create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *swapchain);
 
+// Creates the new swapchain from the old one, which is retired through `context->deletion_queue`
 void vulkan_swapchain_recreate(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *swapchain);
 
 void vulkan_swapchain_destroy(vulkan_context *context, vulkan_swapchain *swapchain);
 
+// Returns false when the swapchain is out of date and has to be recreated
 b8 vulkan_swapchain_get_next_image_index(vulkan_context *context,
                                          vulkan_swapchain *swapchain,
                                          u64 timeout_ns,
@@ -36,9 +38,10 @@ b8 vulkan_swapchain_get_next_image_index(vulkan_context *context,
                                          VkFence fence,
                                          u32 *out_image_index);
 
-void vulkan_swapchain_present(vulkan_context *context,
-                              vulkan_swapchain *swapchain,
-                              VkQueue graphics_queue,
-                              VkQueue present_queue,
-                              VkSemaphore render_complete_semaphore,
-                              u32 present_image_index);
+// Returns false when the swapchain is out of date or suboptimal and should be recreated
+b8 vulkan_swapchain_present(vulkan_context *context,
+                            vulkan_swapchain *swapchain,
+                            VkQueue graphics_queue,
+                            VkQueue present_queue,
+                            VkSemaphore render_complete_semaphore,
+                            u32 present_image_index);
@@ -23,10 +23,16 @@
 
 #include <defines.h>
 #include <asserts.h>
+#include <free_list.h>
+#include <handle_pool.h>
 #include <vulkan/vulkan.h>
 #include <renderer_types.h>
 
-#define FRAME_DESCRIPTOR_COUNT 8  // one per frame
+#define FRAME_DESCRIPTOR_COUNT 8  // one per frame, also the limit of frames in flight
+#define VULKAN_DEFAULT_FRAMES_IN_FLIGHT 2
+#define VULKAN_DEFAULT_PRESENT_QUEUE_DEPTH 1
+#define VULKAN_MAX_PRESENT_QUEUE_DEPTH 3
+#define VULKAN_MAX_SWAPCHAIN_IMAGES FRAME_DESCRIPTOR_COUNT  // requested ones, drivers may return more
 #define UI_SHADER_STAGE_COUNT 2  // vertex and fragment shaders
 #define UI_SHADER_OBJECT_DESCRIPTOR_COUNT 2
 #define UI_SHADER_OBJECT_SAMPLER_COUNT 1
@@ -34,20 +40,99 @@
 #define MATERIAL_SHADER_STAGE_COUNT 2  // vertex and fragment shaders
 #define MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT 2
 #define MATERIAL_SHADER_OBJECT_SAMPLER_COUNT 1
-#define MATERIAL_SHADER_MAX_MATERIALS 1024
+#define MATERIAL_SHADER_MAX_MATERIALS 4096
+#define MATERIAL_SHADER_INITIAL_INSTANCES 16384  // per frame, grows when a frame needs more
 #define GEOMETRY_MAX_COUNT 4096
+#define VULKAN_STAGING_RING_SIZE (64 * 1024 * 1024)
+#define VULKAN_STAGING_BATCH_COUNT 8
+#define VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES (GEOMETRY_MAX_COUNT * 2)
+#define VULKAN_GEOMETRY_MAX_PENDING_FREES 64
+#define VULKAN_GEOMETRY_DEFRAG_MOVES_PER_FRAME 4  // 0 disables the background compaction
+#define VULKAN_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+#define VULKAN_MEMORY_MIN_ALIGNMENT 256  // every sub-allocation starts and ends on this boundary
+// Holes and used ranges alternate, so a block never holds more holes than this and frees cannot run out of nodes
+#define VULKAN_MEMORY_BLOCK_MAX_ENTRIES (VULKAN_MEMORY_BLOCK_SIZE / VULKAN_MEMORY_MIN_ALIGNMENT / 2)
+#define VULKAN_MEMORY_DEDICATED_THRESHOLD (VULKAN_MEMORY_BLOCK_SIZE / 2)
+#define VULKAN_SAMPLER_CACHE_MAX_COUNT 64  // distinct sampler states, not textures
+#define VULKAN_BINDLESS_TEXTURES 1  // 0 keeps per-material texture descriptor sets
+#define VULKAN_BINDLESS_MAX_TEXTURES 4096  // the Makefile passes it to the bindless fragment shader
+#define VULKAN_PIPELINE_CACHE_FILE "pipeline_cache.bin"  // stored next to the executable
 #define VK_CHECK(e) KASSERT(e == VK_SUCCESS)
 
+// Specialization constant of the material fragment stages, keep in sync with `builtin.material*.frag.glsl`
+typedef enum {
+  MATERIAL_SHADER_VARIANT_UNTEXTURED,    // diffuse color only
+  MATERIAL_SHADER_VARIANT_OPAQUE,        // textured, blending disabled
+  MATERIAL_SHADER_VARIANT_ALPHA_TESTED,  // textured, discards fully transparent texels and blends the rest
+  MATERIAL_SHADER_VARIANT_COUNT
+} vulkan_material_shader_variant;
+
+typedef enum {
+  VULKAN_MEMORY_RESOURCE_LINEAR,   // buffers and linearly tiled images
+  VULKAN_MEMORY_RESOURCE_OPTIMAL,  // optimally tiled images
+  VULKAN_MEMORY_RESOURCE_KIND_COUNT
+} vulkan_memory_resource_kind;
+
+typedef struct {
+  VkDeviceMemory memory;
+  // Aligned offset of the resource inside `memory`
+  u64 offset;
+  u64 size;
+  // Host pointer to `offset` (0 unless the memory type is host visible)
+  u8 *mapped;
+  u32 memory_type;
+  // Index of the owning block, `INVALID_ID` for dedicated allocations
+  u32 block;
+  vulkan_memory_resource_kind kind;
+  // Range reserved in the block (includes the alignment padding)
+  u32 range_offset;
+  u32 range_size;
+} vulkan_allocation;
+
+typedef struct {
+  VkDeviceMemory memory;
+  u8 *mapped;
+  free_list list;
+  void *list_block;
+  u64 used;
+} vulkan_memory_block;
+
+typedef struct {
+  u64 block_bytes;
+  u64 dedicated_bytes;
+  // Bytes handed out to resources (both from blocks and dedicated)
+  u64 used_bytes;
+  u32 block_count;
+  u32 dedicated_count;
+} vulkan_memory_heap_stats;
+
+typedef struct {
+  // darray of blocks per memory type and resource kind (empty slots have no memory)
+  vulkan_memory_block *blocks[VK_MAX_MEMORY_TYPES][VULKAN_MEMORY_RESOURCE_KIND_COUNT];
+  vulkan_memory_heap_stats heaps[VK_MAX_MEMORY_HEAPS];
+  // Linear and optimal resources only need separate blocks if the granularity exceeds the minimum alignment
+  b8 separate_optimal;
+  u64 allocation_count;
+} vulkan_memory_allocator;
+
 typedef struct {
   u64 total_size;
   VkBuffer handle;
   VkBufferUsageFlagBits usage;
   b8 is_locked;
-  VkDeviceMemory memory;
+  vulkan_allocation allocation;
   i32 memory_index;
   u32 memory_property_flags;
 } vulkan_buffer;
 
+typedef struct {
+  u64 upload_count;
+  u64 uploaded_bytes;
+  u64 submit_count;
+  // Times an upload had to wait for in-flight data because the ring wrapped
+  u64 stall_count;
+} vulkan_staging_stats;
+
 typedef struct {
   VkSurfaceCapabilitiesKHR capabilities;
   u32 format_count;
@@ -74,14 +159,17 @@ typedef struct {
   VkPhysicalDeviceMemoryProperties memory;
   VkFormat depth_format;
   b8 supports_device_local_host_visible;
+  // Descriptor indexing features the bindless texture table needs
+  b8 supports_bindless;
 } vulkan_device;
 
 typedef struct {
   VkImage handle;
-  VkDeviceMemory memory;
+  vulkan_allocation allocation;
   VkImageView view;
   u32 width;
   u32 height;
+  u32 mip_levels;
 } vulkan_image;
 
 typedef enum {
@@ -108,12 +196,16 @@ typedef struct {
 typedef struct {
   VkSwapchainKHR handle;
   VkSurfaceFormatKHR image_format;
-  u8 max_frames_in_flight;
+  VkExtent2D extent;
   u32 image_count;
   VkImage *images;
   VkImageView *views;
+  // Binary, one per image: present waits on it, and the image is only re-acquired once that wait is done
+  VkSemaphore *render_complete_semaphores;
   vulkan_image depth_attachment;
-  VkFramebuffer framebuffers[FRAME_DESCRIPTOR_COUNT];
+  // One per image, sized by `image_count`
+  VkFramebuffer *world_framebuffers;
+  VkFramebuffer *framebuffers;
 } vulkan_swapchain;
 
 typedef enum {
@@ -130,6 +222,95 @@ typedef struct {
   vulkan_command_buffer_state state;
 } vulkan_command_buffer;
 
+typedef struct {
+  vulkan_command_buffer command_buffer;
+  VkFence fence;
+  // Ring head when the batch was submitted (everything before it is freed once the fence signals)
+  u64 end;
+  u64 serial;
+} vulkan_staging_batch;
+
+typedef struct {
+  vulkan_buffer buffer;
+  u8 *mapped;
+  u64 size;
+  u64 alignment;
+  // Both grow monotonically and are wrapped with `% size`
+  u64 head;
+  u64 tail;
+  vulkan_staging_batch batches[VULKAN_STAGING_BATCH_COUNT];
+  u32 first_in_flight;
+  u32 in_flight_count;
+  b8 recording;
+  // Serial of the last batch known to have finished on the GPU
+  u64 completed_serial;
+  vulkan_staging_stats stats;
+} vulkan_staging_ring;
+
+typedef enum {
+  VULKAN_DELETION_IMAGE,
+  VULKAN_DELETION_BUFFER,
+  VULKAN_DELETION_BUFFER_RANGE,
+  VULKAN_DELETION_DESCRIPTOR_SETS,
+  VULKAN_DELETION_BINDLESS_SLOT,
+  VULKAN_DELETION_IMAGE_VIEW,
+  VULKAN_DELETION_FRAMEBUFFER,
+  VULKAN_DELETION_SWAPCHAIN,
+  VULKAN_DELETION_SEMAPHORE,
+  VULKAN_DELETION_HANDLE
+} vulkan_deletion_type;
+
+typedef struct {
+  vulkan_deletion_type type;
+  // Frame that may still use the resource, it is destroyed once that frame's fence signals
+  u64 frame_serial;
+  union {
+    vulkan_image image;
+    vulkan_buffer buffer;
+    struct {
+      free_list *list;
+      u32 offset;
+      u32 size;
+    } range;
+    struct {
+      VkDescriptorPool pool;
+      u32 count;
+      VkDescriptorSet sets[FRAME_DESCRIPTOR_COUNT];
+    } descriptor_sets;
+    u32 bindless_slot;
+    VkImageView image_view;
+    VkFramebuffer framebuffer;
+    VkSwapchainKHR swapchain;
+    VkSemaphore semaphore;
+    struct {
+      handle_pool *pool;
+      khandle handle;
+    } handle;
+  };
+} vulkan_deletion;
+
+typedef struct {
+  // darray ordered by `frame_serial`
+  vulkan_deletion *entries;
+  // Frames submitted so far, the frame being recorded will be `submitted_serial + 1`
+  u64 submitted_serial;
+  u64 completed_serial;
+  // Serial each frame slot was last submitted with
+  u64 frame_serials[FRAME_DESCRIPTOR_COUNT];
+} vulkan_deletion_queue;
+
+// Host visible uniform buffer split in one region per frame in flight, bound with dynamic offsets
+typedef struct {
+  vulkan_buffer buffer;
+  u64 alignment;
+  u64 region_size;
+  // Bytes at the start of every region that are written in place each frame (never handed out)
+  u64 reserved_size;
+  u64 heads[FRAME_DESCRIPTOR_COUNT];
+  // Bumped whenever a region is reset, which invalidates the offsets its users cached
+  u32 epochs[FRAME_DESCRIPTOR_COUNT];
+} vulkan_uniform_ring;
+
 typedef struct {
   VkShaderModuleCreateInfo create_info;
   VkShaderModule handle;
@@ -146,9 +327,19 @@ typedef struct {
   u32 ids[FRAME_DESCRIPTOR_COUNT];
 } vulkan_descriptor_state;
 
+// Where the instance UBO was last written in each region of the uniform ring
+typedef struct {
+  u32 offsets[FRAME_DESCRIPTOR_COUNT];
+  u32 generations[FRAME_DESCRIPTOR_COUNT];
+  u32 epochs[FRAME_DESCRIPTOR_COUNT];
+} vulkan_uniform_cache;
+
 typedef struct {
   VkDescriptorSet descriptor_sets[FRAME_DESCRIPTOR_COUNT];
   vulkan_descriptor_state descriptor_states[MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT];
+  vulkan_uniform_cache ubo_cache;
+  // Bindless index the cached UBOs were written with
+  u32 diffuse_index;
 } vulkan_material_shader_instance_state;
 
 typedef struct {
@@ -162,39 +353,50 @@ typedef struct {
   u32 index_buffer_offset;
 } vulkan_geometry_data;
 
+// Range moved away from by the compaction, reusable once the copy reading it has run
+typedef struct {
+  free_list *list;
+  u64 serial;
+  u32 offset;
+  u32 size;
+} vulkan_geometry_pending_free;
+
 typedef struct {
   Matrix4 proj;
   Matrix4 view;
-  Matrix4 padding0;
-  Matrix4 padding1;
 } vulkan_material_shader_global_ubo;
 
 typedef struct {
   Vector4 diffuse_color;
-  // 48 (16*3) bytes first section padding
-  Vector4 padding0;
-  Vector4 padding1;
-  Vector4 padding2;
-  // 192 (64*3) bytes second section padding
-  Matrix4 padding3;
-  Matrix4 padding4;
-  Matrix4 padding5;
+  u32 diffuse_index;  // Bindless path only
+  u32 padding[3];
 } vulkan_material_shader_instance_ubo;
 
 typedef struct {
   vulkan_shader_stage stages[MATERIAL_SHADER_STAGE_COUNT];
-  vulkan_pipeline pipeline;
+  // Pipeline layouts are identical across variants, so descriptor sets stay bound when switching
+  vulkan_pipeline pipelines[MATERIAL_SHADER_VARIANT_COUNT];
+  vulkan_material_shader_variant bound_variant;
   VkDescriptorPool global_descriptor_pool;
   VkDescriptorPool object_descriptor_pool;
   VkDescriptorSet global_descriptor_sets[FRAME_DESCRIPTOR_COUNT];
   VkDescriptorSetLayout global_descriptor_set_layout;
   VkDescriptorSetLayout object_descriptor_set_layout;
   vulkan_material_shader_global_ubo global_ubo;
-  vulkan_buffer global_uniform_buffer;
-  vulkan_buffer object_uniform_buffer;
-  // TODO: manage this with a free list
-  u32 object_uniform_buffer_index;
+  // Global UBO in the reserved slot of each region, instance UBOs after it
+  vulkan_uniform_ring uniform_ring;
+  // Model matrices, one buffer per frame in flight (bound through that frame's global set)
+  vulkan_buffer instance_buffers[FRAME_DESCRIPTOR_COUNT];
+  // Matrices per buffer, the most any frame has needed so far
+  u32 instance_capacity;
+  u32 instance_count;
+  // Hands out `material.internal_id`, slots return through the deletion queue
+  handle_pool material_pool;
+  void *material_pool_block;
   texture_use sampler_uses[MATERIAL_SHADER_OBJECT_SAMPLER_COUNT];
+  // Textures come from `vulkan_context.bindless_textures`, every material shares `material_descriptor_set`
+  b8 bindless;
+  VkDescriptorSet material_descriptor_set;
   // TODO: make dynamic
   vulkan_material_shader_instance_state instance_states[MATERIAL_SHADER_MAX_MATERIALS];
 } vulkan_material_shader;
@@ -202,25 +404,16 @@ typedef struct {
 typedef struct {
   VkDescriptorSet descriptor_sets[FRAME_DESCRIPTOR_COUNT];
   vulkan_descriptor_state descriptor_states[UI_SHADER_OBJECT_DESCRIPTOR_COUNT];
+  vulkan_uniform_cache ubo_cache;
 } vulkan_ui_shader_instance_state;
 
 typedef struct {
   Matrix4 proj;
   Matrix4 view;
-  Matrix4 padding0;
-  Matrix4 padding1;
 } vulkan_ui_shader_global_ubo;
 
 typedef struct {
   Vector4 diffuse_color;
-  // 48 (16*3) bytes first section padding
-  Vector4 padding0;
-  Vector4 padding1;
-  Vector4 padding2;
-  // 192 (64*3) bytes second section padding
-  Matrix4 padding3;
-  Matrix4 padding4;
-  Matrix4 padding5;
 } vulkan_ui_shader_instance_ubo;
 
 typedef struct {
@@ -229,16 +422,62 @@ typedef struct {
   VkDescriptorSetLayout global_descriptor_set_layout;
   VkDescriptorSet global_descriptor_sets[FRAME_DESCRIPTOR_COUNT];
   vulkan_ui_shader_global_ubo global_ubo;
-  vulkan_buffer global_uniform_buffer;
+  vulkan_uniform_ring uniform_ring;
   VkDescriptorPool object_descriptor_pool;
   VkDescriptorSetLayout object_descriptor_set_layout;
-  vulkan_buffer object_uniform_buffer;
-  u32 object_uniform_buffer_index;
+  // Hands out `material.internal_id`, slots return through the deletion queue
+  handle_pool material_pool;
+  void *material_pool_block;
   texture_use sampler_uses[UI_SHADER_OBJECT_SAMPLER_COUNT];
   vulkan_ui_shader_instance_state instance_states[UI_SHADER_MAX_COUNT];
   vulkan_pipeline pipeline;
 } vulkan_ui_shader;
 
+// Sampler state textures can share, `max_anisotropy` of 0 disables anisotropic filtering
+typedef struct {
+  VkFilter filter;
+  VkSamplerMipmapMode mipmap_mode;
+  VkSamplerAddressMode address_mode;
+  f32 max_anisotropy;
+} vulkan_sampler_desc;
+
+typedef struct {
+  u32 count;
+  vulkan_sampler_desc descs[VULKAN_SAMPLER_CACHE_MAX_COUNT];
+  VkSampler samplers[VULKAN_SAMPLER_CACHE_MAX_COUNT];
+  u32 ref_counts[VULKAN_SAMPLER_CACHE_MAX_COUNT];
+} vulkan_sampler_cache;
+
+// One update-after-bind array every texture registers into once, indexed from material uniforms
+typedef struct {
+  b8 enabled;
+  VkDescriptorPool pool;
+  VkDescriptorSetLayout layout;
+  VkDescriptorSet set;
+  u32 next_slot;
+  u32 free_count;
+  u32 free_slots[VULKAN_BINDLESS_MAX_TEXTURES];
+} vulkan_bindless_textures;
+
+// Resources owned by one frame in flight, reused once the GPU is done with that frame
+typedef struct {
+  VkCommandPool command_pool;  // reset as a whole when the frame starts
+  vulkan_command_buffer command_buffer;
+  // Binary, acquire does not take timeline semaphores. Render completion is per swapchain image
+  VkSemaphore image_available_semaphore;
+  // `vulkan_context.frame_timeline` value signaled when the frame's submission completes
+  uint64_t timeline_value;
+} vulkan_frame;
+
+// What the current render pass has bound, so ordered draws can skip redundant binds
+typedef struct {
+  material *material;
+  u32 material_generation;
+  u64 vertex_offset;
+  b8 vertex_buffer_bound;
+  b8 index_buffer_bound;
+} vulkan_bind_state;
+
 typedef struct {
   VkInstance instance;
   VkAllocationCallbacks *allocator;
@@ -247,6 +486,7 @@ typedef struct {
   VkDebugUtilsMessengerEXT debug_messenger;
 #endif
   vulkan_device device;
+  vulkan_memory_allocator memory_allocator;
   u32 framebuffer_width;
   u32 framebuffer_height;
   u64 framebuffer_size_generation;
@@ -256,26 +496,44 @@ typedef struct {
   vulkan_renderpass ui_renderpass;
   vulkan_buffer object_vertex_buffer;
   vulkan_buffer object_index_buffer;
-  vulkan_command_buffer *graphics_command_buffers;
-  VkSemaphore *image_available_semaphores;
-  VkSemaphore *queue_complete_semaphores;
-  u32 in_flight_fence_count;
-  VkFence in_flight_fences[FRAME_DESCRIPTOR_COUNT];
-  VkFence *images_in_flight[FRAME_DESCRIPTOR_COUNT];
+  free_list object_vertex_free_list;
+  free_list object_index_free_list;
+  void *geometry_free_list_block;
+  vulkan_geometry_pending_free pending_geometry_frees[VULKAN_GEOMETRY_MAX_PENDING_FREES];
+  u32 pending_geometry_free_count;
+  vulkan_staging_ring staging_ring;
+  vulkan_deletion_queue deletion_queue;
+  vulkan_sampler_cache sampler_cache;
+  VkPipelineCache pipeline_cache;
+  vulkan_bindless_textures bindless_textures;
+  // Frames in flight, independent of the swapchain image count
+  u32 frame_count;
+  vulkan_frame frames[FRAME_DESCRIPTOR_COUNT];
+  // Counts completed frames, `frame_timeline_value` is the last value submitted
+  VkSemaphore frame_timeline;
+  uint64_t frame_timeline_value;
   u32 image_index;
-  u32 current_frame;
+  u32 current_frame;  // index into `frames`
   b8 recreating_swapchain;
+  // Presentation policy, mode and queue depth changes are applied by recreating the swapchain
+  renderer_present_mode present_mode;
+  u8 present_queue_depth;
+  u8 max_frame_latency;
+  b8 present_config_dirty;
   vulkan_material_shader material_shader;
   vulkan_ui_shader ui_shader;
-  u64 geometry_vertex_offset;
-  u64 geometry_index_offset;
+  vulkan_bind_state bind_state;
   f32 frame_delta_time;
   vulkan_geometry_data geometries[GEOMETRY_MAX_COUNT];
-  VkFramebuffer world_framebuffers[FRAME_DESCRIPTOR_COUNT];
+  handle_pool geometry_pool;
+  void *geometry_pool_block;
   i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
 } vulkan_context;
 
 typedef struct {
   vulkan_image image;
-  VkSampler sampler;
+  // Handle into `vulkan_context.sampler_cache`
+  u32 sampler;
+  // Slot in `vulkan_context.bindless_textures` (`INVALID_ID` when bindless is off)
+  u32 bindless_index;
 } vulkan_texture_data;
@@ -0,0 +1,60 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vulkan_types.h>
+
+// Every region holds `reserved_size` bytes followed by room for `entry_count` pushes of `entry_size` bytes
+b8 vulkan_uniform_ring_create(vulkan_context *context,
+                              u64 reserved_size,
+                              u64 entry_size,
+                              u32 entry_count,
+                              vulkan_uniform_ring *out_ring);
+
+void vulkan_uniform_ring_destroy(vulkan_context *context, vulkan_uniform_ring *ring);
+
+u64 vulkan_uniform_ring_align(vulkan_uniform_ring *ring, u64 size);
+
+// Offset of the reserved slot of `region` (usable as a dynamic offset)
+u32 vulkan_uniform_ring_region_offset(vulkan_uniform_ring *ring, u32 region);
+
+// Must be called once per frame before pushing, resets `region` if less than `min_free` bytes are left
+void vulkan_uniform_ring_begin_region(vulkan_uniform_ring *ring, u32 region, u64 min_free);
+
+void vulkan_uniform_ring_write(vulkan_uniform_ring *ring, u32 offset, const void *data, u64 size);
+
+b8 vulkan_uniform_ring_push(vulkan_uniform_ring *ring,
+                            u32 region,
+                            const void *data,
+                            u64 size,
+                            u32 *out_offset);
+
+void vulkan_uniform_cache_reset(vulkan_uniform_cache *cache);
+
+// Copies `data` into the current region unless it is already there for `generation`, returns its dynamic offset
+b8 vulkan_uniform_cache_write(vulkan_uniform_ring *ring,
+                              vulkan_uniform_cache *cache,
+                              u32 region,
+                              u32 generation,
+                              const void *data,
+                              u64 size,
+                              u32 *out_offset);
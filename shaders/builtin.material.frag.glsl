@@ -26,13 +26,39 @@ layout(location = 1) in struct dto {
   vec2 texcoord;
 } in_dto;
 
+// Also built with `BINDLESS` (and `BINDLESS_MAX_TEXTURES`) defined as 'builtin.material_bindless.frag'
+#ifdef BINDLESS
+layout(set = 1, binding = 0) uniform local_uniform_object {
+  vec4 diffuse_color;
+  uint diffuse_index;
+} object_ubo;
+// Every registered texture, the index is uniform per draw
+layout(set = 2, binding = 0) uniform sampler2D textures[BINDLESS_MAX_TEXTURES];
+#else
 layout(set = 1, binding = 0) uniform local_uniform_object {
   vec4 diffuse_color;
 } object_ubo;
 layout(set = 1, binding = 1) uniform sampler2D diffuse_sampler;
+#endif
 
 layout(location = 0) out vec4 out_color;
 
+// Values of `vulkan_material_shader_variant`, branches on it are resolved when the pipeline is built
+layout(constant_id = 0) const uint variant = 1;
+const uint VARIANT_UNTEXTURED = 0;
+const uint VARIANT_ALPHA_TESTED = 2;
+const float ALPHA_CUTOFF = 1.0 / 255.0;
+
 void main(void) {
-  out_color = object_ubo.diffuse_color * texture(diffuse_sampler, in_dto.texcoord);
+  if (variant == VARIANT_UNTEXTURED) {
+    out_color = object_ubo.diffuse_color;
+    return;
+  }
+#ifdef BINDLESS
+  vec4 color = object_ubo.diffuse_color * texture(textures[object_ubo.diffuse_index], in_dto.texcoord);
+#else
+  vec4 color = object_ubo.diffuse_color * texture(diffuse_sampler, in_dto.texcoord);
+#endif
+  if (variant == VARIANT_ALPHA_TESTED && color.a < ALPHA_CUTOFF) discard;
+  out_color = color;
 }
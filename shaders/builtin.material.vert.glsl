@@ -28,9 +28,10 @@ layout(set = 0, binding = 0) uniform global_uniform_obj {
   mat4 proj;
   mat4 view;
 } global_ubo;
-layout(push_constant) uniform push_constants {
-  mat4 model;
-} u_push_constants;
+// Model matrices of every instance drawn this frame (`firstInstance` points at the draw's first one)
+layout(set = 0, binding = 1) readonly buffer instance_buffer {
+  mat4 models[];
+} instances;
 
 layout(location = 0) out int out_mode;
 layout(location = 1) out struct dto {
@@ -39,5 +40,5 @@ layout(location = 1) out struct dto {
 
 void main(void) {
   out_dto.texcoord = in_texcoord;
-  gl_Position = global_ubo.proj * global_ubo.view * u_push_constants.model * vec4(in_pos, 1.0);
+  gl_Position = global_ubo.proj * global_ubo.view * instances.models[gl_InstanceIndex] * vec4(in_pos, 1.0);
 }
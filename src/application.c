@@ -23,12 +23,14 @@
 #include <input.h>
 #include <clock.h>
 #include <kmath.h>
+#include <kname.h>
 #include <logger.h>
 #include <asserts.h>
 #include <kmemory.h>
-#include <kstring.h>
 #include <platform.h>
 #include <game_types.h>
+#include <frame_pacer.h>
+#include <job_system.h>
 #include <application.h>
 #include <texture_system.h>
 #include <material_system.h>
@@ -37,21 +39,27 @@
 #include <linear_allocator.h>
 #include <renderer_frontend.h>
 
-#define FRAMERATE 60
 #define SYSTEMS_ALLOCATOR_SIZE 64 * 1024 * 1024  // 64MB
-#define TEXTURE_SYSTEM_MAX_COUNT 65536
+#define RENDERER_FRAMES_IN_FLIGHT 2
+#define TEXTURE_SYSTEM_MAX_COUNT 4096
+#define TEXTURE_SYSTEM_MIP_DROP_COUNT 0
 #define MATERIAL_SYSTEM_MAX_COUNT 4096
 #define GEOMETRY_SYSTEM_MAX_COUNT 4096
 #define RESOURCE_SYSTEM_MAX_COUNT 32
+#define APPLICATION_DEFAULT_UPDATE_RATE 60
+#define APPLICATION_SUSPENDED_WAIT_MS 100
 
 typedef struct {
   game *game_inst;
   b8 is_running;
   b8 is_suspended;
+  b8 is_focused;
+  u16 target_frame_rate;
   i16 width;
   i16 height;
   clock clock;
   f64 last_time;
+  frame_pacer pacer;
   linear_allocator systems_allocator;
   u64 event_system_memory_requirements;
   void *event_system_state;
@@ -59,10 +67,14 @@ typedef struct {
   void *memory_system_state;
   u64 logging_system_memory_requirements;
   void *logging_system_state;
+  u64 kname_system_memory_requirements;
+  void *kname_system_state;
   u64 input_system_memory_requirements;
   void *input_system_state;
   u64 platform_system_memory_requirements;
   void *platform_system_state;
+  u64 job_system_memory_requirements;
+  void *job_system_state;
   u64 resource_system_memory_requirements;
   void *resource_system_state;
   u64 renderer_system_memory_requirements;
@@ -80,6 +92,17 @@ typedef struct {
 
 static application_state *app_state;
 
+void application_set_target_frame_rate(u16 target_frame_rate) {
+  app_state->target_frame_rate = target_frame_rate;
+  u16 unfocused_frame_rate = app_state->game_inst->app_config.unfocused_frame_rate;
+  frame_pacer_set_target_rate(&app_state->pacer,
+                              app_state->is_focused || !unfocused_frame_rate ? target_frame_rate : unfocused_frame_rate);
+}
+
+f32 application_get_frame_interpolation(void) {
+  return frame_pacer_interpolation(&app_state->pacer);
+}
+
 void application_set_framebuffer_size(u32 *width, u32 *height) {
   *width = app_state->width;
   *height = app_state->height;
@@ -144,6 +167,9 @@ b8 application_on_resized(u16 code, void *sender, void *listener_inst, event_con
       else if (app_state->is_suspended) {
         KINFO("Application resumed (due to window restore)");
         app_state->is_suspended = false;
+        // The time spent suspended is not simulated
+        clock_update(&app_state->clock);
+        app_state->last_time = app_state->clock.elapsed;
       }
       app_state->game_inst->on_resize(app_state->game_inst, width, height);
       renderer_on_resized(width, height);
@@ -152,6 +178,18 @@ b8 application_on_resized(u16 code, void *sender, void *listener_inst, event_con
   return false;
 }
 
+b8 application_on_focus_changed(u16 code, void *sender, void *listener_inst, event_context context) {
+  (void) sender;         // Unused parameter
+  (void) listener_inst;  // Unused parameter
+
+  if (code == EVENT_CODE_FOCUS_CHANGED && context.data.u8[0] != app_state->is_focused) {
+    app_state->is_focused = context.data.u8[0];
+    KDEBUG("Window %s focus", app_state->is_focused ? "gained" : "lost");
+    application_set_target_frame_rate(app_state->target_frame_rate);
+  }
+  return false;
+}
+
 // TEMPORARY function to handle event which swaps the texture while app is running
 b8 event_on_debug(u16 code, void *sender, void *listener_inst, event_context data) {
   (void) code;           // Unused parameter
@@ -172,7 +210,7 @@ b8 event_on_debug(u16 code, void *sender, void *listener_inst, event_context dat
   choice %= 5;
 
   if (app_state->test_geometry) {
-    app_state->test_geometry->material->diffuse_map.texture = texture_system_get(names[choice], true);
+    app_state->test_geometry->material->diffuse_map.texture = texture_system_get_async(names[choice], true);
     if (!app_state->test_geometry->material->diffuse_map.texture) {
       KWARN("event_on_debug :: no texture detected (using fallback)");
       app_state->test_geometry->material->diffuse_map.texture = texture_system_get_fallback();
@@ -194,6 +232,8 @@ b8 application_create(game *game_inst) {
   app_state->game_inst = game_inst;
   app_state->is_running = false;
   app_state->is_suspended = false;
+  app_state->is_focused = true;
+  app_state->target_frame_rate = game_inst->app_config.target_frame_rate;
 
   linear_allocator_create(SYSTEMS_ALLOCATOR_SIZE, 0, &app_state->systems_allocator);
 
@@ -221,6 +261,16 @@ b8 application_create(game *game_inst) {
     return false;
   }
 
+  // Initialize kname system
+  kname_system_initialize(&app_state->kname_system_memory_requirements, 0);
+  app_state->kname_system_state = linear_allocator_alloc(&app_state->systems_allocator,
+                                                         app_state->kname_system_memory_requirements);
+  if (!kname_system_initialize(&app_state->kname_system_memory_requirements,
+                               app_state->kname_system_state)) {
+    KFATAL("Kname system initialization failed. Shutting down the engine...");
+    return false;
+  }
+
   // Initialize input system
   input_system_initialize(&app_state->input_system_memory_requirements, 0);
   app_state->input_system_state = linear_allocator_alloc(&app_state->systems_allocator,
@@ -233,6 +283,7 @@ b8 application_create(game *game_inst) {
   event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
   event_register(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
   event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
+  event_register(EVENT_CODE_FOCUS_CHANGED, 0, application_on_focus_changed);
   event_register(EVENT_CODE_DEBUG0, 0, event_on_debug);  // tmp
 
   // Initialize platform system
@@ -253,6 +304,20 @@ b8 application_create(game *game_inst) {
                                game_inst->app_config.start_width,
                                game_inst->app_config.start_height)) return false;
 
+  // Initialize job system
+  job_system_config job_system_cfg = {
+    .worker_count = 0  // one per core
+  };
+  job_system_initialize(&app_state->job_system_memory_requirements, 0, job_system_cfg);
+  app_state->job_system_state = linear_allocator_alloc(&app_state->systems_allocator,
+                                                       app_state->job_system_memory_requirements);
+  if (!job_system_initialize(&app_state->job_system_memory_requirements,
+                             app_state->job_system_state,
+                             job_system_cfg)) {
+    KFATAL("Job system initialization failed. Shutting down the engine...");
+    return false;
+  }
+
   // Initialize resource system
   resource_system_config resource_system_cfg = {
     .asset_base_path = "assets",
@@ -271,21 +336,27 @@ b8 application_create(game *game_inst) {
   }
 
   // Initialize renderer system
+  renderer_system_config renderer_system_cfg = {
+    .application_name = game_inst->app_config.name,
+    .frames_in_flight = RENDERER_FRAMES_IN_FLIGHT,
+    .present = game_inst->app_config.present_config
+  };
   renderer_system_initialize(&app_state->renderer_system_memory_requirements,
                              0,
-                             0);
+                             renderer_system_cfg);
   app_state->renderer_system_state = linear_allocator_alloc(&app_state->systems_allocator,
                                                             app_state->renderer_system_memory_requirements);
   if (!renderer_system_initialize(&app_state->renderer_system_memory_requirements,
                                   app_state->renderer_system_state,
-                                  game_inst->app_config.name)) {
+                                  renderer_system_cfg)) {
     KFATAL("Renderer initialization failed. Shutting down the engine...");
     return false;
   }
 
   // Initialize texture system
   texture_system_config texture_system_cfg = {
-    .max_texture_count = TEXTURE_SYSTEM_MAX_COUNT
+    .max_texture_count = TEXTURE_SYSTEM_MAX_COUNT,
+    .mip_drop_count = TEXTURE_SYSTEM_MIP_DROP_COUNT
   };
   texture_system_initialize(&app_state->texture_system_memory_requirements,
                             0,
@@ -387,9 +458,9 @@ b8 application_create(game *game_inst) {
     .index_count = 6,
     .indices = ui_index_list
   };
-  kstrncp(ui_geo_cfg.name, "ui_geometry", GEOMETRY_NAME_MAX_LEN);
+  ui_geo_cfg.name = kname_create("ui_geometry");
   // The `material_name` is the actual name of the material file ('ui.wmt')
-  kstrncp(ui_geo_cfg.material_name, "ui", MATERIAL_NAME_MAX_LEN);
+  ui_geo_cfg.material_name = kname_create("ui");
   app_state->test_ui_geometry = geometry_system_get_from_cfg(ui_geo_cfg, true);
   // TEMPORARY END: geometry test
   
@@ -409,29 +480,45 @@ b8 application_run(void) {
   clock_update(&app_state->clock);
   app_state->last_time = app_state->clock.elapsed;
 
-  f64 running_time = 0;
-  u8 frame_count = 0;
-  f64 target_frame_time = 1.0f / FRAMERATE;
+  u16 update_rate = app_state->game_inst->app_config.update_rate;
+  frame_pacer_create(app_state->target_frame_rate,
+                     update_rate ? update_rate : APPLICATION_DEFAULT_UPDATE_RATE,
+                     &app_state->pacer);
 
   char *mem_usage_str = get_memory_usage_str();
   KINFO(mem_usage_str);
   kfree(mem_usage_str, MEM_USE_PRINT_BUF_SIZE + 1, MEMORY_TAG_STRING);
 
   while (app_state->is_running) {
+    // Nothing is drawn while suspended, so block on the window messages instead of polling them
+    if (app_state->is_suspended) platform_wait_for_messages(APPLICATION_SUSPENDED_WAIT_MS);
+    // Waiting before the messages are pumped keeps input-to-present latency bounded
+    else renderer_wait_for_latency();
     if (!platform_pump_messages()) app_state->is_running = false;
 
     if (!app_state->is_suspended) {
       clock_update(&app_state->clock);
       f64 current_time = app_state->clock.elapsed;
       f64 delta = current_time - app_state->last_time;
-      f64 frame_start_time = platform_get_absolute_time();
 
-      if (!app_state->game_inst->update(app_state->game_inst, (f32) delta)) {
+      texture_system_update();
+
+      // Simulation advances in fixed steps, rendering interpolates between the last two
+      u32 steps = frame_pacer_accumulate(&app_state->pacer, delta);
+      b8 updated = true;
+      for (u32 i = 0; updated && i < steps; ++i) {
+        updated = app_state->game_inst->update(app_state->game_inst, (f32) app_state->pacer.fixed_step);
+        // Each step sees every key transition exactly once, frames without a step keep them pending
+        input_update(app_state->pacer.fixed_step);
+      }
+      if (!updated) {
         KFATAL("Game update failed. Shutting down the engine...");
         app_state->is_running = false;
         break;
       }
-      if (!app_state->game_inst->render(app_state->game_inst, (f32) delta)) {
+      if (!app_state->game_inst->render(app_state->game_inst,
+                                        (f32) delta,
+                                        frame_pacer_interpolation(&app_state->pacer))) {
         KFATAL("Game render failed. Shutting down the engine...");
         app_state->is_running = false;
         break;
@@ -456,23 +543,7 @@ b8 application_run(void) {
       renderer_draw_frame(&packet);
       // TEMPORARY END: geometry test
 
-      f64 frame_end_time = platform_get_absolute_time();
-      f64 frame_elapsed_time = frame_end_time - frame_start_time;
-      running_time += frame_elapsed_time;
-      f64 remaining_time = target_frame_time - frame_elapsed_time;
-      if (remaining_time > 0) {
-        u64 remaining_ms = remaining_time * TIME_MS_IN_S;
-        // Framelimiter turned ON if this is set to TRUE
-        b8 framelimit = false;
-        if (remaining_ms > 0 && framelimit) platform_sleep(remaining_ms - 1);
-        ++frame_count;
-      }
-
-      // Input is the last thing to be updated before the frame ends
-      input_update(delta);
-
-      (void) running_time;  // Unused parameter
-      (void) frame_count;   // Unused parameter
+      frame_pacer_wait(&app_state->pacer);
 
       app_state->last_time = current_time;
     }
@@ -484,6 +555,7 @@ b8 application_run(void) {
   event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
   event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
   event_unregister(EVENT_CODE_RESIZED, 0, application_on_resized);
+  event_unregister(EVENT_CODE_FOCUS_CHANGED, 0, application_on_focus_changed);
   event_unregister(EVENT_CODE_DEBUG0, 0, event_on_debug);  // tmp
 
   input_system_shutdown(app_state->input_system_state);
@@ -492,6 +564,8 @@ b8 application_run(void) {
   texture_system_shutdown(app_state->texture_system_state);
   renderer_system_shutdown(app_state->renderer_system_state);
   resource_system_shutdown(app_state->resource_system_state);
+  job_system_shutdown(app_state->job_system_state);
+  kname_system_shutdown(app_state->kname_system_state);
   platform_system_shutdown(app_state->platform_system_state);
   memory_system_shutdown(app_state->memory_system_state);
   event_system_shutdown(app_state->event_system_state);
@@ -26,6 +26,10 @@
 #include <sys/stat.h>
 #include <filesystem.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 b8 filesystem_exists(const char *path) {
 #ifdef _MSC_VER
   struct _stat buf;
@@ -138,3 +142,16 @@ b8 filesystem_write(file_handle *handle,
   fflush((FILE *) handle->handle);
   return true;
 }
+
+b8 filesystem_rename(const char *old_path, const char *new_path) {
+#ifdef _WIN32
+  // CRT `rename` refuses to overwrite an existing file on Windows
+  if (!MoveFileExA(old_path, new_path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+  if (rename(old_path, new_path) != 0) {
+#endif
+    KERROR("filesystem_rename :: could not rename '%s' to '%s'", old_path, new_path);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <kmath.h>
+#include <platform.h>
+#include <frame_pacer.h>
+
+void frame_pacer_create(f64 target_rate, f64 update_rate, frame_pacer *out_pacer) {
+  out_pacer->fixed_step = 1.0 / update_rate;
+  out_pacer->accumulator = 0;
+  out_pacer->deadline = 0;
+  frame_pacer_set_target_rate(out_pacer, target_rate);
+}
+
+void frame_pacer_set_target_rate(frame_pacer *pacer, f64 target_rate) {
+  pacer->target_frame_time = target_rate > 0 ? 1.0 / target_rate : 0;
+  pacer->deadline = 0;
+}
+
+u32 frame_pacer_accumulate(frame_pacer *pacer, f64 delta) {
+  pacer->accumulator += delta;
+  u32 steps = pacer->accumulator / pacer->fixed_step;
+  // Catching up on a long stall would only make the next frame longer
+  if (steps > FRAME_PACER_MAX_STEPS) {
+    pacer->accumulator = 0;
+    return FRAME_PACER_MAX_STEPS;
+  }
+  pacer->accumulator -= pacer->fixed_step * steps;
+  return steps;
+}
+
+f32 frame_pacer_interpolation(const frame_pacer *pacer) {
+  return pacer->accumulator / pacer->fixed_step;
+}
+
+void frame_pacer_wait(frame_pacer *pacer) {
+  if (!pacer->target_frame_time) return;
+
+  f64 now = platform_get_absolute_time();
+  // Deadlines advance by whole frames so sleep errors do not add up, missing one restarts them
+  pacer->deadline += pacer->target_frame_time;
+  if (pacer->deadline < now) {
+    pacer->deadline = now;
+    return;
+  }
+
+  // The OS scheduler may oversleep, so wake up early and spin the rest
+  f64 sleep_time = pacer->deadline - now - FRAME_PACER_SPIN_TIME;
+  if (sleep_time > 0) platform_sleep(sleep_time * TIME_MS_IN_S);
+  while (platform_get_absolute_time() < pacer->deadline);
+}
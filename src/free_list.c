@@ -40,7 +40,7 @@ typedef struct {
 
 free_list_node *get_node(free_list *list) {
   internal_state *state = list->memory;
-  for (u32 i = 1; i < state->max_entries; ++i) {
+  for (u32 i = 0; i < state->max_entries; ++i) {
     if (state->nodes[i].offset == INVALID_ID) return &state->nodes[i];
   }
   return 0;
@@ -53,11 +53,43 @@ void return_node(free_list *list, free_list_node *node) {
   node->next = 0;
 }
 
+// Carves `size` bytes from the start of `node` (`prev` is the node before it, if any)
+static void take_from_node(free_list *list,
+                           free_list_node *node,
+                           free_list_node *prev,
+                           u32 size,
+                           u32 *out_offset) {
+  internal_state *state = list->memory;
+  *out_offset = node->offset;
+  if (node->size > size) {
+    // Node is larger (move the offset)
+    node->size -= size;
+    node->offset += size;
+    return;
+  }
+  // Exact match: unlink and return the node
+  if (prev) prev->next = node->next;
+  else state->head = node->next;
+  return_node(list, node);
+}
+
 void free_list_create(u32 total_size,
                       u64 *memory_requirements,
                       void *memory,
                       free_list *out_list) {
-  u32 max_entries = (total_size / sizeof(void *));
+  free_list_create_with_max_entries(total_size,
+                                    total_size / sizeof(void *),
+                                    memory_requirements,
+                                    memory,
+                                    out_list);
+}
+
+void free_list_create_with_max_entries(u32 total_size,
+                                       u32 max_entries,
+                                       u64 *memory_requirements,
+                                       void *memory,
+                                       free_list *out_list) {
+  if (!max_entries) max_entries = 1;
   *memory_requirements = sizeof(internal_state) + (max_entries * sizeof(free_list_node));
   if (!memory) return;
 
@@ -72,15 +104,7 @@ void free_list_create(u32 total_size,
   state->total_size = total_size;
   state->max_entries = max_entries;
   state->nodes = (void *) ((u8 *) out_list->memory + sizeof(internal_state));
-  state->head = state->nodes;
-  state->head->offset = 0;
-  state->head->next = 0;
-  state->head->size = total_size;
-
-  for (u32 i = 1; i < state->max_entries; ++i) {
-    state->nodes[i].offset = INVALID_ID;
-    state->nodes[i].size = INVALID_ID;
-  }
+  free_list_clear(out_list);
 }
 
 void free_list_destroy(free_list *list) {
@@ -97,27 +121,8 @@ b8 free_list_alloc(free_list *list, u32 size, u32 *out_offset) {
   free_list_node *node = state->head;
   free_list_node *prev = 0;
   while (node) {
-    if (node->size == size) {
-      // Return the node (exact match)
-      *out_offset = node->offset;
-      free_list_node *n = 0;
-      if (prev) {
-        prev->next = node->next;
-        n = node;
-      }
-      else {
-        // Reassign head and return the previous head node (node is the head)
-        n = state->head;
-        state->head = node->next;
-      }
-      return_node(list, n);
-      return true;
-    }
-    else if (node->size > size) {
-      // Node is larger (move the offset)
-      *out_offset = node->offset;
-      node->size -= size;
-      node->offset += size;
+    if (node->size >= size) {
+      take_from_node(list, node, prev, size, out_offset);
       return true;
     }
     prev = node;
@@ -130,79 +135,109 @@ b8 free_list_alloc(free_list *list, u32 size, u32 *out_offset) {
   return false;
 }
 
-b8 free_list_free(free_list *list, u32 size, u32 offset) {
-  if (!list || !list->memory || !size) return false;
+b8 free_list_alloc_below(free_list *list, u32 size, u32 limit, u32 *out_offset) {
+  if (!list || !list->memory || !out_offset) return false;
 
   internal_state *state = list->memory;
   free_list_node *node = state->head;
   free_list_node *prev = 0;
-  while (node) {
-    if (node->offset == offset) {
-      // Can be joined with this node
-      node->size += size;
-      if (node->next &&
-          node->next->offset == node->offset + node->size) {
-        node->size += node->next->size;
-        free_list_node *n = node->next;
-        node->next = node->next->next;
-        return_node(list, n);
-      }
-      return true;
-    }
-    else if (node->offset > offset) {
-      // Need a new node
-      free_list_node *n = get_node(list);
-      if (!n) {
-        KWARN("free_list_free :: early return due to `get_node` returning NULL");
-        return false;
-      }
-      n->offset = offset;
-      n->size = size;
-      if (prev) {
-        prev->next = n;
-        n->next = node;
-      }
-      else {
-        n->next = node;
-        state->head = n;
-      }
-      // Check next node if it could be merged
-      if (n->next &&
-          n->offset + n->size == n->next->offset) {
-        n->size += n->next->size;
-        free_list_node *merged = n->next;
-        n->next = merged->next;
-        return_node(list, merged);
-      }
-      if (prev &&
-          prev->offset + prev->size == n->offset) {
-        prev->size += n->size;
-        free_list_node *merged = n;
-        prev->next = merged->next;
-        return_node(list, merged);
-      }
+  // Nodes are sorted by offset, so stop at the first one past `limit`
+  while (node && node->offset < limit) {
+    if (node->size >= size) {
+      take_from_node(list, node, prev, size, out_offset);
       return true;
     }
     prev = node;
     node = node->next;
   }
-
-  KWARN("free_list_free :: unable to free block (possible data corruption)");
   return false;
 }
 
+b8 free_list_free(free_list *list, u32 size, u32 offset) {
+  if (!list || !list->memory || !size) return false;
+
+  internal_state *state = list->memory;
+  if ((u64) offset + size > state->total_size) {
+    KWARN("free_list_free :: block (offset: %u B, size: %u B) is out of range", offset, size);
+    return false;
+  }
+
+  // Find the free nodes around the block
+  free_list_node *node = state->head;
+  free_list_node *prev = 0;
+  while (node && node->offset <= offset) {
+    prev = node;
+    node = node->next;
+  }
+  if ((prev && prev->offset + prev->size > offset) ||
+      (node && offset + size > node->offset)) {
+    KWARN("free_list_free :: block overlaps free space (double free or data corruption)");
+    return false;
+  }
+
+  b8 joins_prev = prev && prev->offset + prev->size == offset;
+  b8 joins_next = node && offset + size == node->offset;
+  if (joins_prev) {
+    prev->size += size;
+    if (joins_next) {
+      prev->size += node->size;
+      prev->next = node->next;
+      return_node(list, node);
+    }
+    return true;
+  }
+  if (joins_next) {
+    node->offset = offset;
+    node->size += size;
+    return true;
+  }
+
+  // Need a new node
+  free_list_node *n = get_node(list);
+  if (!n) {
+    KWARN("free_list_free :: early return due to `get_node` returning NULL");
+    return false;
+  }
+  n->offset = offset;
+  n->size = size;
+  n->next = node;
+  if (prev) prev->next = n;
+  else state->head = n;
+  return true;
+}
+
+b8 free_list_resize(free_list *list, u32 new_total_size) {
+  if (!list || !list->memory) return false;
+
+  internal_state *state = list->memory;
+  if (new_total_size < state->total_size) {
+    KERROR("free_list_resize :: shrinking is not supported (%u B -> %u B)", state->total_size, new_total_size);
+    return false;
+  }
+  if (new_total_size == state->total_size) return true;
+
+  u32 old_total_size = state->total_size;
+  state->total_size = new_total_size;
+  if (!free_list_free(list, new_total_size - old_total_size, old_total_size)) {
+    state->total_size = old_total_size;
+    return false;
+  }
+  return true;
+}
+
 void free_list_clear(free_list *list) {
   if (!list || !list->memory) return;
   internal_state *state = list->memory;
   for (u32 i = 1; i < state->max_entries; ++i) {
     state->nodes[i].offset = INVALID_ID;
     state->nodes[i].size = INVALID_ID;
+    state->nodes[i].next = 0;
   }
+  state->head = state->nodes;
   state->head->offset = 0;
   state->head->next = 0;
   state->head->size = state->total_size;
 }
-
 u64 free_list_get_free_space(free_list *list) {
   if (!list || !list->memory) return 0;
   u64 total = 0;
@@ -22,6 +22,7 @@
 #include <logger.h>
 #include <kstring.h>
 #include <kmemory.h>
+#include <handle_pool.h>
 #include <geometry_system.h>
 #include <material_system.h>
 #include <renderer_frontend.h>
@@ -37,6 +38,7 @@ typedef struct {
   geometry fallback_geometry;
   geometry fallback_2D_geometry;
   geometry_ref *registered_geometries;
+  handle_pool geometry_pool;
 } geometry_system_state;
 
 static geometry_system_state *state_ptr = 0;
@@ -71,6 +73,10 @@ b8 create_fallback_geometries(geometry_system_state *state) {
     }};
   u32 index_list[] = {0, 1, 2, 0, 3, 1};
 
+  // Zeroed state memory would otherwise look like a re-upload of slot 0
+  state->fallback_geometry.internal_id = INVALID_ID;
+  state->fallback_2D_geometry.internal_id = INVALID_ID;
+
   if (!renderer_create_geometry(&state->fallback_geometry,
                                 sizeof(vertex_3d),
                                 4,
@@ -134,6 +140,7 @@ b8 create_geometry(geometry_system_state *state, geometry_config cfg, geometry *
                                 cfg.index_size,
                                 cfg.index_count,
                                 cfg.indices)) {
+    handle_pool_release(&state->geometry_pool, handle_pool_from_index(&state->geometry_pool, g->id));
     state->registered_geometries[g->id].ref_count = 0;
     state->registered_geometries[g->id].auto_release = false;
     g->id = INVALID_ID;
@@ -141,8 +148,9 @@ b8 create_geometry(geometry_system_state *state, geometry_config cfg, geometry *
     g->internal_id = INVALID_ID;
     return false;
   }
-  if (kstrlen(cfg.material_name)) {
-    g->material = material_system_get(cfg.material_name);
+  g->name = cfg.name;
+  if (cfg.material_name != KNAME_NONE) {
+    g->material = material_system_get(kname_str(cfg.material_name));
     if (!g->material) g->material = material_system_get_fallback();
   }
   return true;
@@ -155,9 +163,9 @@ void destroy_geometry(geometry_system_state *state, geometry *g) {
   g->internal_id = INVALID_ID;
   g->generation = INVALID_ID;
   g->id = INVALID_ID;
-  kstrrm(g->name);
-  if (g->material && kstrlen(g->material->name)) {
-    material_system_release(g->material->name);
+  g->name = KNAME_NONE;
+  if (g->material && g->material->name != KNAME_NONE) {
+    material_system_release_kname(g->material->name);
     g->material = 0;
   }
 }
@@ -171,13 +179,17 @@ b8 geometry_system_initialize(u64 *memory_requirements,
   }
   u64 struct_requirements = sizeof(geometry_system_state);
   u64 array_requirements = sizeof(geometry_ref) * config.max_geometry_count;
-  *memory_requirements = struct_requirements + array_requirements;
+  u64 pool_requirements = 0;
+  handle_pool_create(config.max_geometry_count, &pool_requirements, 0, 0);
+  *memory_requirements = struct_requirements + array_requirements + pool_requirements;
   if (!state) return true;
 
   state_ptr = state;
   state_ptr->config = config;
-  void *array_block = (void *) ((u64 *) state + struct_requirements);
+  void *array_block = (void *) ((u8 *) state + struct_requirements);
   state_ptr->registered_geometries = array_block;
+  void *pool_block = (void *) ((u8 *) array_block + array_requirements);
+  handle_pool_create(config.max_geometry_count, &pool_requirements, pool_block, &state_ptr->geometry_pool);
 
   for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
     state_ptr->registered_geometries[i].geometry.id =  INVALID_ID;
@@ -194,7 +206,10 @@ b8 geometry_system_initialize(u64 *memory_requirements,
 
 void geometry_system_shutdown(void *state) {
   (void) state;  // Unused parameter
-  // nothing to do here :D
+
+  if (!state_ptr) return;
+  handle_pool_destroy(&state_ptr->geometry_pool);
+  state_ptr = 0;
 }
 
 geometry *geometry_system_get(u32 id) {
@@ -207,24 +222,30 @@ geometry *geometry_system_get(u32 id) {
 }
 
 geometry *geometry_system_get_from_cfg(geometry_config cfg, b8 auto_release) {
-  geometry *g = 0;
-  for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
-    if (state_ptr->registered_geometries[i].geometry.id != INVALID_ID) continue;
-    state_ptr->registered_geometries[i].auto_release = auto_release;
-    state_ptr->registered_geometries[i].ref_count = 1;
-    g = &state_ptr->registered_geometries[i].geometry;
-    g->id = i;
-    break;
-  }
-  if (!g) {
+  return geometry_system_resolve(geometry_system_get_handle_from_cfg(cfg, auto_release));
+}
+
+khandle geometry_system_get_handle_from_cfg(geometry_config cfg, b8 auto_release) {
+  khandle handle;
+  if (!handle_pool_acquire(&state_ptr->geometry_pool, &handle)) {
     KERROR("geometry_system_get_from_cfg :: geometry system is full (adjust config to allow more geometries)");
-    return 0;
+    return KHANDLE_INVALID;
   }
+  geometry_ref *ref = &state_ptr->registered_geometries[handle.index];
+  ref->auto_release = auto_release;
+  ref->ref_count = 1;
+  geometry *g = &ref->geometry;
+  g->id = handle.index;
   if (!create_geometry(state_ptr, cfg, g)) {
     KERROR("geometry_system_get_from_cfg :: failed to create geometry");
-    return 0;
+    return KHANDLE_INVALID;
   }
-  return g;
+  return handle;
+}
+
+geometry *geometry_system_resolve(khandle handle) {
+  if (!state_ptr || !handle_pool_is_valid(&state_ptr->geometry_pool, handle)) return 0;
+  return &state_ptr->registered_geometries[handle.index].geometry;
 }
 
 geometry *geometry_system_get_fallback(void) {
@@ -251,12 +272,23 @@ void geometry_system_release(geometry *geometry) {
   }
   if (ref->ref_count) --ref->ref_count;
   if (!ref->ref_count && ref->auto_release) {
+    handle_pool_release(&state_ptr->geometry_pool,
+                        handle_pool_from_index(&state_ptr->geometry_pool, ref->geometry.id));
     destroy_geometry(state_ptr, &ref->geometry);
     ref->ref_count = 0;
     ref->auto_release = false;
   }
 }
 
+void geometry_system_release_handle(khandle handle) {
+  geometry *g = geometry_system_resolve(handle);
+  if (!g) {
+    KWARN("geometry_system_release_handle :: stale or invalid geometry handle (nothing was done)");
+    return;
+  }
+  geometry_system_release(g);
+}
+
 geometry_config geometry_system_gen_plane_cfg(f32 width,
                                               f32 height,
                                               u32 x_segment_count,
@@ -351,14 +383,12 @@ geometry_config geometry_system_gen_plane_cfg(f32 width,
   }
 
   // Geometry name
-  if (name && kstrlen(name)) kstrncp(cfg.name, name, GEOMETRY_NAME_MAX_LEN);
-  else kstrncp(cfg.name, FALLBACK_GEOMETRY_NAME, GEOMETRY_NAME_MAX_LEN);
+  if (name && kstrlen(name)) cfg.name = kname_create(name);
+  else cfg.name = KNAME_FALLBACK;
 
   // Material name
-  if (material_name && kstrlen(material_name)) kstrncp(cfg.material_name,
-                                                       material_name,
-                                                       MATERIAL_NAME_MAX_LEN);
-  else kstrncp(cfg.material_name, FALLBACK_MATERIAL_NAME, MATERIAL_NAME_MAX_LEN);
+  if (material_name && kstrlen(material_name)) cfg.material_name = kname_create(material_name);
+  else cfg.material_name = KNAME_FALLBACK;
 
   return cfg;
 }
@@ -0,0 +1,107 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <kmemory.h>
+#include <handle_pool.h>
+
+// `next_free` value of acquired slots (free slots hold the next free index)
+#define HANDLE_POOL_SLOT_USED (INVALID_ID - 1)
+
+void handle_pool_create(u32 capacity,
+                        u64 *memory_requirements,
+                        void *memory,
+                        handle_pool *out_pool) {
+  *memory_requirements = sizeof(u32) * capacity * 2;
+  if (!memory) return;
+
+  if (!capacity || capacity >= HANDLE_POOL_SLOT_USED) {
+    KERROR("handle_pool_create :: `capacity` must be in (0, %u)", HANDLE_POOL_SLOT_USED);
+    return;
+  }
+
+  out_pool->capacity = capacity;
+  out_pool->next_free = memory;
+  out_pool->generations = (void *) ((u8 *) memory + (sizeof(u32) * capacity));
+  kzero_memory(out_pool->generations, sizeof(u32) * capacity);
+  handle_pool_clear(out_pool);
+}
+
+void handle_pool_destroy(handle_pool *pool) {
+  if (!pool) return;
+  kzero_memory(pool, sizeof(handle_pool));
+}
+
+void handle_pool_clear(handle_pool *pool) {
+  if (!pool || !pool->next_free) return;
+  // Lowest indices on top of the stack, so slots fill up in order
+  for (u32 i = 0; i < pool->capacity; ++i) {
+    if (pool->next_free[i] == HANDLE_POOL_SLOT_USED) ++pool->generations[i];
+    pool->next_free[i] = i + 1 < pool->capacity ? i + 1 : INVALID_ID;
+  }
+  pool->free_head = 0;
+  pool->count = 0;
+}
+
+b8 handle_pool_acquire(handle_pool *pool, khandle *out_handle) {
+  if (!pool || !pool->next_free || pool->free_head == INVALID_ID) {
+    *out_handle = KHANDLE_INVALID;
+    return false;
+  }
+  u32 index = pool->free_head;
+  pool->free_head = pool->next_free[index];
+  pool->next_free[index] = HANDLE_POOL_SLOT_USED;
+  ++pool->count;
+  *out_handle = (khandle) {
+    .index = index,
+    .generation = pool->generations[index]
+  };
+  return true;
+}
+
+b8 handle_pool_release(handle_pool *pool, khandle handle) {
+  if (!handle_pool_is_valid(pool, handle)) {
+    KWARN("handle_pool_release :: stale or invalid handle (%u, %u)", handle.index, handle.generation);
+    return false;
+  }
+  // Bumping the generation invalidates every outstanding copy of `handle`
+  ++pool->generations[handle.index];
+  pool->next_free[handle.index] = pool->free_head;
+  pool->free_head = handle.index;
+  --pool->count;
+  return true;
+}
+
+b8 handle_pool_is_valid(const handle_pool *pool, khandle handle) {
+  return pool && handle.index < pool->capacity &&
+    pool->next_free[handle.index] == HANDLE_POOL_SLOT_USED &&
+    pool->generations[handle.index] == handle.generation;
+}
+
+khandle handle_pool_from_index(const handle_pool *pool, u32 index) {
+  if (!pool || index >= pool->capacity || pool->next_free[index] != HANDLE_POOL_SLOT_USED) {
+    return KHANDLE_INVALID;
+  }
+  return (khandle) {
+    .index = index,
+    .generation = pool->generations[index]
+  };
+}
@@ -19,40 +19,161 @@
  */
 
 
+#include <khash.h>
 #include <logger.h>
 #include <kmemory.h>
+#include <kstring.h>
 #include <hash_table.h>
 
-#define HASH_MULT 97
+// Every slot stores the full key hash and the key itself inline, followed by
+// the value. `distance` is the probe length + 1 (0 marks an empty slot).
+typedef struct {
+  u64 hash;
+  u32 distance;
+  u32 key_length;
+  char key[HASH_TABLE_KEY_MAX_LEN];
+} hash_table_slot;
 
-u64 hash(const char *name, u32 element_count) {
-  u64 hash = 0;
-  for (const u8 *us = (const u8 *) name; *us; ++us) {
-    hash = hash * HASH_MULT + *us;
+static u64 hash(const char *name, u32 *out_length) {
+  *out_length = kstrlen(name);
+  return khash(name, *out_length, KHASH_DEFAULT_SEED);
+}
+
+static u32 next_power_of_two(u64 n) {
+  u32 p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+static hash_table_slot *get_slot(hash_table *table, u32 index) {
+  return (hash_table_slot *) ((u8 *) table->memory + (table->slot_size * index));
+}
+
+static void *get_slot_value(hash_table_slot *slot) {
+  return (u8 *) slot + sizeof(hash_table_slot);
+}
+
+static void *get_default_value(hash_table *table) {
+  return (u8 *) table->memory + (table->slot_size * (table->capacity + 2));
+}
+
+static hash_table_slot *find_slot(hash_table *table, const char *name) {
+  u32 length = 0;
+  u64 h = hash(name, &length);
+  u32 mask = table->capacity - 1;
+  u32 index = h & mask;
+  for (u32 distance = 1; distance <= table->capacity; ++distance) {
+    hash_table_slot *slot = get_slot(table, index);
+    // Robin Hood invariant: the key would have displaced any poorer slot
+    if (slot->distance < distance) return 0;
+    if (slot->hash == h &&
+        slot->key_length == length &&
+        kstrcmp(slot->key, name)) return slot;
+    index = (index + 1) & mask;
   }
-  hash %= element_count;
-  return hash;
+  return 0;
+}
+
+static b8 insert(hash_table *table, const char *name, const void *value) {
+  hash_table_slot *existing = find_slot(table, name);
+  if (existing) {
+    kcopy_memory(get_slot_value(existing), value, table->element_size);
+    return true;
+  }
+
+  u32 length = 0;
+  u64 h = hash(name, &length);
+  if (length >= HASH_TABLE_KEY_MAX_LEN) {
+    KERROR("hash_table :: key '%s' exceeds `HASH_TABLE_KEY_MAX_LEN` (%i)", name, HASH_TABLE_KEY_MAX_LEN);
+    return false;
+  }
+  if (table->length >= table->element_count) {
+    KERROR("hash_table :: table is full (%u entries)", table->element_count);
+    return false;
+  }
+
+  // Two scratch slots live right after the table to carry displaced entries
+  hash_table_slot *carry = get_slot(table, table->capacity);
+  hash_table_slot *tmp = get_slot(table, table->capacity + 1);
+  kzero_memory(carry, table->slot_size);
+  carry->hash = h;
+  carry->distance = 1;
+  carry->key_length = length;
+  kcopy_memory(carry->key, name, length + 1);
+  kcopy_memory(get_slot_value(carry), value, table->element_size);
+
+  u32 mask = table->capacity - 1;
+  u32 index = h & mask;
+  for (;;) {
+    hash_table_slot *slot = get_slot(table, index);
+    if (!slot->distance) {
+      kcopy_memory(slot, carry, table->slot_size);
+      ++table->length;
+      return true;
+    }
+    // Robin Hood: take the slot from entries closer to their home position
+    if (slot->distance < carry->distance) {
+      kcopy_memory(tmp, slot, table->slot_size);
+      kcopy_memory(slot, carry, table->slot_size);
+      kcopy_memory(carry, tmp, table->slot_size);
+    }
+    index = (index + 1) & mask;
+    ++carry->distance;
+  }
+}
+
+static b8 remove_slot(hash_table *table, hash_table_slot *slot) {
+  if (!slot) return false;
+  u32 mask = table->capacity - 1;
+  u32 index = ((u8 *) slot - (u8 *) table->memory) / table->slot_size;
+  // Backward shift deletion (no tombstones)
+  for (;;) {
+    u32 next_index = (index + 1) & mask;
+    hash_table_slot *next = get_slot(table, next_index);
+    if (next->distance <= 1) break;
+    kcopy_memory(get_slot(table, index), next, table->slot_size);
+    --get_slot(table, index)->distance;
+    index = next_index;
+  }
+  kzero_memory(get_slot(table, index), table->slot_size);
+  --table->length;
+  return true;
 }
 
 void hash_table_create(u64 element_size,
                        u32 element_count,
+                       u64 *memory_requirements,
                        void *memory,
                        b8 is_pointer_type,
                        hash_table *out_hash_table) {
-  if (!memory || !out_hash_table) {
-    KERROR("hash_table_create :: `memory` and `out_hash_table` are required");
+  if (!memory_requirements) {
+    KERROR("hash_table_create :: `memory_requirements` is required");
     return;
   }
   if (!element_count || !element_size) {
     KERROR("hash_table_create :: `element_count` and `element_size` must be > 0");
     return;
   }
-  // TODO: allocate the memory here
+  // Keep the load factor under HASH_TABLE_MAX_LOAD_FACTOR even when full
+  u32 capacity = next_power_of_two(((u64) element_count * 100 + HASH_TABLE_MAX_LOAD_FACTOR - 1) / HASH_TABLE_MAX_LOAD_FACTOR);
+  u64 value_size = (element_size + 7) & ~7ULL;
+  u64 slot_size = sizeof(hash_table_slot) + value_size;
+  // Slots + 2 scratch slots + default value
+  *memory_requirements = (slot_size * (capacity + 2)) + value_size;
+  if (!memory) return;
+  if (!out_hash_table) {
+    KERROR("hash_table_create :: `out_hash_table` is required");
+    return;
+  }
+
   out_hash_table->memory = memory;
   out_hash_table->element_count = element_count;
   out_hash_table->element_size = element_size;
+  out_hash_table->capacity = capacity;
+  out_hash_table->length = 0;
+  out_hash_table->slot_size = slot_size;
   out_hash_table->is_pointer_type = is_pointer_type;
-  kzero_memory(out_hash_table->memory, element_size * element_count);
+  kzero_memory(out_hash_table->memory, *memory_requirements);
 }
 
 void hash_table_destroy(hash_table *table) {
@@ -70,11 +191,7 @@ b8 hash_table_set(hash_table *table,
     KERROR("`hash_table_set` called with a pointer-type hash table (use `hash_table_set_ptr` instead)");
     return false;
   }
-  u64 h = hash(name, table->element_count);
-  kcopy_memory((void *) ((u8 *) table->memory + (table->element_size * h)),
-               value,
-               table->element_size);
-  return true;
+  return insert(table, name, value);
 }
 
 b8 hash_table_set_ptr(hash_table *table,
@@ -88,9 +205,12 @@ b8 hash_table_set_ptr(hash_table *table,
     KERROR("`hash_table_set_ptr` called without a pointer-type hash table (use `hash_table_set` instead)");
     return false;
   }
-  u64 h = hash(name, table->element_count);
-  ((void **) table->memory)[h] = value ? *value : 0;
-  return true;
+  // Setting a null pointer unsets the entry
+  if (!value || !*value) {
+    remove_slot(table, find_slot(table, name));
+    return true;
+  }
+  return insert(table, name, value);
 }
 
 b8 hash_table_get(hash_table *table,
@@ -104,11 +224,12 @@ b8 hash_table_get(hash_table *table,
     KERROR("`hash_table_get` called with a pointer-type hash table (use `hash_table_get_ptr` instead)");
     return false;
   }
-  u64 h = hash(name, table->element_count);
+  hash_table_slot *slot = find_slot(table, name);
+  // Missing keys yield the default value (see `hash_table_fill`)
   kcopy_memory(out_value,
-               (void *) ((u8 *) table->memory + (table->element_size * h)),
+               slot ? get_slot_value(slot) : get_default_value(table),
                table->element_size);
-  return true;
+  return slot != 0;
 }
 
 b8 hash_table_get_ptr(hash_table *table,
@@ -122,11 +243,20 @@ b8 hash_table_get_ptr(hash_table *table,
     KERROR("`hash_table_get_ptr` called without a pointer-type hash table (use `hash_table_get` instead)");
     return false;
   }
-  u64 h = hash(name, table->element_count);
-  *out_value = ((void **) table->memory)[h];
+  hash_table_slot *slot = find_slot(table, name);
+  *out_value = slot ? *(void **) get_slot_value(slot) : 0;
   return *out_value != 0;
 }
 
+b8 hash_table_remove(hash_table *table,
+                     const char *name) {
+  if (!table || !name) {
+    KERROR("hash_table_remove :: `table` and `name` are required");
+    return false;
+  }
+  return remove_slot(table, find_slot(table, name));
+}
+
 b8 hash_table_fill(hash_table *table,
                    void *value) {
   if (!table || !value) {
@@ -137,10 +267,7 @@ b8 hash_table_fill(hash_table *table,
     KERROR("`hash_table_fill` is not compatible with a pointer-type hash table");
     return false;
   }
-  for (u32 i = 0; i < table->element_count; ++i) {
-    kcopy_memory((void *) ((u8 *) table->memory + (table->element_size * i)),
-                 value,
-                 table->element_size);
-  }
+  // Sets the value returned by `hash_table_get` for keys not present
+  kcopy_memory(get_default_value(table), value, table->element_size);
   return true;
 }
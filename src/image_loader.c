@@ -36,7 +36,8 @@ b8 image_loader_load(resource_loader *self, const char *name, resource *out_reso
 
   char *format_str = "%s/%s/%s%s";
   const i32 required_channel_count = 4;
-  stbi_set_flip_vertically_on_load(true);
+  // Per-thread flag, as images may be decoded on job system workers
+  stbi_set_flip_vertically_on_load_thread(true);
   char full_file_path[FILE_PATH_SIZE];
 
   // TODO: support other image format/extensions
@@ -0,0 +1,324 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <katomic.h>
+#include <kmemory.h>
+#include <kstring.h>
+#include <platform.h>
+#include <job_system.h>
+
+#define JOB_SYSTEM_CACHE_LINE 64
+#define JOB_SYSTEM_DEQUE_MASK (JOB_SYSTEM_DEQUE_CAPACITY - 1)
+#define JOB_SYSTEM_IDLE_SPINS 64  // yields before an idle worker parks
+
+STATIC_ASSERT(!(JOB_SYSTEM_DEQUE_CAPACITY & JOB_SYSTEM_DEQUE_MASK), "ERROR: JOB_SYSTEM_DEQUE_CAPACITY must be a power of two");
+
+// Thieves may read a slot the owner is overwriting (their CAS then fails), so slots are atomic
+typedef struct {
+  _Atomic(job_fn) fn;
+  katomic_ptr data;
+  _Atomic(job_counter *) counter;
+} job_slot;
+
+// Chase-Lev deque: the owner pushes/pops at `bottom`, thieves take from `top`
+typedef struct {
+  katomic_i64 top;
+  u8 top_padding[JOB_SYSTEM_CACHE_LINE - sizeof(katomic_i64)];
+  katomic_i64 bottom;
+  u8 bottom_padding[JOB_SYSTEM_CACHE_LINE - sizeof(katomic_i64)];
+  job_slot *buffer;
+  platform_thread thread;
+  u32 index;
+  u32 rng_state;
+} job_worker;
+
+typedef struct {
+  u32 worker_count;
+  katomic_b8 running;
+  katomic_i32 sleeping_count;
+  platform_semaphore wake_semaphore;
+  job_worker *workers;
+} job_system_state;
+
+typedef struct {
+  job_range_fn fn;
+  void *data;
+  u64 count;
+  u64 batch_size;
+  katomic_u64 next;
+} parallel_for_context;
+
+static job_system_state *state_ptr = 0;
+// Index of the worker owning the calling thread (-1 for non-worker threads)
+static KTHREAD_LOCAL i32 worker_index = -1;
+
+static void write_slot(job_slot *slot, job j) {
+  katomic_store_explicit(&slot->fn, j.fn, KATOMIC_RELAXED);
+  katomic_store_explicit(&slot->data, j.data, KATOMIC_RELAXED);
+  katomic_store_explicit(&slot->counter, j.counter, KATOMIC_RELAXED);
+}
+
+static job read_slot(job_slot *slot) {
+  return (job) {
+    .fn = katomic_load_explicit(&slot->fn, KATOMIC_RELAXED),
+    .data = katomic_load_explicit(&slot->data, KATOMIC_RELAXED),
+    .counter = katomic_load_explicit(&slot->counter, KATOMIC_RELAXED)
+  };
+}
+
+static b8 deque_push(job_worker *w, job j) {
+  i64 b = katomic_load_explicit(&w->bottom, KATOMIC_RELAXED);
+  i64 t = katomic_load_explicit(&w->top, KATOMIC_ACQUIRE);
+  if (b - t >= JOB_SYSTEM_DEQUE_CAPACITY) return false;
+  write_slot(&w->buffer[b & JOB_SYSTEM_DEQUE_MASK], j);
+  katomic_store_explicit(&w->bottom, b + 1, KATOMIC_RELEASE);
+  return true;
+}
+
+static b8 deque_pop(job_worker *w, job *out_job) {
+  i64 b = katomic_load_explicit(&w->bottom, KATOMIC_RELAXED) - 1;
+  katomic_store_explicit(&w->bottom, b, KATOMIC_RELAXED);
+  katomic_fence();
+  i64 t = katomic_load_explicit(&w->top, KATOMIC_RELAXED);
+  if (t > b) {
+    katomic_store_explicit(&w->bottom, b + 1, KATOMIC_RELAXED);
+    return false;
+  }
+  *out_job = read_slot(&w->buffer[b & JOB_SYSTEM_DEQUE_MASK]);
+  if (t != b) return true;
+  // Last job: race the thieves for it
+  b8 won = katomic_cas_explicit(&w->top, &t, t + 1, KATOMIC_SEQ_CST, KATOMIC_RELAXED);
+  katomic_store_explicit(&w->bottom, b + 1, KATOMIC_RELAXED);
+  return won;
+}
+
+static b8 deque_steal(job_worker *w, job *out_job) {
+  i64 t = katomic_load_explicit(&w->top, KATOMIC_ACQUIRE);
+  katomic_fence();
+  i64 b = katomic_load_explicit(&w->bottom, KATOMIC_ACQUIRE);
+  if (t >= b) return false;
+  job j = read_slot(&w->buffer[t & JOB_SYSTEM_DEQUE_MASK]);
+  if (!katomic_cas_explicit(&w->top, &t, t + 1, KATOMIC_SEQ_CST, KATOMIC_RELAXED)) {
+    return false;
+  }
+  *out_job = j;
+  return true;
+}
+
+static b8 find_job(job_worker *self, job *out_job) {
+  if (deque_pop(self, out_job)) return true;
+  // Start stealing from a random victim so thieves do not pile onto worker 0
+  self->rng_state ^= self->rng_state << 13;
+  self->rng_state ^= self->rng_state >> 17;
+  self->rng_state ^= self->rng_state << 5;
+  u32 count = state_ptr->worker_count;
+  u32 start = self->rng_state % count;
+  for (u32 i = 0; i < count; ++i) {
+    u32 victim = (start + i) % count;
+    if (victim != self->index && deque_steal(&state_ptr->workers[victim], out_job)) return true;
+  }
+  return false;
+}
+
+static void run_job(job j) {
+  j.fn(j.data);
+  if (j.counter) katomic_fetch_sub_explicit(&j.counter->pending, 1, KATOMIC_RELEASE);
+}
+
+static u32 job_worker_run(void *params) {
+  job_worker *self = params;
+  worker_index = self->index;
+  char name[16];
+  kstrfmt(name, "wge_job_%u", self->index);
+  platform_thread_set_name(name);
+
+  u32 idle_spins = 0;
+  job j;
+  while (katomic_load_explicit(&state_ptr->running, KATOMIC_ACQUIRE)) {
+    if (find_job(self, &j)) {
+      run_job(j);
+      idle_spins = 0;
+      continue;
+    }
+    if (++idle_spins < JOB_SYSTEM_IDLE_SPINS) {
+      platform_thread_yield();
+      continue;
+    }
+    // Announce before the last look, so a concurrent submit either sees us or we see its job
+    katomic_fetch_add(&state_ptr->sleeping_count, 1);
+    katomic_fence();
+    if (find_job(self, &j)) {
+      katomic_fetch_sub(&state_ptr->sleeping_count, 1);
+      run_job(j);
+    }
+    else {
+      platform_semaphore_wait(&state_ptr->wake_semaphore);
+      katomic_fetch_sub(&state_ptr->sleeping_count, 1);
+    }
+    idle_spins = 0;
+  }
+
+  worker_index = -1;
+  return 0;
+}
+
+static u32 resolve_worker_count(job_system_config config) {
+  u32 count = config.worker_count ? config.worker_count : platform_get_processor_count();
+  return KCLAMP(count, 1, JOB_SYSTEM_MAX_WORKERS);
+}
+
+b8 job_system_initialize(u64 *memory_requirements,
+                         void *state,
+                         job_system_config config) {
+  u32 worker_count = resolve_worker_count(config);
+  u64 struct_requirements = sizeof(job_system_state);
+  u64 workers_requirements = sizeof(job_worker) * worker_count;
+  u64 buffers_requirements = sizeof(job_slot) * JOB_SYSTEM_DEQUE_CAPACITY * worker_count;
+  *memory_requirements = struct_requirements + workers_requirements + buffers_requirements;
+  if (!state) return true;
+
+  kzero_memory(state, *memory_requirements);
+  state_ptr = state;
+  state_ptr->worker_count = worker_count;
+  state_ptr->workers = (void *) ((u8 *) state + struct_requirements);
+  job_slot *buffers = (void *) ((u8 *) state_ptr->workers + workers_requirements);
+  if (!platform_semaphore_create(0, &state_ptr->wake_semaphore)) {
+    KFATAL("job_system_initialize :: failed to create the worker wake semaphore");
+    state_ptr = 0;
+    return false;
+  }
+  for (u32 i = 0; i < worker_count; ++i) {
+    state_ptr->workers[i].buffer = &buffers[i * JOB_SYSTEM_DEQUE_CAPACITY];
+    state_ptr->workers[i].index = i;
+    state_ptr->workers[i].rng_state = 0x9E3779B9u * (i + 1);
+  }
+
+  // The initializing thread is worker 0 and only runs jobs while waiting
+  worker_index = 0;
+  katomic_store(&state_ptr->running, true);
+  for (u32 i = 1; i < worker_count; ++i) {
+    if (!platform_thread_create(job_worker_run, &state_ptr->workers[i], &state_ptr->workers[i].thread)) {
+      KERROR("job_system_initialize :: failed to start worker %u (continuing with %u)", i, i);
+      state_ptr->worker_count = i;
+      break;
+    }
+  }
+  KINFO("Job system initialized (%u workers)", state_ptr->worker_count);
+  return true;
+}
+
+void job_system_shutdown(void *state) {
+  (void) state;  // Unused parameter
+
+  if (!state_ptr) return;
+  katomic_store_explicit(&state_ptr->running, false, KATOMIC_RELEASE);
+  for (u32 i = 1; i < state_ptr->worker_count; ++i) {
+    platform_semaphore_signal(&state_ptr->wake_semaphore);
+  }
+  for (u32 i = 1; i < state_ptr->worker_count; ++i) {
+    platform_thread_join(&state_ptr->workers[i].thread);
+  }
+  // Nothing is stealing anymore: finish whatever was left behind
+  job j;
+  while (find_job(&state_ptr->workers[0], &j)) run_job(j);
+
+  platform_semaphore_destroy(&state_ptr->wake_semaphore);
+  worker_index = -1;
+  state_ptr = 0;
+}
+
+u32 job_system_worker_count(void) {
+  return state_ptr ? state_ptr->worker_count : 1;
+}
+
+void job_system_submit(job_fn fn, void *data, job_counter *counter) {
+  if (!fn) {
+    KERROR("job_system_submit :: `fn` must not be null");
+    return;
+  }
+  job j = {
+    .fn = fn,
+    .data = data,
+    .counter = counter
+  };
+  if (counter) katomic_fetch_add_explicit(&counter->pending, 1, KATOMIC_RELAXED);
+
+  // Threads without a deque (or with a full one) run the job inline
+  if (!state_ptr || worker_index < 0 || !deque_push(&state_ptr->workers[worker_index], j)) {
+    run_job(j);
+    return;
+  }
+  katomic_fence();
+  if (katomic_load_explicit(&state_ptr->sleeping_count, KATOMIC_RELAXED) > 0) {
+    platform_semaphore_signal(&state_ptr->wake_semaphore);
+  }
+}
+
+void job_system_wait(job_counter *counter) {
+  if (!counter) return;
+  job j;
+  // Help out instead of blocking, so waiting inside a job cannot deadlock the pool
+  while (katomic_load_explicit(&counter->pending, KATOMIC_ACQUIRE) > 0) {
+    if (state_ptr && worker_index >= 0 && find_job(&state_ptr->workers[worker_index], &j)) run_job(j);
+    else platform_thread_yield();
+  }
+}
+
+b8 job_system_try_run(void) {
+  job j;
+  if (!state_ptr || worker_index < 0 || !find_job(&state_ptr->workers[worker_index], &j)) return false;
+  run_job(j);
+  return true;
+}
+
+static void parallel_for_job(void *data) {
+  parallel_for_context *ctx = data;
+  for (;;) {
+    u64 start = katomic_fetch_add_explicit(&ctx->next, ctx->batch_size, KATOMIC_RELAXED);
+    if (start >= ctx->count) return;
+    u64 end = start + ctx->batch_size;
+    if (end > ctx->count) end = ctx->count;
+    ctx->fn(start, end, ctx->data);
+  }
+}
+
+void job_system_parallel_for(u32 count,
+                             u32 batch_size,
+                             job_range_fn fn,
+                             void *data) {
+  if (!count || !fn) return;
+  parallel_for_context ctx = {
+    .fn = fn,
+    .data = data,
+    .count = count,
+    .batch_size = batch_size ? batch_size : 1
+  };
+  katomic_init(&ctx.next, 0);
+  // Batches are claimed dynamically, so one job per worker is enough to balance the load
+  u64 batch_count = (ctx.count + ctx.batch_size - 1) / ctx.batch_size;
+  u32 worker_count = job_system_worker_count();
+  u32 helper_count = (batch_count < worker_count ? batch_count : worker_count) - 1;
+  job_counter counter = {0};
+  for (u32 i = 0; i < helper_count; ++i) job_system_submit(parallel_for_job, &ctx, &counter);
+  parallel_for_job(&ctx);
+  job_system_wait(&counter);
+}
@@ -0,0 +1,163 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <khash.h>
+#include <kstring.h>
+
+// Word-at-a-time hash (wyhash final4 construction): 48 byte blocks are mixed
+// through three independent 64x64->128 bit multiply lanes.
+
+__extension__ typedef unsigned __int128 u128;
+
+static const u64 khash_secret[4] = {
+  0x2d358dccaa6c78a5ULL,
+  0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL,
+  0x4d5a2da51de1aa47ULL
+};
+
+KINLINE void khash_mum(u64 *a, u64 *b) {
+  u128 r = (u128) *a * *b;
+  *a = (u64) r;
+  *b = (u64) (r >> 64);
+}
+
+KINLINE u64 khash_mix(u64 a, u64 b) {
+  khash_mum(&a, &b);
+  return a ^ b;
+}
+
+KINLINE u64 khash_read8(const u8 *p) {
+  u64 v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+KINLINE u64 khash_read4(const u8 *p) {
+  u32 v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+KINLINE u64 khash_read3(const u8 *p, u64 k) {
+  return (((u64) p[0]) << 16) | (((u64) p[k >> 1]) << 8) | p[k - 1];
+}
+
+KINLINE u64 khash_seed(u64 seed) {
+  return seed ^ khash_mix(seed ^ khash_secret[0], khash_secret[1]);
+}
+
+KINLINE void khash_block(const u8 *p, u64 *seed, u64 *see1, u64 *see2) {
+  *seed = khash_mix(khash_read8(p) ^ khash_secret[1], khash_read8(p + 8) ^ *seed);
+  *see1 = khash_mix(khash_read8(p + 16) ^ khash_secret[2], khash_read8(p + 24) ^ *see1);
+  *see2 = khash_mix(khash_read8(p + 32) ^ khash_secret[3], khash_read8(p + 40) ^ *see2);
+}
+
+// `p` points to the last `i` (<= KHASH_BLOCK_SIZE) bytes of the input. When
+// the whole input is longer than 16 bytes, the 16 bytes before `p` must be
+// readable as well (they are read when less than 16 bytes remain).
+KINLINE u64 khash_tail(const u8 *p, u64 i, u64 length, u64 seed) {
+  u64 a;
+  u64 b;
+  if (length <= 16) {
+    if (length >= 4) {
+      a = (khash_read4(p) << 32) | khash_read4(p + ((length >> 3) << 2));
+      b = (khash_read4(p + length - 4) << 32) | khash_read4(p + length - 4 - ((length >> 3) << 2));
+    }
+    else if (length > 0) {
+      a = khash_read3(p, length);
+      b = 0;
+    }
+    else a = b = 0;
+  }
+  else {
+    while (i > 16) {
+      seed = khash_mix(khash_read8(p) ^ khash_secret[1], khash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = khash_read8(p + i - 16);
+    b = khash_read8(p + i - 8);
+  }
+  a ^= khash_secret[1];
+  b ^= seed;
+  khash_mum(&a, &b);
+  return khash_mix(a ^ khash_secret[0] ^ length, b ^ khash_secret[1]);
+}
+
+u64 khash(const void *data, u64 length, u64 seed) {
+  const u8 *p = (const u8 *) data;
+  u64 i = length;
+  seed = khash_seed(seed);
+  if (i > KHASH_BLOCK_SIZE) {
+    u64 see1 = seed;
+    u64 see2 = seed;
+    do {
+      khash_block(p, &seed, &see1, &see2);
+      p += KHASH_BLOCK_SIZE;
+      i -= KHASH_BLOCK_SIZE;
+    } while (i > KHASH_BLOCK_SIZE);
+    seed ^= see1 ^ see2;
+  }
+  return khash_tail(p, i, length, seed);
+}
+
+u64 khash_str(const char *str) {
+  return khash(str, kstrlen(str), KHASH_DEFAULT_SEED);
+}
+
+void khash_begin(khash_state *state, u64 seed) {
+  state->seed = khash_seed(seed);
+  state->see1 = state->seed;
+  state->see2 = state->seed;
+  state->length = 0;
+  state->buffered = 0;
+}
+
+void khash_update(khash_state *state, const void *data, u64 length) {
+  const u8 *p = (const u8 *) data;
+  u8 *pending = state->buffer + KHASH_HISTORY_SIZE;
+  state->length += length;
+  while (length) {
+    // A block is only consumed once more input follows it (mirrors `khash`)
+    if (state->buffered == KHASH_BLOCK_SIZE) {
+      khash_block(pending, &state->seed, &state->see1, &state->see2);
+      __builtin_memcpy(state->buffer,
+                       pending + KHASH_BLOCK_SIZE - KHASH_HISTORY_SIZE,
+                       KHASH_HISTORY_SIZE);
+      state->buffered = 0;
+    }
+    u64 n = KHASH_BLOCK_SIZE - state->buffered;
+    if (n > length) n = length;
+    __builtin_memcpy(pending + state->buffered, p, n);
+    state->buffered += n;
+    p += n;
+    length -= n;
+  }
+}
+
+u64 khash_end(khash_state *state) {
+  u64 seed = state->seed;
+  if (state->length > KHASH_BLOCK_SIZE) seed ^= state->see1 ^ state->see2;
+  return khash_tail(state->buffer + KHASH_HISTORY_SIZE,
+                    state->buffered,
+                    state->length,
+                    seed);
+}
@@ -0,0 +1,56 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <kimage.h>
+
+u32 kimage_mip_count(u32 width, u32 height) {
+  u32 largest = width > height ? width : height;
+  u32 count = 1;
+  while (largest > 1) {
+    largest >>= 1;
+    ++count;
+  }
+  return count;
+}
+
+u32 kimage_mip_extent(u32 extent, u32 level) {
+  extent >>= level;
+  return extent ? extent : 1;
+}
+
+void kimage_downsample(const u8 *src, u32 width, u32 height, u8 channel_count, u8 *dst) {
+  u32 dst_width = kimage_mip_extent(width, 1);
+  u32 dst_height = kimage_mip_extent(height, 1);
+  // Writes never pass the texels still to be read, so in place filtering is safe
+  for (u32 y = 0; y < dst_height; ++y) {
+    const u8 *row0 = src + (u64) (y * 2) * width * channel_count;
+    const u8 *row1 = (y * 2 + 1 < height) ? row0 + (u64) width * channel_count : row0;
+    u8 *out = dst + (u64) y * dst_width * channel_count;
+    for (u32 x = 0; x < dst_width; ++x) {
+      u32 x0 = x * 2 * channel_count;
+      u32 x1 = (x * 2 + 1 < width) ? x0 + channel_count : x0;
+      for (u8 c = 0; c < channel_count; ++c) {
+        u32 sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+        out[x * channel_count + c] = (u8) ((sum + 2) >> 2);
+      }
+    }
+  }
+}
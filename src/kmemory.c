@@ -22,17 +22,19 @@
 #include <stdio.h>
 #include <kstring.h>
 #include <logger.h>
+#include <katomic.h>
 #include <kmemory.h>
 #include <platform.h>
 
+// Atomic, as worker threads (de)allocate too
 typedef struct {
-  u64 total_allocated;
-  u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+  katomic_u64 total_allocated;
+  katomic_u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
 } memory_stats;
 
 typedef struct {
   memory_stats stats;
-  u64 alloc_count;
+  katomic_u64 alloc_count;
 } memory_system_state;
 
 static memory_system_state *state_ptr;
@@ -62,7 +64,7 @@ void memory_system_initialize(u64 *memory_requirements, void *state) {
   *memory_requirements = sizeof(memory_system_state);
   if (!state) return;
   state_ptr = state;
-  state_ptr->alloc_count = 0;
+  katomic_init(&state_ptr->alloc_count, 0);
 
   platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
 }
@@ -78,9 +80,9 @@ void *kallocate(u64 size, memory_tag tag) {
     KWARN("kallocate :: used `MEMORY_TAG_UNKNOWN`, must be re-classified");
   }
   if (state_ptr) {
-    state_ptr->stats.total_allocated += size;
-    state_ptr->stats.tagged_allocations[tag] += size;
-    ++state_ptr->alloc_count;
+    katomic_fetch_add_explicit(&state_ptr->stats.total_allocated, size, KATOMIC_RELAXED);
+    katomic_fetch_add_explicit(&state_ptr->stats.tagged_allocations[tag], size, KATOMIC_RELAXED);
+    katomic_fetch_add_explicit(&state_ptr->alloc_count, 1, KATOMIC_RELAXED);
   }
 
   // TODO: Memory alignment
@@ -94,8 +96,8 @@ void kfree(void *block, u64 size, memory_tag tag) {
     KWARN("kfree :: used `MEMORY_TAG_UNKNOWN`, must be re-classified");
   }
   if (state_ptr) {
-    state_ptr->stats.total_allocated -= size;
-    state_ptr->stats.tagged_allocations[tag] -= size;
+    katomic_fetch_sub_explicit(&state_ptr->stats.total_allocated, size, KATOMIC_RELAXED);
+    katomic_fetch_sub_explicit(&state_ptr->stats.tagged_allocations[tag], size, KATOMIC_RELAXED);
   }
 
   // TODO: Memory alignment
@@ -119,25 +121,26 @@ char *get_memory_usage_str(void) {
   u64 offset = kstrlen(buf);
 
   for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+    u64 allocated = katomic_load_explicit(&state_ptr->stats.tagged_allocations[i], KATOMIC_RELAXED);
     float amount;
     char unit[MEM_PRINT_UNIT_SYM_SIZE] = "XiB";
 
-    if (state_ptr->stats.tagged_allocations[i] >= MEM_B_IN_GIB) {
+    if (allocated >= MEM_B_IN_GIB) {
       unit[0] = 'G';
-      amount = state_ptr->stats.tagged_allocations[i] / (float) MEM_B_IN_GIB;
+      amount = allocated / (float) MEM_B_IN_GIB;
     }
-    else if (state_ptr->stats.tagged_allocations[i] >= MEM_B_IN_MIB) {
+    else if (allocated >= MEM_B_IN_MIB) {
       unit[0] = 'M';
-      amount = state_ptr->stats.tagged_allocations[i] / (float) MEM_B_IN_MIB;
+      amount = allocated / (float) MEM_B_IN_MIB;
     }
-    else if (state_ptr->stats.tagged_allocations[i] >= MEM_B_IN_KIB) {
+    else if (allocated >= MEM_B_IN_KIB) {
       unit[0] = 'K';
-      amount = state_ptr->stats.tagged_allocations[i] / (float) MEM_B_IN_KIB;
+      amount = allocated / (float) MEM_B_IN_KIB;
     }
     else {
       unit[0] = 'B';
       unit[1] = 0;
-      amount = (float) state_ptr->stats.tagged_allocations[i];
+      amount = (float) allocated;
     }
 
     offset += snprintf(buf + offset,
@@ -151,6 +154,6 @@ char *get_memory_usage_str(void) {
 }
 
 u64 get_memory_alloc_count(void) {
-  if (state_ptr) return state_ptr->alloc_count;
+  if (state_ptr) return katomic_load_explicit(&state_ptr->alloc_count, KATOMIC_RELAXED);
   return 0;
 }
@@ -0,0 +1,138 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <khash.h>
+#include <kname.h>
+#include <logger.h>
+#include <kstring.h>
+#include <kmemory.h>
+#include <linear_allocator.h>
+
+STATIC_ASSERT(!(KNAME_LOOKUP_CAPACITY & (KNAME_LOOKUP_CAPACITY - 1)), "ERROR: KNAME_LOOKUP_CAPACITY must be a power of two");
+STATIC_ASSERT(KNAME_LOOKUP_CAPACITY > KNAME_MAX_COUNT, "ERROR: KNAME_LOOKUP_CAPACITY must exceed KNAME_MAX_COUNT");
+
+// The string itself lives only in `strings`, slots compare against it on a hash match
+typedef struct {
+  u32 hash;
+  kname name;  // `KNAME_NONE` marks an empty slot
+} kname_lookup_slot;
+
+typedef struct {
+  u32 count;
+  const char **strings;
+  kname_lookup_slot *lookup;
+  linear_allocator storage;
+} kname_system_state;
+
+static kname_system_state *state_ptr = 0;
+
+b8 kname_system_initialize(u64 *memory_requirements, void *state) {
+  u64 struct_requirements = sizeof(kname_system_state);
+  u64 array_requirements = sizeof(const char *) * KNAME_MAX_COUNT;
+  u64 lookup_requirements = sizeof(kname_lookup_slot) * KNAME_LOOKUP_CAPACITY;
+  *memory_requirements = struct_requirements + array_requirements + lookup_requirements + KNAME_STORAGE_SIZE;
+  if (!state) return true;
+
+  state_ptr = state;
+  // ID 0 is reserved for `KNAME_NONE`
+  state_ptr->count = 1;
+  state_ptr->strings = (void *) ((u8 *) state + struct_requirements);
+  state_ptr->lookup = (void *) ((u8 *) state_ptr->strings + array_requirements);
+  kzero_memory(state_ptr->lookup, lookup_requirements);
+  linear_allocator_create(KNAME_STORAGE_SIZE,
+                          (u8 *) state_ptr->lookup + lookup_requirements,
+                          &state_ptr->storage);
+  state_ptr->strings[KNAME_NONE] = "";
+
+  // Fails if a builtin is listed twice, which would shift every later ID
+#define KNAME_BUILTIN_CREATE(id, str)                                     \
+  if (kname_create(str) != KNAME_##id) {                                  \
+    KFATAL("kname_system_initialize :: duplicated builtin '%s'", str);    \
+    return false;                                                         \
+  }
+  KNAME_BUILTINS(KNAME_BUILTIN_CREATE)
+#undef KNAME_BUILTIN_CREATE
+  return true;
+}
+
+void kname_system_shutdown(void *state) {
+  (void) state;  // Unused parameter
+
+  if (!state_ptr) return;
+  linear_allocator_destroy(&state_ptr->storage);
+  state_ptr = 0;
+}
+
+// Slot holding `str`, or the empty slot it would be inserted at
+static kname_lookup_slot *kname_lookup(const char *str, u32 hash) {
+  u32 mask = KNAME_LOOKUP_CAPACITY - 1;
+  for (u32 i = hash & mask;; i = (i + 1) & mask) {
+    kname_lookup_slot *slot = &state_ptr->lookup[i];
+    if (slot->name == KNAME_NONE) return slot;
+    if (slot->hash == hash && kstrcmp(state_ptr->strings[slot->name], str)) return slot;
+  }
+}
+
+kname kname_create(const char *str) {
+  if (!str || !*str) return KNAME_NONE;
+  if (!state_ptr) {
+    KERROR("kname_create :: called before kname system init ('%s')", str);
+    return KNAME_NONE;
+  }
+
+  u32 hash = (u32) khash_str(str);
+  kname_lookup_slot *slot = kname_lookup(str, hash);
+  if (slot->name != KNAME_NONE) return slot->name;
+
+  u64 length = kstrlen(str);
+  if (length >= KNAME_MAX_LEN) {
+    KERROR("kname_create :: '%s' exceeds KNAME_MAX_LEN (%i)", str, KNAME_MAX_LEN);
+    return KNAME_NONE;
+  }
+  if (state_ptr->count >= KNAME_MAX_COUNT) {
+    KFATAL("kname_create :: kname system is full (adjust KNAME_MAX_COUNT to allow more names)");
+    return KNAME_NONE;
+  }
+  char *copy = linear_allocator_alloc(&state_ptr->storage, length + 1);
+  if (!copy) {
+    KFATAL("kname_create :: kname storage is full (adjust KNAME_STORAGE_SIZE to allow more names)");
+    return KNAME_NONE;
+  }
+  kcopy_memory(copy, str, length + 1);
+
+  kname name = state_ptr->count++;
+  state_ptr->strings[name] = copy;
+  slot->hash = hash;
+  slot->name = name;
+  return name;
+}
+
+kname kname_find(const char *str) {
+  if (!str || !*str || !state_ptr) return KNAME_NONE;
+  return kname_lookup(str, (u32) khash_str(str))->name;
+}
+
+const char *kname_str(kname name) {
+  if (!state_ptr || name >= state_ptr->count) {
+    KWARN("kname_str :: invalid kname (%u)", name);
+    return "";
+  }
+  return state_ptr->strings[name];
+}
@@ -20,6 +20,7 @@
 
 
 #include <kmath.h>
+#include <kname.h>
 #include <logger.h>
 #include <kmemory.h>
 #include <kstring.h>
@@ -59,8 +60,8 @@ b8 material_loader_load(resource_loader *self, const char *name, resource *out_r
   resource_data->type = MATERIAL_TYPE_WORLD;
   resource_data->auto_release = true;
   resource_data->diffuse_color = vec4_one();  // white
-  resource_data->diffuse_map_name[0] = 0;
-  kstrncp(resource_data->name, name, MATERIAL_NAME_MAX_LEN);
+  resource_data->diffuse_map_name = KNAME_NONE;
+  resource_data->name = kname_create(name);
 
   char line_buf[MATERIAL_FILE_LINE_MAX_SIZE] = "";
   char *p = &line_buf[0];
@@ -106,10 +107,10 @@ b8 material_loader_load(resource_loader *self, const char *name, resource *out_r
       // TODO: handle version
     }
     else if (kstrcmpi(trimmed_var, "name")) {
-      kstrncp(resource_data->name, trimmed_value, MATERIAL_NAME_MAX_LEN);
+      resource_data->name = kname_create(trimmed_value);
     }
     else if (kstrcmpi(trimmed_var, "diffuse_map_name")) {
-      kstrncp(resource_data->diffuse_map_name, trimmed_value, TEXTURE_NAME_MAX_LEN);
+      resource_data->diffuse_map_name = kname_create(trimmed_value);
     }
     else if (kstrcmpi(trimmed_var, "diffuse_color")) {
       if (!str_to_vec4(trimmed_value, &resource_data->diffuse_color)) {
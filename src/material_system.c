@@ -21,31 +21,33 @@
 
 #include <kmath.h>
 #include <logger.h>
-#include <kstring.h>
-#include <hash_table.h>
+#include <kmemory.h>
+#include <handle_pool.h>
 #include <texture_system.h>
 #include <material_system.h>
 #include <resource_system.h>
 #include <renderer_frontend.h>
 
+typedef struct {
+  u64 ref_count;
+  khandle handle;
+  b8 auto_release;
+} material_ref;
+
 typedef struct {
   material_system_config config;
   material fallback_material;
   material *registered_materials;
-  hash_table registered_material_table;
+  handle_pool material_pool;
+  // Indexed by `kname`
+  material_ref *registered_material_refs;
 } material_system_state;
 
-typedef struct {
-  u64 ref_count;
-  u32 handle;
-  b8 auto_release;
-} material_ref;
-
 static material_system_state *state_ptr = 0;
 
 void destroy_material(material *m) {
-  KTRACE("Destroying material '%s'...", m->name);
-  if (m->diffuse_map.texture) texture_system_release(m->diffuse_map.texture->name);
+  KTRACE("Destroying material '%s'...", kname_str(m->name));
+  if (m->diffuse_map.texture) texture_system_release_kname(m->diffuse_map.texture->name);
   renderer_destroy_material(m);
   kzero_memory(m, sizeof(material));
   m->id = INVALID_ID;
@@ -55,9 +57,7 @@ void destroy_material(material *m) {
 
 b8 create_fallback_material(material_system_state *state) {
   kzero_memory(&state->fallback_material, sizeof(material));
-  kstrncp(state->fallback_material.name,
-          FALLBACK_MATERIAL_NAME,
-          MATERIAL_NAME_MAX_LEN);
+  state->fallback_material.name = KNAME_FALLBACK;
   state->fallback_material.id = INVALID_ID;
   state->fallback_material.generation = INVALID_ID;
   state->fallback_material.diffuse_color = vec4_one();  // white
@@ -74,17 +74,18 @@ b8 create_fallback_material(material_system_state *state) {
 
 b8 load_material(material_config cfg, material *m) {
   kzero_memory(m, sizeof(material));
-  kstrncp(m->name, cfg.name, MATERIAL_NAME_MAX_LEN);
+  m->name = cfg.name;
   m->type = cfg.type;
   m->diffuse_color = cfg.diffuse_color;
   // Diffuse map
-  if (kstrlen(cfg.diffuse_map_name)) {
+  if (cfg.diffuse_map_name != KNAME_NONE) {
     m->diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
-    m->diffuse_map.texture = texture_system_get(cfg.diffuse_map_name, true);
+    // Streams in, the renderer draws the fallback until the texture's generation is valid
+    m->diffuse_map.texture = texture_system_get_async_kname(cfg.diffuse_map_name, true);
     if (!m->diffuse_map.texture) {
       KWARN("load_material :: unable to load texture '%s' for material '%s' (using fallback)",
-            cfg.diffuse_map_name,
-            m->name);
+            kname_str(cfg.diffuse_map_name),
+            kname_str(m->name));
       m->diffuse_map.texture = texture_system_get_fallback();
     }
   }
@@ -94,7 +95,7 @@ b8 load_material(material_config cfg, material *m) {
   }
   // Create material
   if (!renderer_create_material(m)) {
-    KERROR("load_material :: unable to get renderer resources for material '%s'", m->name);
+    KERROR("load_material :: unable to get renderer resources for material '%s'", kname_str(m->name));
     return false;
   }
 
@@ -110,27 +111,26 @@ b8 material_system_initialize(u64 *memory_requirements,
   }
   u64 struct_requirements = sizeof(material_system_state);
   u64 array_requirements = sizeof(material) * config.max_material_count;
-  u64 hash_table_requirements = sizeof(material_ref) * config.max_material_count;
-  *memory_requirements = struct_requirements + array_requirements + hash_table_requirements;
+  u64 ref_array_requirements = sizeof(material_ref) * KNAME_MAX_COUNT;
+  u64 pool_requirements = 0;
+  handle_pool_create(config.max_material_count, &pool_requirements, 0, 0);
+  *memory_requirements = struct_requirements + array_requirements + ref_array_requirements + pool_requirements;
   if (!state) return true;
 
   state_ptr = state;
   state_ptr->config = config;
-  void *array_block = (void *) ((u64 *) state + struct_requirements);
+  void *array_block = (void *) ((u8 *) state + struct_requirements);
   state_ptr->registered_materials = array_block;
-  void *hash_table_block = (void *) ((u64 *) array_block + array_requirements);
-  hash_table_create(sizeof(material_ref),
-                    config.max_material_count,
-                    hash_table_block,
-                    false,
-                    &state_ptr->registered_material_table);
+  void *ref_array_block = (void *) ((u8 *) array_block + array_requirements);
+  state_ptr->registered_material_refs = ref_array_block;
+  void *pool_block = (void *) ((u8 *) ref_array_block + ref_array_requirements);
+  handle_pool_create(config.max_material_count, &pool_requirements, pool_block, &state_ptr->material_pool);
 
-  material_ref invalid_ref = {
-    .auto_release = false,
-    .handle = INVALID_ID,
-    .ref_count = 0
-  };
-  hash_table_fill(&state_ptr->registered_material_table, &invalid_ref);
+  for (u32 i = 0; i < KNAME_MAX_COUNT; ++i) {
+    state_ptr->registered_material_refs[i].auto_release = false;
+    state_ptr->registered_material_refs[i].handle = KHANDLE_INVALID;
+    state_ptr->registered_material_refs[i].ref_count = 0;
+  }
   for (u32 i = 0; i < state_ptr->config.max_material_count; ++i) {
     state_ptr->registered_materials[i].id = INVALID_ID;
     state_ptr->registered_materials[i].generation = INVALID_ID;
@@ -153,11 +153,24 @@ void material_system_shutdown(void *state) {
       }
     }
     destroy_material(&s->fallback_material);
+    handle_pool_destroy(&s->material_pool);
   }
   state_ptr = 0;
 }
 
 material *material_system_get(const char *name) {
+  // Already registered materials skip the resource load entirely
+  kname id = kname_find(name);
+  if (state_ptr && id != KNAME_NONE) {
+    if (id == KNAME_FALLBACK) return &state_ptr->fallback_material;
+    material_ref *ref = &state_ptr->registered_material_refs[id];
+    if (!khandle_is_invalid(ref->handle)) {
+      ++ref->ref_count;
+      KTRACE("Material '%s' already exists. `ref_count` -> %i", name, ref->ref_count);
+      return &state_ptr->registered_materials[ref->handle.index];
+    }
+  }
+
   resource material_resource;
   if (!resource_system_load(name, RESOURCE_TYPE_MATERIAL, &material_resource)) {
     KERROR("material_system_get :: failed to load material resource ('%s')", name);
@@ -179,81 +192,94 @@ material *material_system_get_fallback(void) {
 }
 
 material *material_system_get_from_cfg(material_config cfg) {
-  if (kstrcmpi(cfg.name, FALLBACK_MATERIAL_NAME)) return &state_ptr->fallback_material;
+  if (state_ptr && cfg.name == KNAME_FALLBACK) return &state_ptr->fallback_material;
+  return material_system_resolve(material_system_get_handle_from_cfg(cfg));
+}
 
-  material_ref ref;
-  if (!state_ptr || !hash_table_get(&state_ptr->registered_material_table,
-                                    cfg.name,
-                                    &ref)) {
-    KERROR("material_system_get_from_cfg :: get material failed ('%s')", cfg.name);
-    return 0;
+khandle material_system_get_handle_from_cfg(material_config cfg) {
+  if (!state_ptr || cfg.name == KNAME_NONE || cfg.name == KNAME_FALLBACK) {
+    KERROR("material_system_get_from_cfg :: get material failed ('%s')", kname_str(cfg.name));
+    return KHANDLE_INVALID;
   }
 
-  if (!ref.ref_count) ref.auto_release = cfg.auto_release;
-  ++ref.ref_count;
-  if (ref.handle == INVALID_ID) {
-    material *m = 0;
-    for (u32 i = 0; i < state_ptr->config.max_material_count; ++i) {
-      if (state_ptr->registered_materials[i].id == INVALID_ID) {
-        ref.handle = i;
-        m = &state_ptr->registered_materials[i];
-        break;
-      }
-    }
-    if (!m || ref.handle == INVALID_ID) {
+  material_ref *ref = &state_ptr->registered_material_refs[cfg.name];
+  if (!ref->ref_count) ref->auto_release = cfg.auto_release;
+  ++ref->ref_count;
+  if (khandle_is_invalid(ref->handle)) {
+    if (!handle_pool_acquire(&state_ptr->material_pool, &ref->handle)) {
+      --ref->ref_count;
       KFATAL("material_system_get_from_cfg :: material system if full (adjust config to allow more materials)");
-      return 0;
+      return KHANDLE_INVALID;
     }
+    material *m = &state_ptr->registered_materials[ref->handle.index];
+    // `load_material` zeroes the material, so keep its generation around
+    u32 generation = m->generation;
     if (!load_material(cfg, m)) {
-      KERROR("material_system_get_from_cfg :: Material loading failed ('%s')", cfg.name);
-      return 0;
+      --ref->ref_count;
+      handle_pool_release(&state_ptr->material_pool, ref->handle);
+      ref->handle = KHANDLE_INVALID;
+      KERROR("material_system_get_from_cfg :: Material loading failed ('%s')", kname_str(cfg.name));
+      return KHANDLE_INVALID;
     }
-    if (m->generation == INVALID_ID) m->generation = 0;
-    else ++m->generation;
-    m->id = ref.handle;
+    if (generation == INVALID_ID) m->generation = 0;
+    else m->generation = generation + 1;
+    m->id = ref->handle.index;
     KTRACE("Material '%s' created (does not exist yet). `ref_count` -> %i",
-           cfg.name,
-           ref.ref_count);
+           kname_str(cfg.name),
+           ref->ref_count);
   }
   else {
     KTRACE("Material '%s' already exists. `ref_count` -> %i",
-           cfg.name,
-           ref.ref_count);
+           kname_str(cfg.name),
+           ref->ref_count);
   }
-  // Update entry
-  hash_table_set(&state_ptr->registered_material_table, cfg.name, &ref);
-  return &state_ptr->registered_materials[ref.handle];
+  return ref->handle;
+}
+
+material *material_system_resolve(khandle handle) {
+  if (!state_ptr || !handle_pool_is_valid(&state_ptr->material_pool, handle)) return 0;
+  return &state_ptr->registered_materials[handle.index];
 }
 
 void material_system_release(const char *name) {
-  if (kstrcmpi(name, FALLBACK_MATERIAL_NAME)) return;
+  material_system_release_kname(kname_find(name));
+}
+
+void material_system_release_handle(khandle handle) {
+  material *m = material_system_resolve(handle);
+  if (!m) {
+    KWARN("material_system_release_handle :: stale or invalid material handle");
+    return;
+  }
+  material_system_release_kname(m->name);
+}
 
-  material_ref ref;
-  if (!state_ptr || !hash_table_get(&state_ptr->registered_material_table,
-                                    name,
-                                    &ref)) {
-    KERROR("material_system_release :: failed to release material '%s'", name);
+void material_system_release_kname(kname name) {
+  if (!state_ptr) {
+    KERROR("material_system_release :: failed to release material '%s'", kname_str(name));
     return;
   }
+  if (name == KNAME_FALLBACK) return;
 
-  if (!ref.ref_count) {
-    KWARN("Tried to release non-existant material ('%s')", name);
+  material_ref *ref = &state_ptr->registered_material_refs[name];
+  if (name == KNAME_NONE || !ref->ref_count) {
+    KWARN("Tried to release non-existant material ('%s')", kname_str(name));
     return;
   }
-  --ref.ref_count;
-  if (!ref.ref_count && ref.auto_release) {
-    material *m = &state_ptr->registered_materials[ref.handle];
+
+  --ref->ref_count;
+  if (!ref->ref_count && ref->auto_release) {
+    material *m = &state_ptr->registered_materials[ref->handle.index];
     destroy_material(m);
-    ref.handle = INVALID_ID;
-    ref.auto_release = false;
-    KTRACE("Material '%s' released (`ref_count` -> 0 && `auto_release` -> true)", name);
+    handle_pool_release(&state_ptr->material_pool, ref->handle);
+    ref->handle = KHANDLE_INVALID;
+    ref->auto_release = false;
+    KTRACE("Material '%s' released (`ref_count` -> 0 && `auto_release` -> true)", kname_str(name));
   }
   else {
     KTRACE("Material '%s' released (`ref_count` -> %i && `auto_release` -> %s)",
-           name,
-           ref.ref_count,
-           ref.auto_release ? "true" : "false");
+           kname_str(name),
+           ref->ref_count,
+           ref->auto_release ? "true" : "false");
   }
-  // Update entry
-  hash_table_set(&state_ptr->registered_material_table, name, &ref);
 }
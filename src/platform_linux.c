@@ -42,9 +42,17 @@
 #include <unistd.h>  // usleep
 #endif  // _POSIX_C_SOURCE >= 199309L
 
+#include <poll.h>
+#include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/prctl.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 #include <vulkan_types.h>
 #include <vulkan/vulkan.h>
@@ -54,6 +62,8 @@
 
 #define TIME_NS_IN_S 1e-9
 #define TIME_MS_IN_S 1e3
+#define PLATFORM_SPIN_COUNT 128  // pause iterations before parking on the futex
+#define PLATFORM_AFFINITY_MASK_WORDS 16  // up to 1024 cores
 
 typedef struct {
   Display *display;
@@ -63,6 +73,8 @@ typedef struct {
   xcb_atom_t wm_protocols;
   xcb_atom_t wm_delete_win;
   VkSurfaceKHR surface;
+  // Event already taken off the queue by `platform_wait_for_messages`
+  xcb_generic_event_t *pending_event;
 } platform_state;
 
 static platform_state *state_ptr;
@@ -216,6 +228,7 @@ b8 platform_system_startup(u64 *memory_requirements,
   *memory_requirements = sizeof(platform_state);
   if (!state) return true;
   state_ptr = state;
+  state_ptr->pending_event = 0;
 
   // Connect to X
   state_ptr->display = XOpenDisplay(NULL);
@@ -244,7 +257,8 @@ b8 platform_system_startup(u64 *memory_requirements,
     XCB_EVENT_MASK_KEY_RELEASE                   |
     XCB_EVENT_MASK_EXPOSURE                      |
     XCB_EVENT_MASK_POINTER_MOTION                |
-    XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    XCB_EVENT_MASK_STRUCTURE_NOTIFY              |
+    XCB_EVENT_MASK_FOCUS_CHANGE;
   u32 value_list[] = {
     state_ptr->screen->black_pixel,
     event_values
@@ -311,6 +325,7 @@ void platform_system_shutdown(void *plat_state) {
   (void) plat_state;  // Unused parameter
 
   if (!state_ptr) return;
+  free(state_ptr->pending_event);
   xcb_destroy_window(state_ptr->connection, state_ptr->window);
 }
 
@@ -322,7 +337,8 @@ b8 platform_pump_messages(void) {
   b8 quit_flagged = false;
 
   do {
-    event = xcb_poll_for_event(state_ptr->connection);
+    event = state_ptr->pending_event ? state_ptr->pending_event : xcb_poll_for_event(state_ptr->connection);
+    state_ptr->pending_event = 0;
     if (!event) break;
 
     // Input events
@@ -370,6 +386,16 @@ b8 platform_pump_messages(void) {
       };
       event_fire(EVENT_CODE_RESIZED, 0, context);
     } break;
+    case XCB_FOCUS_IN:
+    case XCB_FOCUS_OUT: {
+      xcb_focus_in_event_t *focus_event = (xcb_focus_in_event_t *) event;
+      // Keyboard grabs (e.g. while dragging the window) do not move the focus elsewhere
+      if (focus_event->mode == XCB_NOTIFY_MODE_GRAB || focus_event->mode == XCB_NOTIFY_MODE_UNGRAB) break;
+      event_context context = {
+        .data.u8[0] = (event->response_type & ~0x80) == XCB_FOCUS_IN
+      };
+      event_fire(EVENT_CODE_FOCUS_CHANGED, 0, context);
+    } break;
     case XCB_CLIENT_MESSAGE: {
       cm = (xcb_client_message_event_t *) event;
       if (cm->data.data32[0] == state_ptr->wm_delete_win) quit_flagged = true;
@@ -382,6 +408,25 @@ b8 platform_pump_messages(void) {
   return !quit_flagged;
 }
 
+void platform_wait_for_messages(u64 timeout_ms) {
+  if (!state_ptr) {
+    platform_sleep(timeout_ms);
+    return;
+  }
+  // Events read along with other replies (e.g. by the Vulkan WSI) never show up on the socket again
+  state_ptr->pending_event = xcb_poll_for_queued_event(state_ptr->connection);
+  if (state_ptr->pending_event) return;
+
+  xcb_flush(state_ptr->connection);
+  struct pollfd fd = {
+    .fd = xcb_get_file_descriptor(state_ptr->connection),
+    .events = POLLIN
+  };
+  if (poll(&fd, 1, (i32) timeout_ms) < 0 && errno != EINTR) {
+    KERROR("platform_wait_for_messages :: poll failed (%s)", strerror(errno));
+  }
+}
+
 void *platform_allocate(u64 size, b8 aligned) {
   (void) aligned;  // Unused parameter
   return malloc(size);
@@ -446,6 +491,162 @@ void platform_sleep(u64 ms) {
 #endif  // _POSIX_C_SOURCE >= 199309L
 }
 
+typedef struct {
+  pthread_t handle;
+  platform_thread_start start;
+  void *params;
+} linux_thread;
+
+static void *linux_thread_trampoline(void *params) {
+  linux_thread *t = params;
+  return (void *) (u64) t->start(t->params);
+}
+
+static void futex_wait(katomic_u32 *addr, u32 expected) {
+  // Returns straight away (EAGAIN) if `*addr` no longer holds `expected`
+  syscall(SYS_futex, (u32 *) addr, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+static void futex_wake(katomic_u32 *addr, u32 count) {
+  syscall(SYS_futex, (u32 *) addr, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+b8 platform_thread_create(platform_thread_start start, void *params, platform_thread *out_thread) {
+  if (!start || !out_thread) return false;
+  linux_thread *t = platform_allocate(sizeof(linux_thread), false);
+  t->start = start;
+  t->params = params;
+  i32 result = pthread_create(&t->handle, 0, linux_thread_trampoline, t);
+  if (result) {
+    KERROR("platform_thread_create :: pthread_create failed (%s)", strerror(result));
+    platform_free(t, false);
+    return false;
+  }
+  out_thread->internal_data = t;
+  out_thread->thread_id = (u64) t->handle;
+  return true;
+}
+
+void platform_thread_join(platform_thread *thread) {
+  if (!thread || !thread->internal_data) return;
+  linux_thread *t = thread->internal_data;
+  pthread_join(t->handle, 0);
+  platform_free(t, false);
+  thread->internal_data = 0;
+  thread->thread_id = 0;
+}
+
+void platform_thread_yield(void) {
+  sched_yield();
+}
+
+u64 platform_thread_get_id(void) {
+  return (u64) syscall(SYS_gettid);
+}
+
+void platform_thread_set_name(const char *name) {
+  if (!name) return;
+  // The kernel keeps 16 bytes (including the null terminator)
+  char truncated[16];
+  strncpy(truncated, name, sizeof(truncated) - 1);
+  truncated[sizeof(truncated) - 1] = 0;
+  prctl(PR_SET_NAME, truncated, 0, 0, 0);
+}
+
+b8 platform_thread_set_affinity(u32 core_index) {
+  u64 mask[PLATFORM_AFFINITY_MASK_WORDS] = {0};
+  if (core_index >= PLATFORM_AFFINITY_MASK_WORDS * 64) return false;
+  mask[core_index / 64] = 1ULL << (core_index % 64);
+  if (syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask)) {
+    KWARN("platform_thread_set_affinity :: failed to pin thread to core %u (%s)", core_index, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+u32 platform_get_processor_count(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (u32) count : 1;
+}
+
+b8 platform_get_executable_dir(char *out_path, u64 max_len) {
+  ssize_t len = readlink("/proc/self/exe", out_path, max_len - 1);
+  if (len <= 0 || (u64) len >= max_len - 1) return false;
+  out_path[len] = 0;
+  char *separator = strrchr(out_path, '/');
+  if (!separator) return false;
+  *separator = 0;
+  return true;
+}
+
+void platform_mutex_create(platform_mutex *out_mutex) {
+  katomic_init(&out_mutex->state, 0);
+}
+
+void platform_mutex_destroy(platform_mutex *mutex) {
+  (void) mutex;  // Unused parameter (nothing is allocated)
+}
+
+void platform_mutex_lock(platform_mutex *mutex) {
+  u32 c = 0;
+  for (u32 i = 0; i < PLATFORM_SPIN_COUNT; ++i) {
+    c = 0;
+    if (katomic_cas_weak_explicit(&mutex->state, &c, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)) return;
+    katomic_pause();
+  }
+  // Park: mark the mutex contended so the unlocker knows to wake someone
+  if (c != 2) c = katomic_exchange_explicit(&mutex->state, 2, KATOMIC_ACQUIRE);
+  while (c) {
+    futex_wait(&mutex->state, 2);
+    c = katomic_exchange_explicit(&mutex->state, 2, KATOMIC_ACQUIRE);
+  }
+}
+
+b8 platform_mutex_try_lock(platform_mutex *mutex) {
+  u32 c = 0;
+  return katomic_cas_explicit(&mutex->state, &c, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED);
+}
+
+void platform_mutex_unlock(platform_mutex *mutex) {
+  if (katomic_exchange_explicit(&mutex->state, 0, KATOMIC_RELEASE) == 2) futex_wake(&mutex->state, 1);
+}
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore *out_semaphore) {
+  if (!out_semaphore) return false;
+  katomic_init(&out_semaphore->count, initial_count);
+  katomic_init(&out_semaphore->waiter_count, 0);
+  return true;
+}
+
+void platform_semaphore_destroy(platform_semaphore *semaphore) {
+  (void) semaphore;  // Unused parameter (nothing is allocated)
+}
+
+void platform_semaphore_signal(platform_semaphore *semaphore) {
+  katomic_fetch_add(&semaphore->count, 1);
+  if (katomic_load(&semaphore->waiter_count)) futex_wake(&semaphore->count, 1);
+}
+
+b8 platform_semaphore_try_wait(platform_semaphore *semaphore) {
+  u32 c = katomic_load_explicit(&semaphore->count, KATOMIC_RELAXED);
+  while (c) {
+    if (katomic_cas_weak_explicit(&semaphore->count, &c, c - 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)) return true;
+  }
+  return false;
+}
+
+void platform_semaphore_wait(platform_semaphore *semaphore) {
+  for (u32 i = 0; i < PLATFORM_SPIN_COUNT; ++i) {
+    if (platform_semaphore_try_wait(semaphore)) return;
+    katomic_pause();
+  }
+  while (!platform_semaphore_try_wait(semaphore)) {
+    katomic_fetch_add(&semaphore->waiter_count, 1);
+    futex_wait(&semaphore->count, 0);
+    katomic_fetch_sub(&semaphore->waiter_count, 1);
+  }
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
   darray_push(*names_darray, &"VK_KHR_xcb_surface");
 }
@@ -36,6 +36,8 @@
 #include <vulkan/vulkan_win32.h>
 
 #define WINDOW_CLASS "wge_window_class"
+#define PLATFORM_SPIN_COUNT 128  // pause iterations before parking on the address
+#define PLATFORM_THREAD_NAME_MAX_LEN 64
 
 typedef struct {
   HINSTANCE h_instance;
@@ -68,6 +70,13 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
     };
     event_fire(EVENT_CODE_RESIZED, 0, context);
   } break;
+  case WM_SETFOCUS:
+  case WM_KILLFOCUS: {
+    event_context context = {
+      .data.u8[0] = msg == WM_SETFOCUS
+    };
+    event_fire(EVENT_CODE_FOCUS_CHANGED, 0, context);
+  } break;
   case WM_KEYDOWN:
   case WM_SYSKEYDOWN:
   case WM_KEYUP:
@@ -237,6 +246,11 @@ b8 platform_pump_messages(void) {
   return true;
 }
 
+void platform_wait_for_messages(u64 timeout_ms) {
+  // Wakes up for any input queued to this thread
+  MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD) timeout_ms, QS_ALLINPUT);
+}
+
 void *platform_allocate(u64 size, b8 aligned) {
   return malloc(size);
 }
@@ -293,6 +307,160 @@ void platform_sleep(u64 ms) {
   Sleep(ms);
 }
 
+typedef struct {
+  HANDLE handle;
+  platform_thread_start start;
+  void *params;
+} win32_thread;
+
+static DWORD WINAPI win32_thread_trampoline(LPVOID params) {
+  win32_thread *t = params;
+  return t->start(t->params);
+}
+
+// WaitOnAddress/WakeByAddress* are the Win32 equivalent of the Linux futex
+static void futex_wait(katomic_u32 *addr, u32 expected) {
+  WaitOnAddress((volatile VOID *) addr, &expected, sizeof(u32), INFINITE);
+}
+
+static void futex_wake(katomic_u32 *addr) {
+  WakeByAddressSingle((PVOID) addr);
+}
+
+b8 platform_thread_create(platform_thread_start start, void *params, platform_thread *out_thread) {
+  if (!start || !out_thread) return false;
+  win32_thread *t = platform_allocate(sizeof(win32_thread), false);
+  t->start = start;
+  t->params = params;
+  DWORD thread_id = 0;
+  t->handle = CreateThread(0, 0, win32_thread_trampoline, t, 0, &thread_id);
+  if (!t->handle) {
+    KERROR("platform_thread_create :: CreateThread failed (%lu)", GetLastError());
+    platform_free(t, false);
+    return false;
+  }
+  out_thread->internal_data = t;
+  out_thread->thread_id = thread_id;
+  return true;
+}
+
+void platform_thread_join(platform_thread *thread) {
+  if (!thread || !thread->internal_data) return;
+  win32_thread *t = thread->internal_data;
+  WaitForSingleObject(t->handle, INFINITE);
+  CloseHandle(t->handle);
+  platform_free(t, false);
+  thread->internal_data = 0;
+  thread->thread_id = 0;
+}
+
+void platform_thread_yield(void) {
+  SwitchToThread();
+}
+
+u64 platform_thread_get_id(void) {
+  return GetCurrentThreadId();
+}
+
+void platform_thread_set_name(const char *name) {
+  if (!name) return;
+  wchar_t wide_name[PLATFORM_THREAD_NAME_MAX_LEN];
+  if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, PLATFORM_THREAD_NAME_MAX_LEN)) {
+    SetThreadDescription(GetCurrentThread(), wide_name);
+  }
+}
+
+b8 platform_thread_set_affinity(u32 core_index) {
+  if (core_index >= sizeof(DWORD_PTR) * 8) return false;
+  if (!SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << core_index)) {
+    KWARN("platform_thread_set_affinity :: failed to pin thread to core %u (%lu)", core_index, GetLastError());
+    return false;
+  }
+  return true;
+}
+
+u32 platform_get_processor_count(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+b8 platform_get_executable_dir(char *out_path, u64 max_len) {
+  DWORD len = GetModuleFileNameA(0, out_path, (DWORD) max_len);
+  if (!len || len >= max_len) return false;
+  while (len && out_path[len - 1] != '\\' && out_path[len - 1] != '/') --len;
+  if (!len) return false;
+  out_path[len - 1] = 0;
+  return true;
+}
+
+void platform_mutex_create(platform_mutex *out_mutex) {
+  katomic_init(&out_mutex->state, 0);
+}
+
+void platform_mutex_destroy(platform_mutex *mutex) {
+  (void) mutex;  // Unused parameter (nothing is allocated)
+}
+
+void platform_mutex_lock(platform_mutex *mutex) {
+  u32 c = 0;
+  for (u32 i = 0; i < PLATFORM_SPIN_COUNT; ++i) {
+    c = 0;
+    if (katomic_cas_weak_explicit(&mutex->state, &c, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)) return;
+    katomic_pause();
+  }
+  if (c != 2) c = katomic_exchange_explicit(&mutex->state, 2, KATOMIC_ACQUIRE);
+  while (c) {
+    futex_wait(&mutex->state, 2);
+    c = katomic_exchange_explicit(&mutex->state, 2, KATOMIC_ACQUIRE);
+  }
+}
+
+b8 platform_mutex_try_lock(platform_mutex *mutex) {
+  u32 c = 0;
+  return katomic_cas_explicit(&mutex->state, &c, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED);
+}
+
+void platform_mutex_unlock(platform_mutex *mutex) {
+  if (katomic_exchange_explicit(&mutex->state, 0, KATOMIC_RELEASE) == 2) futex_wake(&mutex->state);
+}
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore *out_semaphore) {
+  if (!out_semaphore) return false;
+  katomic_init(&out_semaphore->count, initial_count);
+  katomic_init(&out_semaphore->waiter_count, 0);
+  return true;
+}
+
+void platform_semaphore_destroy(platform_semaphore *semaphore) {
+  (void) semaphore;  // Unused parameter (nothing is allocated)
+}
+
+void platform_semaphore_signal(platform_semaphore *semaphore) {
+  katomic_fetch_add(&semaphore->count, 1);
+  if (katomic_load(&semaphore->waiter_count)) futex_wake(&semaphore->count);
+}
+
+b8 platform_semaphore_try_wait(platform_semaphore *semaphore) {
+  u32 c = katomic_load_explicit(&semaphore->count, KATOMIC_RELAXED);
+  while (c) {
+    if (katomic_cas_weak_explicit(&semaphore->count, &c, c - 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)) return true;
+  }
+  return false;
+}
+
+void platform_semaphore_wait(platform_semaphore *semaphore) {
+  for (u32 i = 0; i < PLATFORM_SPIN_COUNT; ++i) {
+    if (platform_semaphore_try_wait(semaphore)) return;
+    katomic_pause();
+  }
+  while (!platform_semaphore_try_wait(semaphore)) {
+    katomic_fetch_add(&semaphore->waiter_count, 1);
+    futex_wait(&semaphore->count, 0);
+    katomic_fetch_sub(&semaphore->waiter_count, 1);
+  }
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
   darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
@@ -0,0 +1,114 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <kmemory.h>
+#include <render_queue.h>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+static void allocate_entries(render_queue *queue, u32 capacity) {
+  render_queue_entry *entries = kallocate(sizeof(render_queue_entry) * capacity, MEMORY_TAG_RENDERER);
+  render_queue_entry *scratch = kallocate(sizeof(render_queue_entry) * capacity, MEMORY_TAG_RENDERER);
+  if (queue->entries) {
+    kcopy_memory(entries, queue->entries, sizeof(render_queue_entry) * queue->count);
+    kfree(queue->entries, sizeof(render_queue_entry) * queue->capacity, MEMORY_TAG_RENDERER);
+    kfree(queue->scratch, sizeof(render_queue_entry) * queue->capacity, MEMORY_TAG_RENDERER);
+  }
+  queue->entries = entries;
+  queue->scratch = scratch;
+  queue->capacity = capacity;
+}
+
+void render_queue_create(u32 capacity, render_queue *out_queue) {
+  kzero_memory(out_queue, sizeof(render_queue));
+  allocate_entries(out_queue, capacity ? capacity : 1);
+}
+
+void render_queue_destroy(render_queue *queue) {
+  if (queue->entries) {
+    kfree(queue->entries, sizeof(render_queue_entry) * queue->capacity, MEMORY_TAG_RENDERER);
+    kfree(queue->scratch, sizeof(render_queue_entry) * queue->capacity, MEMORY_TAG_RENDERER);
+  }
+  kzero_memory(queue, sizeof(render_queue));
+}
+
+void render_queue_clear(render_queue *queue) {
+  queue->count = 0;
+}
+
+void render_queue_push(render_queue *queue, u64 key, u32 index) {
+  if (queue->count == queue->capacity) allocate_entries(queue, queue->capacity * 2);
+  queue->entries[queue->count++] = (render_queue_entry) {
+    .key = key,
+    .index = index
+  };
+}
+
+void render_queue_sort(render_queue *queue) {
+  if (queue->count < 2) return;
+
+  u32 counts[RADIX_BUCKETS];
+  for (u32 shift = 0; shift < 64; shift += RADIX_BITS) {
+    kzero_memory(counts, sizeof(counts));
+    for (u32 i = 0; i < queue->count; ++i) {
+      ++counts[(queue->entries[i].key >> shift) & (RADIX_BUCKETS - 1)];
+    }
+    // Every key shares this digit (common for the high bits), nothing to reorder
+    if (counts[(queue->entries[0].key >> shift) & (RADIX_BUCKETS - 1)] == queue->count) continue;
+
+    u32 offset = 0;
+    for (u32 i = 0; i < RADIX_BUCKETS; ++i) {
+      u32 count = counts[i];
+      counts[i] = offset;
+      offset += count;
+    }
+    for (u32 i = 0; i < queue->count; ++i) {
+      u32 digit = (queue->entries[i].key >> shift) & (RADIX_BUCKETS - 1);
+      queue->scratch[counts[digit]++] = queue->entries[i];
+    }
+    render_queue_entry *tmp = queue->entries;
+    queue->entries = queue->scratch;
+    queue->scratch = tmp;
+  }
+}
+
+u64 render_queue_make_key(u8 pass,
+                          b8 transparent,
+                          u32 material_id,
+                          u32 geometry_id,
+                          f32 depth) {
+  const u64 depth_max = (1ull << RENDER_QUEUE_DEPTH_BITS) - 1;
+  if (depth < 0.0f) depth = 0.0f;
+  if (depth > 1.0f) depth = 1.0f;
+  u64 quantized_depth = (u64) (depth * depth_max);
+  u64 material = material_id & 0xFFFF;
+  u64 geometry = geometry_id & 0xFFFF;
+
+  u64 key = ((u64) (pass & 0x3) << 62);
+  if (!transparent) return key | (material << 45) | (geometry << 29) | quantized_depth;
+  // Farthest first, so blending composites correctly
+  return key | (1ull << 61) | ((depth_max - quantized_depth) << 32) | (material << 16) | geometry;
+}
+
+u64 render_queue_make_sequence_key(u8 pass, u32 sequence) {
+  return ((u64) (pass & 0x3) << 62) | (1ull << 61) | sequence;
+}
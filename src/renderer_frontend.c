@@ -23,12 +23,14 @@
 #include <logger.h>
 #include <kmemory.h>
 #include <kstring.h>
+#include <render_queue.h>
 #include <texture_system.h>
 #include <material_system.h>
 #include <renderer_backend.h>
 #include <renderer_frontend.h>
 
 #define PROJ_MATRIX_ASPECT_RATIO (16 / 9.0f)
+#define RENDER_QUEUE_INITIAL_CAPACITY 1024
 
 typedef struct {
   renderer_backend backend;
@@ -38,13 +40,17 @@ typedef struct {
   Matrix4 ui_view;
   f32 near_clip;
   f32 far_clip;
+  render_queue queue;
+  // Model matrices of the draw being batched
+  Matrix4 *instance_models;
+  u32 instance_capacity;
 } renderer_system_state;
 
 static renderer_system_state *state_ptr;
 
 b8 renderer_system_initialize(u64 *memory_requirements,
                               void *state,
-                              const char *application_name) {
+                              renderer_system_config config) {
   *memory_requirements = sizeof(renderer_system_state);
   if (!state) return true;
   state_ptr = state;
@@ -53,7 +59,7 @@ b8 renderer_system_initialize(u64 *memory_requirements,
                           &state_ptr->backend);
   state_ptr->backend.frame_number = 0;
 
-  if (!state_ptr->backend.initialize(&state_ptr->backend, application_name)) {
+  if (!state_ptr->backend.initialize(&state_ptr->backend, &config)) {
     KFATAL("Renderer backend initialization failed. Shutting down the engine...");
     return false;
   }
@@ -76,6 +82,10 @@ b8 renderer_system_initialize(u64 *memory_requirements,
                                       100.0f);
   state_ptr->ui_view = mat4_inv(mat4_id());
 
+  render_queue_create(RENDER_QUEUE_INITIAL_CAPACITY, &state_ptr->queue);
+  state_ptr->instance_capacity = RENDER_QUEUE_INITIAL_CAPACITY;
+  state_ptr->instance_models = kallocate(sizeof(Matrix4) * state_ptr->instance_capacity, MEMORY_TAG_RENDERER);
+
   return true;
 }
 
@@ -83,6 +93,8 @@ void renderer_system_shutdown(void *state) {
   (void) state;  // Unused parameter
 
   if (!state_ptr) return;
+  render_queue_destroy(&state_ptr->queue);
+  kfree(state_ptr->instance_models, sizeof(Matrix4) * state_ptr->instance_capacity, MEMORY_TAG_RENDERER);
   state_ptr->backend.shutdown(&state_ptr->backend);
   state_ptr = 0;
 }
@@ -104,9 +116,92 @@ void renderer_on_resized(u16 width, u16 height) {
   else KWARN("renderer_on_resized :: Renderer backend does not exist");
 }
 
+void renderer_set_present_config(renderer_present_config config) {
+  if (state_ptr) state_ptr->backend.set_present_config(&state_ptr->backend, &config);
+  else KWARN("renderer_set_present_config :: Renderer backend does not exist");
+}
+
+void renderer_wait_for_latency(void) {
+  if (state_ptr) state_ptr->backend.wait_for_latency(&state_ptr->backend);
+}
+
+// Distance from the camera to the model's origin, normalized to the clip range
+static f32 view_depth(Matrix4 model) {
+  const f32 *v = state_ptr->view.data;
+  f32 x = model.data[12], y = model.data[13], z = model.data[14];
+  // The camera looks down -Z in view space
+  f32 depth = -(v[2] * x + v[6] * y + v[10] * z + v[14]);
+  return (depth - state_ptr->near_clip) / (state_ptr->far_clip - state_ptr->near_clip);
+}
+
+static void build_render_queue(render_packet *packet) {
+  render_queue *queue = &state_ptr->queue;
+  render_queue_clear(queue);
+  for (u32 i = 0; i < packet->geometry_count; ++i) {
+    geometry_render_data *data = &packet->geometries[i];
+    material *m = data->geometry->material ? data->geometry->material : material_system_get_fallback();
+    texture *t = m->diffuse_map.texture;
+    b8 transparent = (t && t->has_transparency) || m->diffuse_color.a < 1.0f;
+    render_queue_push(queue,
+                      render_queue_make_key(BUILTIN_RENDERPASS_WORLD,
+                                            transparent,
+                                            m->id,
+                                            data->geometry->internal_id,
+                                            view_depth(data->model)),
+                      i);
+  }
+  // UI elements overlap, so they keep the order they were submitted in
+  for (u32 i = 0; i < packet->ui_geometry_count; ++i) {
+    render_queue_push(queue,
+                      render_queue_make_sequence_key(BUILTIN_RENDERPASS_UI, i),
+                      packet->geometry_count + i);
+  }
+  render_queue_sort(queue);
+}
+
+static geometry_render_data *queued_draw(render_packet *packet, u32 index) {
+  if (index < packet->geometry_count) return &packet->geometries[index];
+  return &packet->ui_geometries[index - packet->geometry_count];
+}
+
+static void draw_render_queue(render_packet *packet, u8 pass) {
+  render_queue *queue = &state_ptr->queue;
+  u32 i = 0;
+  while (i < queue->count) {
+    // Sorted by pass first, so the pass is one contiguous run
+    u8 entry_pass = render_queue_key_pass(queue->entries[i].key);
+    if (entry_pass > pass) break;
+    if (entry_pass < pass) {
+      ++i;
+      continue;
+    }
+
+    // Consecutive draws of the same geometry (and so the same material) become one instanced draw
+    geometry *g = queued_draw(packet, queue->entries[i].index)->geometry;
+    u32 instance_count = 0;
+    while (i < queue->count && render_queue_key_pass(queue->entries[i].key) == pass) {
+      geometry_render_data *data = queued_draw(packet, queue->entries[i].index);
+      if (data->geometry != g) break;
+      if (instance_count == state_ptr->instance_capacity) {
+        u32 new_capacity = state_ptr->instance_capacity * 2;
+        Matrix4 *models = kallocate(sizeof(Matrix4) * new_capacity, MEMORY_TAG_RENDERER);
+        kcopy_memory(models, state_ptr->instance_models, sizeof(Matrix4) * instance_count);
+        kfree(state_ptr->instance_models, sizeof(Matrix4) * state_ptr->instance_capacity, MEMORY_TAG_RENDERER);
+        state_ptr->instance_models = models;
+        state_ptr->instance_capacity = new_capacity;
+      }
+      state_ptr->instance_models[instance_count++] = data->model;
+      ++i;
+    }
+    state_ptr->backend.draw_geometry(g, state_ptr->instance_models, instance_count);
+  }
+}
+
 b8 renderer_draw_frame(render_packet *packet) {
   // Begin frame
   if (state_ptr->backend.begin_frame(&state_ptr->backend, packet->delta_time)) {
+    build_render_queue(packet);
+
     // Begin world renderpass
     if (!state_ptr->backend.begin_renderpass(&state_ptr->backend, BUILTIN_RENDERPASS_WORLD)) {
       KERROR("renderer_draw_frame :: World's `begin_renderpass` failed");
@@ -114,12 +209,16 @@ b8 renderer_draw_frame(render_packet *packet) {
     }
 
     // Update world global state
-    state_ptr->backend.update_world(state_ptr->proj, state_ptr->view, vec3_zero(), vec4_one(), 0);
+    // Each world geometry is one instance, the backend sizes the frame's instance data up front
+    state_ptr->backend.update_world(state_ptr->proj,
+                                    state_ptr->view,
+                                    vec3_zero(),
+                                    vec4_one(),
+                                    0,
+                                    packet->geometry_count);
 
     // Draw world geometries
-    for (u32 i = 0; i < packet->geometry_count; ++i) {
-      state_ptr->backend.draw_geometry(packet->geometries[i]);
-    }
+    draw_render_queue(packet, BUILTIN_RENDERPASS_WORLD);
 
     // End world renderpass
     if (!state_ptr->backend.end_renderpass(&state_ptr->backend, BUILTIN_RENDERPASS_WORLD)) {
@@ -137,9 +236,7 @@ b8 renderer_draw_frame(render_packet *packet) {
     state_ptr->backend.update_ui(state_ptr->ui_proj, state_ptr->ui_view, 0);
 
     // Draw UI geometries
-    for (u32 i = 0; i < packet->ui_geometry_count; ++i) {
-      state_ptr->backend.draw_geometry(packet->ui_geometries[i]);
-    }
+    draw_render_queue(packet, BUILTIN_RENDERPASS_UI);
 
     // End UI renderpass
     if (!state_ptr->backend.end_renderpass(&state_ptr->backend, BUILTIN_RENDERPASS_UI)) {
@@ -19,32 +19,54 @@
  */
 
 
+#include <kimage.h>
 #include <logger.h>
-#include <kstring.h>
 #include <kmemory.h>
-#include <hash_table.h>
+#include <platform.h>
+#include <job_system.h>
+#include <handle_pool.h>
 #include <texture_system.h>
 #include <resource_system.h>
 #include <renderer_frontend.h>
 
+typedef struct {
+  u64 ref_count;
+  khandle handle;
+  b8 auto_release;
+} texture_ref;
+
+// Uploads are synchronous, so only a few are done per update to avoid hitching
+#define TEXTURE_SYSTEM_MAX_UPLOADS_PER_UPDATE 4
+// Dropping mips never shrinks a side below this
+#define TEXTURE_SYSTEM_MIP_DROP_MIN_SIZE 16
+
+// One in-flight `texture_system_get_async` decode, handed back to the main thread once done
+typedef struct texture_load_request {
+  khandle handle;
+  kname name;
+  const char *name_str;
+  resource img_resource;
+  b8 has_transparency;
+  b8 decoded;
+  struct texture_load_request *next;
+} texture_load_request;
+
 typedef struct {
   texture_system_config config;
   texture fallback_texture;
   texture *registered_textures;
-  hash_table registered_texture_table;
+  handle_pool texture_pool;
+  // Indexed by `kname`
+  texture_ref *registered_texture_refs;
+  job_counter pending_loads;
+  platform_mutex completed_mutex;
+  texture_load_request *completed_loads;
 } texture_system_state;
 
-typedef struct {
-  u64 ref_count;
-  u32 handle;
-  b8 auto_release;
-} texture_ref;
-
 static texture_system_state *state_ptr = 0;
 
 void destroy_texture(texture *t) {
   renderer_destroy_texture(t);
-  kzero_memory(t->name, sizeof(char) * TEXTURE_NAME_MAX_LEN);
   kzero_memory(t, sizeof(texture));
   t->id = INVALID_ID;
   t->generation = INVALID_ID;
@@ -81,9 +103,7 @@ b8 create_fallback_textures(texture_system_state *state) {
     .generation = INVALID_ID,
     .has_transparency = false
   };
-  kstrncp(state->fallback_texture.name,
-          FALLBACK_TEXTURE_NAME,
-          TEXTURE_NAME_MAX_LEN);
+  state->fallback_texture.name = KNAME_FALLBACK;
 
   renderer_create_texture(pixels, &state->fallback_texture);
 
@@ -96,14 +116,38 @@ void destroy_fallback_textures(texture_system_state *state) {
   if (state) destroy_texture(&state->fallback_texture);
 }
 
-// TODO: move to resource system
-b8 load_texture(const char *name, texture *t) {
-  resource img_resource;
-  if (!resource_system_load(name, RESOURCE_TYPE_IMAGE, &img_resource)) {
-    KERROR("load_texture :: failed to load image resource for texture '%s'", name);
+// Safe to call from any thread
+static b8 decode_texture(const char *name, resource *out_resource, b8 *out_has_transparency) {
+  if (!resource_system_load(name, RESOURCE_TYPE_IMAGE, out_resource)) {
+    KERROR("decode_texture :: failed to load image resource for texture '%s'", name);
     return false;
   }
-  image_resource_data *resource_data = img_resource.data;
+  image_resource_data *resource_data = out_resource->data;
+  u64 total_size = resource_data->width * resource_data->height * resource_data->channel_count;
+  *out_has_transparency = false;
+  for (u64 i = 0; i < total_size; i += resource_data->channel_count) {
+    if (resource_data->pixels[i + 3] < 255) {
+      *out_has_transparency = true;
+      break;
+    }
+  }
+  // Downsampled in place, so the loader still frees the same block
+  for (u8 i = 0; i < state_ptr->config.mip_drop_count; ++i) {
+    if (resource_data->width < TEXTURE_SYSTEM_MIP_DROP_MIN_SIZE * 2 ||
+        resource_data->height < TEXTURE_SYSTEM_MIP_DROP_MIN_SIZE * 2) break;
+    kimage_downsample(resource_data->pixels,
+                      resource_data->width,
+                      resource_data->height,
+                      resource_data->channel_count,
+                      resource_data->pixels);
+    resource_data->width = kimage_mip_extent(resource_data->width, 1);
+    resource_data->height = kimage_mip_extent(resource_data->height, 1);
+  }
+  return true;
+}
+
+// Main thread only (talks to the renderer)
+static void upload_texture(kname name, image_resource_data *resource_data, b8 has_transparency, texture *t) {
   texture t_tmp = {
     .width = resource_data->width,
     .height = resource_data->height,
@@ -112,16 +156,8 @@ b8 load_texture(const char *name, texture *t) {
 
   u32 current_gen = t->generation;
   t->generation = INVALID_ID;
-  u64 total_size = t_tmp.width * t_tmp.height * t_tmp.channel_count;
-  b32 has_transparency = false;
-  for (u64 i = 0; i < total_size; i += t_tmp.channel_count) {
-    if (resource_data->pixels[i + 3] < 255) {
-      has_transparency = true;
-      break;
-    }
-  }
-
-  kstrncp(t_tmp.name, name, TEXTURE_NAME_MAX_LEN);
+  t_tmp.id = t->id;
+  t_tmp.name = name;
   t_tmp.generation = INVALID_ID;
   t_tmp.has_transparency = has_transparency;
 
@@ -132,11 +168,34 @@ b8 load_texture(const char *name, texture *t) {
   renderer_destroy_texture(&old);
   if (current_gen == INVALID_ID) t->generation = 0;
   else t->generation = current_gen + 1;
+}
 
+// TODO: move to resource system
+b8 load_texture(kname name, texture *t) {
+  resource img_resource;
+  b8 has_transparency;
+  if (!decode_texture(kname_str(name), &img_resource, &has_transparency)) return false;
+  upload_texture(name, img_resource.data, has_transparency, t);
   resource_system_unload(&img_resource);
   return true;
 }
 
+static void texture_decode_job(void *data) {
+  texture_load_request *request = data;
+  request->decoded = decode_texture(request->name_str,
+                                    &request->img_resource,
+                                    &request->has_transparency);
+  platform_mutex_lock(&state_ptr->completed_mutex);
+  request->next = state_ptr->completed_loads;
+  state_ptr->completed_loads = request;
+  platform_mutex_unlock(&state_ptr->completed_mutex);
+}
+
+static void free_load_request(texture_load_request *request) {
+  if (request->decoded) resource_system_unload(&request->img_resource);
+  kfree(request, sizeof(texture_load_request), MEMORY_TAG_TEXTURE);
+}
+
 b8 texture_system_initialize(u64 *memory_requirements,
                              void *state,
                              texture_system_config config) {
@@ -146,27 +205,29 @@ b8 texture_system_initialize(u64 *memory_requirements,
   }
   u64 struct_requirements = sizeof(texture_system_state);
   u64 array_requirements = sizeof(texture) * config.max_texture_count;
-  u64 hash_table_requirements = sizeof(texture_ref) * config.max_texture_count;
-  *memory_requirements = struct_requirements + array_requirements + hash_table_requirements;
+  u64 ref_array_requirements = sizeof(texture_ref) * KNAME_MAX_COUNT;
+  u64 pool_requirements = 0;
+  handle_pool_create(config.max_texture_count, &pool_requirements, 0, 0);
+  *memory_requirements = struct_requirements + array_requirements + ref_array_requirements + pool_requirements;
   if (!state) return true;
 
   state_ptr = state;
   state_ptr->config = config;
-  void *array_block = (void *) ((u64 *) state + struct_requirements);
+  void *array_block = (void *) ((u8 *) state + struct_requirements);
   state_ptr->registered_textures = array_block;
-  void *hash_table_block = (void *) ((u64 *) array_block + array_requirements);
-  hash_table_create(sizeof(texture_ref),
-                    config.max_texture_count,
-                    hash_table_block,
-                    false,
-                    &state_ptr->registered_texture_table);
-
-  texture_ref invalid_ref = {
-    .auto_release = false,
-    .handle = INVALID_ID,
-    .ref_count = 0
-  };
-  hash_table_fill(&state_ptr->registered_texture_table, &invalid_ref);
+  void *ref_array_block = (void *) ((u8 *) array_block + array_requirements);
+  state_ptr->registered_texture_refs = ref_array_block;
+  void *pool_block = (void *) ((u8 *) ref_array_block + ref_array_requirements);
+  handle_pool_create(config.max_texture_count, &pool_requirements, pool_block, &state_ptr->texture_pool);
+  state_ptr->pending_loads = (job_counter) {0};
+  state_ptr->completed_loads = 0;
+  platform_mutex_create(&state_ptr->completed_mutex);
+
+  for (u32 i = 0; i < KNAME_MAX_COUNT; ++i) {
+    state_ptr->registered_texture_refs[i].auto_release = false;
+    state_ptr->registered_texture_refs[i].handle = KHANDLE_INVALID;
+    state_ptr->registered_texture_refs[i].ref_count = 0;
+  }
   for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
     state_ptr->registered_textures[i].id = INVALID_ID;
     state_ptr->registered_textures[i].generation = INVALID_ID;
@@ -180,61 +241,143 @@ void texture_system_shutdown(void *state) {
   (void) state;  // Unused parameter
 
   if (!state_ptr) return;
+  // Let in-flight decodes finish, then drop them without uploading
+  job_system_wait(&state_ptr->pending_loads);
+  while (state_ptr->completed_loads) {
+    texture_load_request *request = state_ptr->completed_loads;
+    state_ptr->completed_loads = request->next;
+    free_load_request(request);
+  }
+  platform_mutex_destroy(&state_ptr->completed_mutex);
   for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
     texture *t = &state_ptr->registered_textures[i];
     if (t->generation != INVALID_ID) renderer_destroy_texture(t);
   }
   destroy_fallback_textures(state_ptr);
+  handle_pool_destroy(&state_ptr->texture_pool);
   state_ptr = 0;
 }
 
-texture *texture_system_get(const char *name, b8 auto_release) {
-  if (kstrcmpi(name, FALLBACK_TEXTURE_NAME)) {
-    KWARN("texture_system_get :: called for fallback texture (use `texture_system_get_fallback` instead)");
-    return &state_ptr->fallback_texture;
-  }
+static b8 load_texture_async(kname name, khandle handle, texture *t) {
+  texture_load_request *request = kallocate(sizeof(texture_load_request), MEMORY_TAG_TEXTURE);
+  request->handle = handle;
+  request->name = name;
+  request->name_str = kname_str(name);
+  // Renders as the fallback (`INVALID_ID` generation) until `texture_system_update` uploads it
+  t->name = name;
+  t->generation = INVALID_ID;
+  job_system_submit(texture_decode_job, request, &state_ptr->pending_loads);
+  return true;
+}
 
-  texture_ref ref;
-  if (!state_ptr || !hash_table_get(&state_ptr->registered_texture_table,
-                                    name,
-                                    &ref)) {
-    KERROR("texture_system_get :: failed to get texture '%s'", name);
-    return 0;
+static khandle acquire_texture(kname name, b8 auto_release, b8 async) {
+  if (!state_ptr || name == KNAME_NONE || name == KNAME_FALLBACK) {
+    KERROR("texture_system_get_handle :: failed to get texture '%s'", kname_str(name));
+    return KHANDLE_INVALID;
   }
 
-  if (!ref.ref_count) ref.auto_release = auto_release;
-  ++ref.ref_count;
-  if (ref.handle == INVALID_ID) {
-    texture *t = 0;
-    for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
-      if (state_ptr->registered_textures[i].id == INVALID_ID) {
-        ref.handle = i;
-        t = &state_ptr->registered_textures[i];
-        break;
-      }
-    }
-    if (!t || ref.handle == INVALID_ID) {
+  texture_ref *ref = &state_ptr->registered_texture_refs[name];
+  if (!ref->ref_count) ref->auto_release = auto_release;
+  ++ref->ref_count;
+  if (khandle_is_invalid(ref->handle)) {
+    if (!handle_pool_acquire(&state_ptr->texture_pool, &ref->handle)) {
+      --ref->ref_count;
       KFATAL("texture_system_get :: texture system is full (adjust config to allow more textures)");
-      return 0;
+      return KHANDLE_INVALID;
     }
-    if (!load_texture(name, t)) {
-      KERROR("texture_system_get :: failed to load texture '%s'", name);
-      return 0;
+    texture *t = &state_ptr->registered_textures[ref->handle.index];
+    t->id = ref->handle.index;
+    if (!(async ? load_texture_async(name, ref->handle, t) : load_texture(name, t))) {
+      --ref->ref_count;
+      handle_pool_release(&state_ptr->texture_pool, ref->handle);
+      ref->handle = KHANDLE_INVALID;
+      t->id = INVALID_ID;
+      KERROR("texture_system_get :: failed to load texture '%s'", kname_str(name));
+      return KHANDLE_INVALID;
     }
 
-    t->id = ref.handle;
     KTRACE("Texture '%s' created (does not exists yet). `ref_count` -> %i",
-           name,
-           ref.ref_count);
+           kname_str(name),
+           ref->ref_count);
   }
   else {
     KTRACE("Texture '%s' already exists. `ref_count` -> %i",
-           name,
-           ref.ref_count);
+           kname_str(name),
+           ref->ref_count);
+  }
+  return ref->handle;
+}
+
+texture *texture_system_get(const char *name, b8 auto_release) {
+  return texture_system_get_kname(kname_create(name), auto_release);
+}
+
+texture *texture_system_get_kname(kname name, b8 auto_release) {
+  if (state_ptr && name == KNAME_FALLBACK) {
+    KWARN("texture_system_get :: called for fallback texture (use `texture_system_get_fallback` instead)");
+    return &state_ptr->fallback_texture;
+  }
+  return texture_system_resolve(texture_system_get_handle(name, auto_release));
+}
+
+khandle texture_system_get_handle(kname name, b8 auto_release) {
+  return acquire_texture(name, auto_release, false);
+}
+
+texture *texture_system_get_async(const char *name, b8 auto_release) {
+  return texture_system_get_async_kname(kname_create(name), auto_release);
+}
+
+texture *texture_system_get_async_kname(kname name, b8 auto_release) {
+  if (state_ptr && name == KNAME_FALLBACK) {
+    KWARN("texture_system_get_async :: called for fallback texture (use `texture_system_get_fallback` instead)");
+    return &state_ptr->fallback_texture;
   }
-  // Update entry
-  hash_table_set(&state_ptr->registered_texture_table, name, &ref);
-  return &state_ptr->registered_textures[ref.handle];
+  return texture_system_resolve(acquire_texture(name, auto_release, true));
+}
+
+void texture_system_update(void) {
+  if (!state_ptr) return;
+  // Without worker threads nobody else picks up the decodes, so run one per update
+  if (job_system_worker_count() == 1) job_system_try_run();
+
+  platform_mutex_lock(&state_ptr->completed_mutex);
+  texture_load_request *request = state_ptr->completed_loads;
+  state_ptr->completed_loads = 0;
+  platform_mutex_unlock(&state_ptr->completed_mutex);
+
+  u32 upload_count = 0;
+  while (request && upload_count < TEXTURE_SYSTEM_MAX_UPLOADS_PER_UPDATE) {
+    texture_load_request *next = request->next;
+    // The texture may have been released (and its slot reused) while decoding
+    if (!handle_pool_is_valid(&state_ptr->texture_pool, request->handle)) {
+      KTRACE("Texture '%s' released before its async load finished", request->name_str);
+    }
+    else if (!request->decoded) {
+      KERROR("texture_system_update :: failed to load texture '%s' (keeping the fallback)", request->name_str);
+    }
+    else {
+      texture *t = &state_ptr->registered_textures[request->handle.index];
+      upload_texture(request->name, request->img_resource.data, request->has_transparency, t);
+      ++upload_count;
+    }
+    free_load_request(request);
+    request = next;
+  }
+  if (!request) return;
+
+  // Over budget: hand the rest back for the next update
+  texture_load_request *tail = request;
+  while (tail->next) tail = tail->next;
+  platform_mutex_lock(&state_ptr->completed_mutex);
+  tail->next = state_ptr->completed_loads;
+  state_ptr->completed_loads = request;
+  platform_mutex_unlock(&state_ptr->completed_mutex);
+}
+
+texture *texture_system_resolve(khandle handle) {
+  if (!state_ptr || !handle_pool_is_valid(&state_ptr->texture_pool, handle)) return 0;
+  return &state_ptr->registered_textures[handle.index];
 }
 
 texture *texture_system_get_fallback(void) {
@@ -244,38 +387,44 @@ texture *texture_system_get_fallback(void) {
 }
 
 void texture_system_release(const char *name) {
-  if (kstrcmpi(name, FALLBACK_TEXTURE_NAME)) return;
+  texture_system_release_kname(kname_find(name));
+}
 
-  texture_ref ref;
-  if (!state_ptr || !hash_table_get(&state_ptr->registered_texture_table,
-                                    name,
-                                    &ref)) {
-    KERROR("texture_system_release :: failed to release texture '%s'", name);
+void texture_system_release_handle(khandle handle) {
+  texture *t = texture_system_resolve(handle);
+  if (!t) {
+    KWARN("texture_system_release_handle :: stale or invalid texture handle");
     return;
   }
+  texture_system_release_kname(t->name);
+}
 
-  if (!ref.ref_count) {
-    KWARN("Tried to release non-existant texture ('%s')", name);
+void texture_system_release_kname(kname name) {
+  if (!state_ptr) {
+    KERROR("texture_system_release :: failed to release texture '%s'", kname_str(name));
     return;
   }
+  if (name == KNAME_FALLBACK) return;
 
-  char name_cp[TEXTURE_NAME_MAX_LEN];
-  kstrncp(name_cp, name, TEXTURE_NAME_MAX_LEN);
+  texture_ref *ref = &state_ptr->registered_texture_refs[name];
+  if (name == KNAME_NONE || !ref->ref_count) {
+    KWARN("Tried to release non-existant texture ('%s')", kname_str(name));
+    return;
+  }
 
-  --ref.ref_count;
-  if (!ref.ref_count && ref.auto_release) {
-    texture *t = &state_ptr->registered_textures[ref.handle];
+  --ref->ref_count;
+  if (!ref->ref_count && ref->auto_release) {
+    texture *t = &state_ptr->registered_textures[ref->handle.index];
     destroy_texture(t);
-    ref.handle = INVALID_ID;
-    ref.auto_release = false;
-    KTRACE("Texture '%s' released (`ref_count` -> 0 && `auto_release` -> true)", name_cp);
+    handle_pool_release(&state_ptr->texture_pool, ref->handle);
+    ref->handle = KHANDLE_INVALID;
+    ref->auto_release = false;
+    KTRACE("Texture '%s' released (`ref_count` -> 0 && `auto_release` -> true)", kname_str(name));
   }
   else {
     KTRACE("Texture '%s' released (`ref_count` -> %i && `auto_release` -> %s)",
-           name_cp,
-           ref.ref_count,
-           ref.auto_release ? "true" : "false");
+           kname_str(name),
+           ref->ref_count,
+           ref->auto_release ? "true" : "false");
   }
-  // Update entry
-  hash_table_set(&state_ptr->registered_texture_table, name_cp, &ref);
 }
@@ -19,6 +19,7 @@
  */
 
 
+#include <kimage.h>
 #include <logger.h>
 #include <darray.h>
 #include <kstring.h>
@@ -30,13 +31,19 @@
 #include <vulkan_image.h>
 #include <vulkan_device.h>
 #include <vulkan_buffer.h>
+#include <vulkan_memory.h>
 #include <vulkan_backend.h>
 #include <vulkan_platform.h>
 #include <material_system.h>
+#include <vulkan_bindless.h>
 #include <vulkan_swapchain.h>
 #include <vulkan_ui_shader.h>
 #include <vulkan_renderpass.h>
+#include <vulkan_staging_ring.h>
+#include <vulkan_sampler_cache.h>
+#include <vulkan_pipeline_cache.h>
 #include <vulkan_command_buffer.h>
+#include <vulkan_deletion_queue.h>
 #include <vulkan_material_shader.h>
 
 static vulkan_context context;
@@ -91,7 +98,6 @@ b8 create_buffers(vulkan_context *context) {
     KERROR("create_buffers :: vertex buffer creation failed");
     return false;
   }
-  context->geometry_vertex_offset = 0;
 
   // Geometry index buffer
   const u64 index_buf_size = sizeof(u32) * 1024 * 1024;
@@ -104,35 +110,113 @@ b8 create_buffers(vulkan_context *context) {
     KERROR("create_buffers :: index buffer creation failed");
     return false;
   }
-  context->geometry_index_offset = 0;
+
+  // Both sub-allocators share one block (the vertex list is first)
+  u64 vertex_list_requirements = 0;
+  u64 index_list_requirements = 0;
+  free_list_create_with_max_entries(vertex_buf_size, VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES, &vertex_list_requirements, 0, 0);
+  free_list_create_with_max_entries(index_buf_size, VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES, &index_list_requirements, 0, 0);
+  context->geometry_free_list_block = kallocate(vertex_list_requirements + index_list_requirements, MEMORY_TAG_RENDERER);
+  free_list_create_with_max_entries(vertex_buf_size,
+                                    VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES,
+                                    &vertex_list_requirements,
+                                    context->geometry_free_list_block,
+                                    &context->object_vertex_free_list);
+  free_list_create_with_max_entries(index_buf_size,
+                                    VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES,
+                                    &index_list_requirements,
+                                    (u8 *) context->geometry_free_list_block + vertex_list_requirements,
+                                    &context->object_index_free_list);
+  context->pending_geometry_free_count = 0;
 
   return true;
 }
 
-void create_command_buffers(renderer_backend *backend) {
-  (void) backend;  // Unused parameter
-
-  if (!context.graphics_command_buffers) {
-    context.graphics_command_buffers = darray_reserve(vulkan_command_buffer,
-                                                      context.swapchain.image_count);
-    for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-      kzero_memory(&context.graphics_command_buffers[i], sizeof(vulkan_command_buffer));
-    }
-  }
+void destroy_buffers(vulkan_context *context) {
+  u64 vertex_list_requirements = 0;
+  u64 index_list_requirements = 0;
+  free_list_create_with_max_entries(context->object_vertex_buffer.total_size,
+                                    VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES,
+                                    &vertex_list_requirements,
+                                    0,
+                                    0);
+  free_list_create_with_max_entries(context->object_index_buffer.total_size,
+                                    VULKAN_GEOMETRY_FREE_LIST_MAX_ENTRIES,
+                                    &index_list_requirements,
+                                    0,
+                                    0);
+  free_list_destroy(&context->object_vertex_free_list);
+  free_list_destroy(&context->object_index_free_list);
+  kfree(context->geometry_free_list_block,
+        vertex_list_requirements + index_list_requirements,
+        MEMORY_TAG_RENDERER);
+  context->geometry_free_list_block = 0;
+  context->pending_geometry_free_count = 0;
+
+  vulkan_buffer_destroy(context, &context->object_vertex_buffer);
+  vulkan_buffer_destroy(context, &context->object_index_buffer);
+}
 
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    if (context.graphics_command_buffers[i].handle) {
-      vulkan_command_buffer_free(&context,
-                                 context.device.graphics_command_pool,
-                                 &context.graphics_command_buffers[i]);
-    }
-    kzero_memory(&context.graphics_command_buffers[i], sizeof(vulkan_command_buffer));
+void create_frames(void) {
+  // Timeline semaphore signaled with increasing values, one per submitted frame
+  VkSemaphoreTypeCreateInfo timeline_type_info = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+    .initialValue = 0
+  };
+  VkSemaphoreCreateInfo timeline_create_info = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    .pNext = &timeline_type_info
+  };
+  VK_CHECK(vkCreateSemaphore(context.device.logical_device,
+                             &timeline_create_info,
+                             context.allocator,
+                             &context.frame_timeline));
+  context.frame_timeline_value = 0;
+
+  VkCommandPoolCreateInfo pool_create_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .queueFamilyIndex = context.device.graphics,
+    .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+  };
+  VkSemaphoreCreateInfo semaphore_create_info = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+  };
+  for (u32 i = 0; i < context.frame_count; ++i) {
+    vulkan_frame *frame = &context.frames[i];
+    kzero_memory(frame, sizeof(vulkan_frame));
+    VK_CHECK(vkCreateCommandPool(context.device.logical_device,
+                                 &pool_create_info,
+                                 context.allocator,
+                                 &frame->command_pool));
     vulkan_command_buffer_allocate(&context,
-                                   context.device.graphics_command_pool,
+                                   frame->command_pool,
                                    true,
-                                   &context.graphics_command_buffers[i]);
+                                   &frame->command_buffer);
+    VK_CHECK(vkCreateSemaphore(context.device.logical_device,
+                               &semaphore_create_info,
+                               context.allocator,
+                               &frame->image_available_semaphore));
+  }
+  KDEBUG("Vulkan frames in flight created (%u)", context.frame_count);
+}
+
+void destroy_frames(void) {
+  for (u32 i = 0; i < context.frame_count; ++i) {
+    vulkan_frame *frame = &context.frames[i];
+    vkDestroySemaphore(context.device.logical_device,
+                       frame->image_available_semaphore,
+                       context.allocator);
+    // Freed along with the pool
+    vkDestroyCommandPool(context.device.logical_device,
+                         frame->command_pool,
+                         context.allocator);
+    kzero_memory(frame, sizeof(vulkan_frame));
   }
-  KDEBUG("Vulkan command buffers created");
+  vkDestroySemaphore(context.device.logical_device,
+                     context.frame_timeline,
+                     context.allocator);
+  context.frame_timeline = 0;
 }
 
 void regenerate_framebuffers(void) {
@@ -155,7 +239,7 @@ void regenerate_framebuffers(void) {
     VK_CHECK(vkCreateFramebuffer(context.device.logical_device,
                                  &framebuffer_create_info,
                                  context.allocator,
-                                 &context.world_framebuffers[i]));
+                                 &context.swapchain.world_framebuffers[i]));
 
     // UI renderpass
     VkImageView ui_attachments[] = { context.swapchain.views[i] };
@@ -176,108 +260,152 @@ void regenerate_framebuffers(void) {
 }
 
 b8 recreate_swapchain(renderer_backend *backend) {
+  (void) backend;  // Unused parameter
+
   if (context.recreating_swapchain) {
     KDEBUG("recreate_swapchain :: Already recreating");
     return false;
   }
-  if (context.framebuffer_width == 0 || context.framebuffer_height == 0) {
+  // Resizes use the size from the event, out of date swapchains (e.g. a rotation) the current one
+  b8 resized = context.framebuffer_size_generation != context.framebuffer_size_last_generation;
+  u32 width = resized ? cached_framebuffer_width : context.framebuffer_width;
+  u32 height = resized ? cached_framebuffer_height : context.framebuffer_height;
+  if (width == 0 || height == 0) {
     KDEBUG("recreate_swapchain :: Window is too small to be drawn to");
     return false;
   }
   context.recreating_swapchain = true;
 
-  vkDeviceWaitIdle(context.device.logical_device);
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) context.images_in_flight[i] = 0;
-  vulkan_device_query_swapchain_support(context.device.physical_device,
-                                        context.surface,
-                                        &context.device.swapchain_support);
-  vulkan_device_detect_depth_format(&context.device);
+  // No device wait: frames in flight keep their framebuffers, which retire with them
+  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
+    vulkan_deletion_queue_push_framebuffer(&context.deletion_queue, context.swapchain.world_framebuffers[i]);
+    vulkan_deletion_queue_push_framebuffer(&context.deletion_queue, context.swapchain.framebuffers[i]);
+  }
 
   // Recreate swapchain
   vulkan_swapchain_recreate(&context,
-                            cached_framebuffer_width,
-                            cached_framebuffer_height,
+                            width,
+                            height,
                             &context.swapchain);
-  // Sync framebuffer size with the cached sizes
-  context.framebuffer_width = cached_framebuffer_width;
-  context.framebuffer_height = cached_framebuffer_height;
+  // The surface may not allow the requested size
+  context.framebuffer_width = context.swapchain.extent.width;
+  context.framebuffer_height = context.swapchain.extent.height;
   cached_framebuffer_width = 0;
   cached_framebuffer_height = 0;
-  context.main_renderpass.render_area.z = context.framebuffer_width;
-  context.main_renderpass.render_area.w = context.framebuffer_height;
   // Sync framebuffer size generation
   context.framebuffer_size_last_generation = context.framebuffer_size_generation;
-
-  // Cleanup framebuffers and command buffers
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    vulkan_command_buffer_free(&context,
-                               context.device.graphics_command_pool,
-                               &context.graphics_command_buffers[i]);
-  }
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    vkDestroyFramebuffer(context.device.logical_device,
-                         context.world_framebuffers[i],
-                         context.allocator);
-    vkDestroyFramebuffer(context.device.logical_device,
-                         context.swapchain.framebuffers[i],
-                         context.allocator);
-  }
+  context.present_config_dirty = false;
 
   context.main_renderpass.render_area.x = 0;
   context.main_renderpass.render_area.y = 0;
   context.main_renderpass.render_area.z = context.framebuffer_width;
   context.main_renderpass.render_area.w = context.framebuffer_height;
+  context.ui_renderpass.render_area.z = context.framebuffer_width;
+  context.ui_renderpass.render_area.w = context.framebuffer_height;
 
-  // Recreate framebuffers and command buffers
+  // Recreate framebuffers, frames in flight do not depend on the swapchain
   regenerate_framebuffers();
-  create_command_buffers(backend);
 
   context.recreating_swapchain = false;
   return true;
 }
 
-void upload_data_range(vulkan_context *context,
-                       VkCommandPool pool,
-                       VkFence fence,
-                       VkQueue queue,
-                       vulkan_buffer *buffer,
-                       u64 offset,
-                       u64 size,
-                       const void *data) {
-  VkBufferUsageFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-  vulkan_buffer tmp_buf;
-  // Create temporal buffer
-  vulkan_buffer_create(context,
-                       size,
-                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                       flags,
-                       true,
-                       &tmp_buf);
-  // Load data into temporal buffer
-  vulkan_buffer_load(context, &tmp_buf, 0, size, 0, data);
-  // Copy data from temporal buffer to device local buffer
-  vulkan_buffer_copy(context,
-                     pool,
-                     fence,
-                     queue,
-                     tmp_buf.handle,
-                     0,
-                     buffer->handle,
-                     offset,
-                     size);
-  // Destroy temporal buffer
-  vulkan_buffer_destroy(context, &tmp_buf);
+b8 allocate_data_range(vulkan_buffer *buffer, free_list *list, u32 size, u32 *out_offset) {
+  if (free_list_alloc(list, size, out_offset)) return true;
+
+  // Grow the buffer (at least doubling it), the new space is appended to the free list
+  u64 new_size = buffer->total_size * 2;
+  if (new_size < buffer->total_size + size) new_size = buffer->total_size + size;
+  if (new_size > 0xFFFFFFFFull) {
+    KERROR("allocate_data_range :: geometry buffer cannot grow past 4GiB (requested: %u B)", size);
+    return false;
+  }
+  KINFO("Growing geometry buffer (%llu B -> %llu B)", buffer->total_size, new_size);
+  // Pending uploads were recorded against the current buffer handle
+  vulkan_staging_ring_flush(&context, &context.staging_ring);
+  if (!vulkan_buffer_resize(&context, new_size, buffer)) {
+    KERROR("allocate_data_range :: geometry buffer resize failed");
+    return false;
+  }
+  // Later draws of this pass must bind the new handle
+  context.bind_state.vertex_buffer_bound = false;
+  context.bind_state.index_buffer_bound = false;
+  free_list_resize(list, new_size);
+  return free_list_alloc(list, size, out_offset);
 }
 
-void free_data_range(vulkan_buffer *buffer, u64 offset, u64 size) {
-  (void) buffer;  // Unused parameter
-  (void) offset;  // Unused parameter
-  (void) size;    // Unused parameter
-  
-  // TODO: implement this with a free list
+void free_data_range(free_list *list, u32 offset, u32 size) {
+  if (!size) return;
+  if (!free_list_free(list, size, offset)) {
+    KWARN("free_data_range :: failed to free range (offset: %u B, size: %u B)", offset, size);
+  }
+}
+
+void process_pending_geometry_frees(void) {
+  for (u32 i = 0; i < context.pending_geometry_free_count;) {
+    vulkan_geometry_pending_free *pending = &context.pending_geometry_frees[i];
+    if (!vulkan_staging_ring_is_complete(&context, &context.staging_ring, pending->serial)) {
+      ++i;
+      continue;
+    }
+    free_data_range(pending->list, pending->offset, pending->size);
+    *pending = context.pending_geometry_frees[--context.pending_geometry_free_count];
+  }
 }
 
-b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *application_name) {
+// Moves the highest live range into the first hole below it, returns false once nothing can move
+b8 compact_geometry_buffer(vulkan_buffer *buffer, free_list *list, b8 index_data) {
+  if (context.pending_geometry_free_count == VULKAN_GEOMETRY_MAX_PENDING_FREES) return false;
+
+  vulkan_geometry_data *highest = 0;
+  u32 highest_offset = 0;
+  u32 highest_size = 0;
+  for (u32 i = 0; i < GEOMETRY_MAX_COUNT; ++i) {
+    vulkan_geometry_data *g = &context.geometries[i];
+    if (g->id == INVALID_ID) continue;
+    u32 offset = index_data ? g->index_buffer_offset : g->vertex_buffer_offset;
+    u32 size = index_data ? g->index_element_size * g->index_count : g->vertex_element_size * g->vertex_count;
+    if (size && (!highest || offset > highest_offset)) {
+      highest = g;
+      highest_offset = offset;
+      highest_size = size;
+    }
+  }
+
+  u32 new_offset;
+  if (!highest || !free_list_alloc_below(list, highest_size, highest_offset, &new_offset)) return false;
+
+  u64 serial = vulkan_staging_ring_copy_buffer(&context,
+                                               &context.staging_ring,
+                                               buffer,
+                                               highest_offset,
+                                               buffer,
+                                               new_offset,
+                                               highest_size);
+  // Frames recorded from now on use the new range, the old one is freed once the copy has run
+  if (index_data) highest->index_buffer_offset = new_offset;
+  else highest->vertex_buffer_offset = new_offset;
+  context.pending_geometry_frees[context.pending_geometry_free_count++] = (vulkan_geometry_pending_free) {
+    .list = list,
+    .serial = serial,
+    .offset = highest_offset,
+    .size = highest_size
+  };
+  return true;
+}
+
+void defragment_geometry_buffers(u32 max_moves) {
+  process_pending_geometry_frees();
+  for (u32 i = 0; i < max_moves; ++i) {
+    b8 moved = compact_geometry_buffer(&context.object_vertex_buffer, &context.object_vertex_free_list, false);
+    moved |= compact_geometry_buffer(&context.object_index_buffer, &context.object_index_free_list, true);
+    if (!moved) break;
+  }
+}
+
+b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const renderer_system_config *config) {
+  (void) backend;  // Unused parameter
+
   // Set the `find_memory_index` function pointer to its definition
   context.find_memory_index = find_memory_index;
 
@@ -294,7 +422,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *app
   VkApplicationInfo app_info = {
     .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
     .apiVersion = VK_API_VERSION_1_2,
-    .pApplicationName = application_name,
+    .pApplicationName = config->application_name,
     .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
     .pEngineName = "Wildebeest Game Engine™",
     .engineVersion = VK_MAKE_VERSION(1, 0, 0)
@@ -392,11 +520,25 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *app
     return false;
   }
 
+  // Create device memory allocator
+  if (!vulkan_memory_allocator_create(&context, &context.memory_allocator)) {
+    KERROR("Failed to create the device memory allocator");
+    return false;
+  }
+  vulkan_sampler_cache_create(&context.sampler_cache);
+  vulkan_pipeline_cache_create(&context, &context.pipeline_cache);
+  if (!vulkan_bindless_textures_create(&context, &context.bindless_textures)) {
+    KERROR("Failed to create the bindless texture table");
+    return false;
+  }
+
   // Create swapchain
+  vulkan_renderer_backend_set_present_config(backend, &config->present);
   vulkan_swapchain_create(&context,
                           context.framebuffer_width,
                           context.framebuffer_height,
                           &context.swapchain);
+  context.present_config_dirty = false;
 
   // Create world renderpass
   vulkan_renderpass_create(&context,
@@ -444,40 +586,11 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *app
   // Create swapchain and world framebuffers
   regenerate_framebuffers();
 
-  // Create command buffers
-  create_command_buffers(backend);
-
-  // Create semaphores & fences
-  context.image_available_semaphores = darray_reserve(VkSemaphore,
-                                                      context.swapchain.max_frames_in_flight);
-  context.queue_complete_semaphores = darray_reserve(VkSemaphore,
-                                                     context.swapchain.max_frames_in_flight);
-
-  for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
-    VkSemaphoreCreateInfo semaphore_create_info = {
-      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
-    };
-    // Semaphores
-    vkCreateSemaphore(context.device.logical_device,
-                      &semaphore_create_info,
-                      context.allocator,
-                      &context.image_available_semaphores[i]);
-    vkCreateSemaphore(context.device.logical_device,
-                      &semaphore_create_info,
-                      context.allocator,
-                      &context.queue_complete_semaphores[i]);
-    // Fences
-    VkFenceCreateInfo fence_create_info = {
-      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-      .flags = VK_FENCE_CREATE_SIGNALED_BIT
-    };
-    VK_CHECK(vkCreateFence(context.device.logical_device,
-                           &fence_create_info,
-                           context.allocator,
-                           &context.in_flight_fences[i]));
-  }
-
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) context.images_in_flight[i] = 0;
+  // Create frames in flight
+  u8 frames_in_flight = config->frames_in_flight ? config->frames_in_flight : VULKAN_DEFAULT_FRAMES_IN_FLIGHT;
+  context.frame_count = KCLAMP(frames_in_flight, 1, FRAME_DESCRIPTOR_COUNT);
+  context.current_frame = 0;
+  create_frames();
 
   // Create builtin shaders
   if (!vulkan_material_shader_create(&context, &context.material_shader)) {
@@ -491,9 +604,21 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend, const char *app
 
   // Create vertex and index buffers
   create_buffers(&context);
+  if (!vulkan_staging_ring_create(&context, VULKAN_STAGING_RING_SIZE, &context.staging_ring)) {
+    KERROR("Failed to create the staging ring");
+    return false;
+  }
+  vulkan_deletion_queue_create(&context.deletion_queue);
 
   // Mark all geometries as invalid
   for (u32 i = 0; i < GEOMETRY_MAX_COUNT; ++i) context.geometries[i].id = INVALID_ID;
+  u64 geometry_pool_requirements = 0;
+  handle_pool_create(GEOMETRY_MAX_COUNT, &geometry_pool_requirements, 0, 0);
+  context.geometry_pool_block = kallocate(geometry_pool_requirements, MEMORY_TAG_RENDERER);
+  handle_pool_create(GEOMETRY_MAX_COUNT,
+                     &geometry_pool_requirements,
+                     context.geometry_pool_block,
+                     &context.geometry_pool);
 
   darray_destroy(vk_extensions);
 
@@ -507,53 +632,25 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
   vkDeviceWaitIdle(context.device.logical_device);
 
   // Destroy vertex and index buffers
-  vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
-  vulkan_buffer_destroy(&context, &context.object_index_buffer);
+  vulkan_staging_ring_destroy(&context, &context.staging_ring);
+  vulkan_deletion_queue_destroy(&context, &context.deletion_queue);
+  destroy_buffers(&context);
+  u64 geometry_pool_requirements = 0;
+  handle_pool_create(GEOMETRY_MAX_COUNT, &geometry_pool_requirements, 0, 0);
+  handle_pool_destroy(&context.geometry_pool);
+  kfree(context.geometry_pool_block, geometry_pool_requirements, MEMORY_TAG_RENDERER);
+  context.geometry_pool_block = 0;
 
   vulkan_ui_shader_destroy(&context, &context.ui_shader);
   vulkan_material_shader_destroy(&context, &context.material_shader);
 
-  // Destroy semaphores & fences
-  for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
-    // Semaphores
-    if (context.image_available_semaphores[i]) {
-      vkDestroySemaphore(context.device.logical_device,
-                         context.image_available_semaphores[i],
-                         context.allocator);
-      context.image_available_semaphores[i] = 0;
-    }
-    if (context.queue_complete_semaphores[i]) {
-      vkDestroySemaphore(context.device.logical_device,
-                         context.queue_complete_semaphores[i],
-                         context.allocator);
-      context.queue_complete_semaphores[i] = 0;
-    }
-    // Fences
-    vkDestroyFence(context.device.logical_device,
-                   context.in_flight_fences[i],
-                   context.allocator);
-  }
-  darray_destroy(context.image_available_semaphores);
-  darray_destroy(context.queue_complete_semaphores);
-  context.image_available_semaphores = 0;
-  context.queue_complete_semaphores = 0;
-
-  // Destroy command buffers
-  for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-    if (context.graphics_command_buffers[i].handle) {
-      vulkan_command_buffer_free(&context,
-                                 context.device.graphics_command_pool,
-                                 &context.graphics_command_buffers[i]);
-      context.graphics_command_buffers[i].handle = 0;
-    }
-  }
-  darray_destroy(context.graphics_command_buffers);
-  context.graphics_command_buffers = 0;
+  // Destroy frames in flight
+  destroy_frames();
 
   // Destroy swapchain framebuffers
   for (u32 i = 0; i < context.swapchain.image_count; ++i) {
     vkDestroyFramebuffer(context.device.logical_device,
-                         context.world_framebuffers[i],
+                         context.swapchain.world_framebuffers[i],
                          context.allocator);
     vkDestroyFramebuffer(context.device.logical_device,
                          context.swapchain.framebuffers[i],
@@ -567,6 +664,14 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
   // Destroy swapchain
   vulkan_swapchain_destroy(&context, &context.swapchain);
 
+  vulkan_bindless_textures_destroy(&context, &context.bindless_textures);
+  vulkan_sampler_cache_destroy(&context, &context.sampler_cache);
+  vulkan_pipeline_cache_destroy(&context, context.pipeline_cache);
+  context.pipeline_cache = 0;
+
+  // Destroy device memory allocator
+  vulkan_memory_allocator_destroy(&context, &context.memory_allocator);
+
   // Destroy device
   vulkan_device_destroy(&context);
   KDEBUG("Vulkan device destroyed");
@@ -603,51 +708,93 @@ void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width, u1
   KINFO("vulkan_renderer_backend_on_resized :: %ix%i (%llu)", width, height, context.framebuffer_size_generation);
 }
 
+void vulkan_renderer_backend_set_present_config(renderer_backend *backend, const renderer_present_config *config) {
+  (void) backend;  // Unused parameter
+
+  // Swapchain creation indexes its present mode table with it
+  renderer_present_mode mode = config->mode;
+  if ((u32) mode >= RENDERER_PRESENT_MODE_COUNT) {
+    KWARN("vulkan_renderer_backend_set_present_config :: invalid present mode %u (using FIFO)", (u32) mode);
+    mode = RENDERER_PRESENT_MODE_FIFO;
+  }
+  u8 queue_depth = config->queue_depth ? config->queue_depth : VULKAN_DEFAULT_PRESENT_QUEUE_DEPTH;
+  if (queue_depth > VULKAN_MAX_PRESENT_QUEUE_DEPTH) {
+    KWARN("vulkan_renderer_backend_set_present_config :: queue depth %u clamped to %u",
+          queue_depth, VULKAN_MAX_PRESENT_QUEUE_DEPTH);
+    queue_depth = VULKAN_MAX_PRESENT_QUEUE_DEPTH;
+  }
+  // The latency limit applies right away, the rest on the next swapchain recreation
+  if (mode != context.present_mode || queue_depth != context.present_queue_depth) {
+    context.present_mode = mode;
+    context.present_queue_depth = queue_depth;
+    context.present_config_dirty = true;
+  }
+  context.max_frame_latency = config->max_frame_latency;
+  KDEBUG("vulkan_renderer_backend_set_present_config :: mode %u, queue depth %u, max latency %u",
+         mode, queue_depth, config->max_frame_latency);
+}
+
+void vulkan_renderer_backend_wait_for_latency(renderer_backend *backend) {
+  (void) backend;  // Unused parameter
+
+  // Frames allowed to still be on the GPU once the next one starts
+  uint64_t pending = context.max_frame_latency - 1;
+  if (!context.max_frame_latency || context.frame_timeline_value <= pending) return;
+
+  uint64_t value = context.frame_timeline_value - pending;
+  VkSemaphoreWaitInfo wait_info = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+    .semaphoreCount = 1,
+    .pSemaphores = &context.frame_timeline,
+    .pValues = &value
+  };
+  VkResult result = vkWaitSemaphores(context.device.logical_device, &wait_info, UINT64_MAX);
+  if (!vulkan_result_is_success(result)) {
+    KERROR("vulkan_renderer_backend_wait_for_latency :: frame timeline wait failed (%s)",
+           vulkan_result_string(result, true));
+  }
+}
+
 b8 vulkan_renderer_backend_begin_frame(renderer_backend *backend, f32 delta_time) {
   context.frame_delta_time = delta_time;
   vulkan_device *device = &context.device;
 
-  // Swapchain recreation
-  if (context.recreating_swapchain) {
-    VkResult result = vkDeviceWaitIdle(device->logical_device);
-    if (!vulkan_result_is_success(result)) {
-      KERROR("vulkan_renderer_backend_begin_frame (1) :: %s", vulkan_result_string(result, true));
-      return false;
-    }
-    KINFO("Swapchain recreated");
-    return false;
-  }
-
-  if (context.framebuffer_size_generation != context.framebuffer_size_last_generation) {
-    VkResult result = vkDeviceWaitIdle(device->logical_device);
-    if (!vulkan_result_is_success(result)) {
-      KERROR("vulkan_renderer_backend_begin_frame (2) :: %s", vulkan_result_string(result, true));
-      return false;
-    }
+  // Swapchain recreation, this frame already renders to the new images
+  if (context.framebuffer_size_generation != context.framebuffer_size_last_generation ||
+      context.present_config_dirty) {
     if (!recreate_swapchain(backend)) return false;
     KINFO("Swapchain resized");
-    return false;
   }
 
-  VkResult result = vkWaitForFences(context.device.logical_device,
-                                    1,
-                                    &context.in_flight_fences[context.current_frame],
-                                    true,
-                                    UINT64_MAX);
+  // Wait until the GPU is done with the last submission that used this frame's resources
+  vulkan_frame *frame = &context.frames[context.current_frame];
+  VkSemaphoreWaitInfo wait_info = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+    .semaphoreCount = 1,
+    .pSemaphores = &context.frame_timeline,
+    .pValues = &frame->timeline_value
+  };
+  VkResult result = vkWaitSemaphores(device->logical_device, &wait_info, UINT64_MAX);
   if (!vulkan_result_is_success(result)) {
-    KERROR("vulkan_renderer_backend_begin_frame :: `in_flight_fences` wait failed (%s)",
+    KERROR("vulkan_renderer_backend_begin_frame :: frame timeline wait failed (%s)",
            vulkan_result_string(result, true));
     return false;
   }
+  vulkan_deletion_queue_frame_completed(&context, &context.deletion_queue, context.current_frame);
+
+  // An out of date swapchain leaves the semaphore unsignaled, so the acquire can be retried right away
+  for (u32 attempt = 0; !vulkan_swapchain_get_next_image_index(&context,
+                                                               &context.swapchain,
+                                                               UINT64_MAX,
+                                                               frame->image_available_semaphore,
+                                                               0,
+                                                               &context.image_index); ++attempt) {
+    if (attempt || !recreate_swapchain(backend)) return false;
+  }
 
-  if (!vulkan_swapchain_get_next_image_index(&context,
-                                             &context.swapchain,
-                                             UINT64_MAX,
-                                             context.image_available_semaphores[context.current_frame],
-                                             0,
-                                             &context.image_index)) return false;
-
-  vulkan_command_buffer *command_buffer = &context.graphics_command_buffers[context.image_index];
+  // Recycles every allocation made by last use of this frame at once
+  VK_CHECK(vkResetCommandPool(device->logical_device, frame->command_pool, 0));
+  vulkan_command_buffer *command_buffer = &frame->command_buffer;
   vulkan_command_buffer_reset(command_buffer);
   vulkan_command_buffer_begin(command_buffer, false, false, false);
 
@@ -679,7 +826,8 @@ void vulkan_renderer_backend_update_world(Matrix4 proj,
                                           Matrix4 view,
                                           Vector3 view_pos,
                                           Vector4 ambient_color,
-                                          i32 mode) {
+                                          i32 mode,
+                                          u32 instance_count) {
   (void) view_pos;       // Unused parameter
   (void) ambient_color;  // Unused parameter
   (void) mode;           // Unused parameter
@@ -689,7 +837,8 @@ void vulkan_renderer_backend_update_world(Matrix4 proj,
   context.material_shader.global_ubo.view = view;
   vulkan_material_shader_update(&context,
                                 &context.material_shader,
-                                context.frame_delta_time);
+                                context.frame_delta_time,
+                                instance_count);
 }
 
 void vulkan_renderer_backend_update_ui(Matrix4 proj, Matrix4 view, i32 mode) {
@@ -704,59 +853,62 @@ void vulkan_renderer_backend_update_ui(Matrix4 proj, Matrix4 view, i32 mode) {
 }
 
 b8 vulkan_renderer_backend_end_frame(renderer_backend *backend, f32 delta_time) {
-  (void) backend;     // Unused parameter
   (void) delta_time;  // Unused parameter
 
-  vulkan_command_buffer *command_buffer = &context.graphics_command_buffers[context.image_index];
+  vulkan_frame *frame = &context.frames[context.current_frame];
+  vulkan_command_buffer *command_buffer = &frame->command_buffer;
 
   // End the command buffer
   vulkan_command_buffer_end(command_buffer);
 
-  if (context.images_in_flight[context.image_index] != VK_NULL_HANDLE) {
-    VkResult result = vkWaitForFences(context.device.logical_device,
-                                      1,
-                                      context.images_in_flight[context.image_index],
-                                      true,
-                                      UINT64_MAX);
-    if (!vulkan_result_is_success(result)) {
-      KFATAL("vulkan_renderer_backend_end_frame :: `images_in_flight` wait failed (%s)",
-             vulkan_result_string(result, true));
-    }
-  }
-  context.images_in_flight[context.image_index] = &context.in_flight_fences[context.current_frame];
-
-  VK_CHECK(vkResetFences(context.device.logical_device,
-                         1,
-                         &context.in_flight_fences[context.current_frame]));
+  // Submitted ahead of the frame so its draws see this frame's uploads
+  defragment_geometry_buffers(VULKAN_GEOMETRY_DEFRAG_MOVES_PER_FRAME);
+  vulkan_staging_ring_flush(&context, &context.staging_ring);
+
+  // Binary semaphores ignore their timeline values
+  uint64_t timeline_value = context.frame_timeline_value + 1;
+  uint64_t wait_values[] = { 0 };
+  uint64_t signal_values[] = { 0, timeline_value };
+  // Indexed by image, a per-frame one could be re-signaled while an earlier present still waits on it
+  VkSemaphore render_complete_semaphore = context.swapchain.render_complete_semaphores[context.image_index];
+  VkSemaphore signal_semaphores[] = { render_complete_semaphore, context.frame_timeline };
+  VkTimelineSemaphoreSubmitInfo timeline_info = {
+    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    .waitSemaphoreValueCount = 1,
+    .pWaitSemaphoreValues = wait_values,
+    .signalSemaphoreValueCount = 2,
+    .pSignalSemaphoreValues = signal_values
+  };
 
   VkPipelineStageFlags flags[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
   VkSubmitInfo submit_info = {
     .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .pNext = &timeline_info,
     .commandBufferCount = 1,
     .pCommandBuffers = &command_buffer->handle,
-    .signalSemaphoreCount = 1,
-    .pSignalSemaphores = &context.queue_complete_semaphores[context.current_frame],
+    .signalSemaphoreCount = 2,
+    .pSignalSemaphores = signal_semaphores,
     .waitSemaphoreCount = 1,
-    .pWaitSemaphores = &context.image_available_semaphores[context.current_frame],
+    .pWaitSemaphores = &frame->image_available_semaphore,
     .pWaitDstStageMask = flags
   };
-  VkResult result = vkQueueSubmit(context.device.graphics_queue,
-                                  1,
-                                  &submit_info,
-                                  context.in_flight_fences[context.current_frame]);
+  VkResult result = vkQueueSubmit(context.device.graphics_queue, 1, &submit_info, 0);
   if (result != VK_SUCCESS) {
     KERROR("vulkan_renderer_backend_end_frame :: %s", vulkan_result_string(result, true));
     return false;
   }
+  frame->timeline_value = context.frame_timeline_value = timeline_value;
   vulkan_command_buffer_update(command_buffer);
+  vulkan_deletion_queue_frame_submitted(&context.deletion_queue, context.current_frame);
+  context.current_frame = (context.current_frame + 1) % context.frame_count;
 
-  // Present frame to display
-  vulkan_swapchain_present(&context,
-                           &context.swapchain,
-                           context.device.graphics_queue,
-                           context.device.present_queue,
-                           context.queue_complete_semaphores[context.current_frame],
-                           context.image_index);
+  // Present frame to display, the next frame renders to a new swapchain if this one went stale
+  if (!vulkan_swapchain_present(&context,
+                                &context.swapchain,
+                                context.device.graphics_queue,
+                                context.device.present_queue,
+                                render_complete_semaphore,
+                                context.image_index)) recreate_swapchain(backend);
 
   return true;
 }
@@ -764,14 +916,14 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend *backend, f32 delta_time)
 b8 vulkan_renderer_backend_begin_renderpass(renderer_backend *backend, u8 renderpass_id) {
   (void) backend;  // Unused parameter
 
-  vulkan_command_buffer *command_buffer = &context.graphics_command_buffers[context.image_index];
+  vulkan_command_buffer *command_buffer = &context.frames[context.current_frame].command_buffer;
   vulkan_renderpass *renderpass = 0;
   VkFramebuffer framebuffer = 0;
 
   switch (renderpass_id) {
   case BUILTIN_RENDERPASS_WORLD:
     renderpass = &context.main_renderpass;
-    framebuffer = context.world_framebuffers[context.image_index];
+    framebuffer = context.swapchain.world_framebuffers[context.image_index];
     break;
   case BUILTIN_RENDERPASS_UI:
     renderpass = &context.ui_renderpass;
@@ -784,6 +936,7 @@ b8 vulkan_renderer_backend_begin_renderpass(renderer_backend *backend, u8 render
   }
 
   vulkan_renderpass_begin(command_buffer, renderpass, framebuffer);
+  kzero_memory(&context.bind_state, sizeof(vulkan_bind_state));
 
   switch (renderpass_id) {
   case BUILTIN_RENDERPASS_WORLD:
@@ -799,7 +952,7 @@ b8 vulkan_renderer_backend_begin_renderpass(renderer_backend *backend, u8 render
 b8 vulkan_renderer_backend_end_renderpass(renderer_backend *backend, u8 renderpass_id) {
   (void) backend;  // Unused parameter
 
-  vulkan_command_buffer *command_buffer = &context.graphics_command_buffers[context.image_index];
+  vulkan_command_buffer *command_buffer = &context.frames[context.current_frame].command_buffer;
   vulkan_renderpass *renderpass = 0;
 
   switch (renderpass_id) {
@@ -819,65 +972,92 @@ b8 vulkan_renderer_backend_end_renderpass(renderer_backend *backend, u8 renderpa
   return true;
 }
 
-void vulkan_renderer_backend_draw_geometry(geometry_render_data data) {
-  if (data.geometry && data.geometry->internal_id == INVALID_ID) return;
+// Records the binds (skipping what is already bound) and the draw call itself
+void record_draw(vulkan_geometry_data *buf_data, u32 instance_count, u32 first_instance) {
+  vulkan_command_buffer *command_buffer = &context.frames[context.current_frame].command_buffer;
+  vulkan_bind_state *bound = &context.bind_state;
+
+  // Bind vertex buffer (consecutive draws of the same geometry reuse the binding)
+  if (!bound->vertex_buffer_bound || bound->vertex_offset != buf_data->vertex_buffer_offset) {
+    VkDeviceSize offsets[] = { buf_data->vertex_buffer_offset };
+    vkCmdBindVertexBuffers(command_buffer->handle,
+                           0,
+                           1,
+                           &context.object_vertex_buffer.handle,
+                           offsets);
+    bound->vertex_buffer_bound = true;
+    bound->vertex_offset = buf_data->vertex_buffer_offset;
+  }
+  if (buf_data->index_count) {
+    // Bind index buffer once per pass, each draw starts at its own first index
+    if (!bound->index_buffer_bound) {
+      vkCmdBindIndexBuffer(command_buffer->handle,
+                           context.object_index_buffer.handle,
+                           0,
+                           VK_INDEX_TYPE_UINT32);
+      bound->index_buffer_bound = true;
+    }
+    // Draw indexed data
+    vkCmdDrawIndexed(command_buffer->handle,
+                     buf_data->index_count,
+                     instance_count,
+                     buf_data->index_buffer_offset / sizeof(u32),
+                     0,
+                     first_instance);
+  }
+  // Draw non-indexed data
+  else vkCmdDraw(command_buffer->handle,
+                 buf_data->vertex_count,
+                 instance_count,
+                 0,
+                 first_instance);
+}
+
+void vulkan_renderer_backend_draw_geometry(geometry *geometry, const Matrix4 *models, u32 instance_count) {
+  if (!geometry || geometry->internal_id == INVALID_ID || !instance_count) return;
 
-  vulkan_geometry_data *buf_data = &context.geometries[data.geometry->internal_id];
-  vulkan_command_buffer *command_buffer = &context.graphics_command_buffers[context.image_index];
+  vulkan_geometry_data *buf_data = &context.geometries[geometry->internal_id];
 
   material *m = 0;
-  if (data.geometry->material) m = data.geometry->material;
+  if (geometry->material) m = geometry->material;
   else m = material_system_get_fallback();
 
+  vulkan_bind_state *bound = &context.bind_state;
+  b8 bind_material = bound->material != m || bound->material_generation != m->generation;
+  u32 first_instance = 0;
   switch (m->type) {
   case MATERIAL_TYPE_WORLD:
-    vulkan_material_shader_set_model(&context,
-                                     &context.material_shader,
-                                     data.model);
-    vulkan_material_shader_apply_material(&context,
-                                          &context.material_shader,
-                                          m);
+    if (!vulkan_material_shader_push_instances(&context,
+                                               &context.material_shader,
+                                               models,
+                                               instance_count,
+                                               &first_instance)) return;
+    vulkan_material_shader_use_variant(&context,
+                                       &context.material_shader,
+                                       vulkan_material_shader_variant_for(m));
+    if (bind_material) vulkan_material_shader_apply_material(&context,
+                                                             &context.material_shader,
+                                                             m);
+    record_draw(buf_data, instance_count, first_instance);
     break;
   case MATERIAL_TYPE_UI:
-    vulkan_ui_shader_set_model(&context,
-                               &context.ui_shader,
-                               data.model);
-    vulkan_ui_shader_apply_material(&context,
-                                    &context.ui_shader,
-                                    m);
+    if (bind_material) vulkan_ui_shader_apply_material(&context,
+                                                       &context.ui_shader,
+                                                       m);
+    // The UI shader takes its transform as a push constant, one draw per instance
+    for (u32 i = 0; i < instance_count; ++i) {
+      vulkan_ui_shader_set_model(&context,
+                                 &context.ui_shader,
+                                 models[i]);
+      record_draw(buf_data, 1, 0);
+    }
     break;
   default:
     KERROR("vulkan_renderer_backend_draw_geometry :: unknown material type");
     return;
   }
-
-  // Bind vertex buffer
-  VkDeviceSize offsets[] = { buf_data->vertex_buffer_offset };
-  vkCmdBindVertexBuffers(command_buffer->handle,
-                         0,
-                         1,
-                         &context.object_vertex_buffer.handle,
-                         offsets);
-  if (buf_data->index_count) {
-    // Bind index buffer
-    vkCmdBindIndexBuffer(command_buffer->handle,
-                         context.object_index_buffer.handle,
-                         buf_data->index_buffer_offset,
-                         VK_INDEX_TYPE_UINT32);
-    // Draw indexed data
-    vkCmdDrawIndexed(command_buffer->handle,
-                     buf_data->index_count,
-                     1,
-                     0,
-                     0,
-                     0);
-  }
-  // Draw non-indexed data
-  else vkCmdDraw(command_buffer->handle,
-                 buf_data->vertex_count,
-                 1,
-                 0,
-                 0);
+  bound->material = m;
+  bound->material_generation = m->generation;
 }
 
 b8 vulkan_renderer_backend_create_geometry(geometry *geometry,
@@ -907,12 +1087,11 @@ b8 vulkan_renderer_backend_create_geometry(geometry *geometry,
     };
   }
   else {
-    for (u32 i = 0; i < GEOMETRY_MAX_COUNT; ++i) {
-      if (context.geometries[i].id != INVALID_ID) continue;
-      geometry->internal_id = i;
-      context.geometries[i].id = i;
-      internal_data = &context.geometries[i];
-      break;
+    khandle handle;
+    if (handle_pool_acquire(&context.geometry_pool, &handle)) {
+      geometry->internal_id = handle.index;
+      context.geometries[handle.index].id = handle.index;
+      internal_data = &context.geometries[handle.index];
     }
   }
 
@@ -921,53 +1100,68 @@ b8 vulkan_renderer_backend_create_geometry(geometry *geometry,
     return false;
   }
 
-  VkCommandPool pool = context.device.graphics_command_pool;
-  VkQueue queue = context.device.graphics_queue;
+  // Reserve both ranges first, so a failure leaves the geometry untouched
+  u32 vertex_size_total = vertex_count * vertex_size;
+  u32 index_size_total = (index_count && indices) ? index_count * index_size : 0;
+  u32 vertex_offset = 0;
+  u32 index_offset = 0;
+  b8 allocated = allocate_data_range(&context.object_vertex_buffer,
+                                     &context.object_vertex_free_list,
+                                     vertex_size_total,
+                                     &vertex_offset);
+  if (allocated && index_size_total &&
+      !allocate_data_range(&context.object_index_buffer,
+                           &context.object_index_free_list,
+                           index_size_total,
+                           &index_offset)) {
+    free_data_range(&context.object_vertex_free_list, vertex_offset, vertex_size_total);
+    allocated = false;
+  }
+  if (!allocated) {
+    KERROR("vulkan_renderer_backend_create_geometry :: failed to allocate geometry buffer space");
+    if (!is_reupload) {
+      internal_data->id = INVALID_ID;
+      handle_pool_release(&context.geometry_pool,
+                          handle_pool_from_index(&context.geometry_pool, geometry->internal_id));
+      geometry->internal_id = INVALID_ID;
+    }
+    return false;
+  }
 
   // Vertex data
-  internal_data->vertex_buffer_offset = context.geometry_vertex_offset;
+  internal_data->vertex_buffer_offset = vertex_offset;
   internal_data->vertex_count = vertex_count;
-  internal_data->vertex_element_size = sizeof(vertex_3d);
-  u32 total_size = vertex_count * vertex_size;
-  upload_data_range(&context,
-                    pool,
-                    0,
-                    queue,
-                    &context.object_vertex_buffer,
-                    internal_data->vertex_buffer_offset,
-                    total_size,
-                    vertices);
-  context.geometry_vertex_offset += total_size;
+  internal_data->vertex_element_size = vertex_size;
+  vulkan_staging_ring_upload_buffer(&context,
+                                    &context.staging_ring,
+                                    &context.object_vertex_buffer,
+                                    vertex_offset,
+                                    vertex_size_total,
+                                    vertices);
 
   // Index data
-  if (index_count && indices) {
-    internal_data->index_buffer_offset = context.geometry_index_offset;
-    internal_data->index_count = index_count;
-    internal_data->index_element_size = sizeof(u32);
-    total_size = index_count * index_size;
-    upload_data_range(&context,
-                      pool,
-                      0,
-                      queue,
-                      &context.object_index_buffer,
-                      internal_data->index_buffer_offset,
-                      total_size,
-                      indices);
-    context.geometry_index_offset += total_size;
-  }
+  internal_data->index_buffer_offset = index_offset;
+  internal_data->index_count = index_size_total ? index_count : 0;
+  internal_data->index_element_size = index_size_total ? index_size : 0;
+  vulkan_staging_ring_upload_buffer(&context,
+                                    &context.staging_ring,
+                                    &context.object_index_buffer,
+                                    index_offset,
+                                    index_size_total,
+                                    indices);
 
   if (internal_data->generation == INVALID_ID) internal_data->generation = 0;
   else ++internal_data->generation;
 
   if (is_reupload) {
-    free_data_range(&context.object_vertex_buffer,
-                    old_range.vertex_buffer_offset,
-                    old_range.vertex_element_size * old_range.vertex_count);
-    if (old_range.index_element_size) {
-      free_data_range(&context.object_index_buffer,
-                      old_range.index_buffer_offset,
-                      old_range.index_element_size * old_range.index_count);
-    }
+    vulkan_deletion_queue_push_range(&context.deletion_queue,
+                                     &context.object_vertex_free_list,
+                                     old_range.vertex_buffer_offset,
+                                     old_range.vertex_element_size * old_range.vertex_count);
+    vulkan_deletion_queue_push_range(&context.deletion_queue,
+                                     &context.object_index_free_list,
+                                     old_range.index_buffer_offset,
+                                     old_range.index_element_size * old_range.index_count);
   }
 
   return true;
@@ -975,23 +1169,24 @@ b8 vulkan_renderer_backend_create_geometry(geometry *geometry,
 
 void vulkan_renderer_backend_destroy_geometry(geometry *geometry) {
   if (!geometry || geometry->internal_id == INVALID_ID) return;
-  vkDeviceWaitIdle(context.device.logical_device);
   vulkan_geometry_data *internal_data = &context.geometries[geometry->internal_id];
 
-  // Vertex data
-  free_data_range(&context.object_vertex_buffer,
-                  internal_data->vertex_buffer_offset,
-                  internal_data->vertex_element_size * internal_data->vertex_count);
-  // Index data
-  if (internal_data->index_element_size) {
-    free_data_range(&context.object_index_buffer,
-                    internal_data->index_buffer_offset,
-                    internal_data->index_element_size * internal_data->index_count);
-  }
+  // The ranges are reused once the frames that draw them are done
+  vulkan_deletion_queue_push_range(&context.deletion_queue,
+                                   &context.object_vertex_free_list,
+                                   internal_data->vertex_buffer_offset,
+                                   internal_data->vertex_element_size * internal_data->vertex_count);
+  vulkan_deletion_queue_push_range(&context.deletion_queue,
+                                   &context.object_index_free_list,
+                                   internal_data->index_buffer_offset,
+                                   internal_data->index_element_size * internal_data->index_count);
 
   kzero_memory(internal_data, sizeof(vulkan_geometry_data));
   internal_data->id = INVALID_ID;
   internal_data->generation = INVALID_ID;
+  handle_pool_release(&context.geometry_pool,
+                      handle_pool_from_index(&context.geometry_pool, geometry->internal_id));
+  geometry->internal_id = INVALID_ID;
 }
 
 void vulkan_renderer_backend_create_texture(const u8 *pixels, texture *t) {
@@ -1001,28 +1196,20 @@ void vulkan_renderer_backend_create_texture(const u8 *pixels, texture *t) {
   VkDeviceSize image_size = t->width * t->height * t->channel_count;
   VkFormat image_format = VK_FORMAT_R8G8B8A8_UNORM;
 
-  // Create buffer
-  VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-  VkMemoryPropertyFlags mem_prop_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-  vulkan_buffer buf;
-  vulkan_buffer_create(&context,
-                       image_size,
-                       usage,
-                       mem_prop_flags,
-                       true,
-                       &buf);
-  vulkan_buffer_load(&context,
-                     &buf,
-                     0,
-                     image_size,
-                     0,
-                     pixels);
+  // The mip chain is blitted on upload, which needs linear filtering support
+  VkFormatProperties format_properties;
+  vkGetPhysicalDeviceFormatProperties(context.device.physical_device, image_format, &format_properties);
+  u32 mip_levels = 1;
+  if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) {
+    mip_levels = kimage_mip_count(t->width, t->height);
+  }
 
   // Create image
   vulkan_image_create(&context,
                       VK_IMAGE_TYPE_2D,
                       t->width,
                       t->height,
+                      mip_levels,
                       image_format,
                       VK_IMAGE_TILING_OPTIMAL,
                       VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
@@ -1031,76 +1218,51 @@ void vulkan_renderer_backend_create_texture(const u8 *pixels, texture *t) {
                       VK_IMAGE_ASPECT_COLOR_BIT,
                       &data->image);
 
-  // Create command buffer
-  vulkan_command_buffer cmd_buf;
-  VkCommandPool pool = context.device.graphics_command_pool;
-  VkQueue queue = context.device.graphics_queue;
-  vulkan_command_buffer_oneshot_start(&context, pool, &cmd_buf);
-
-  // Transition layout from undefined to transfer_dst
-  vulkan_image_transition_layout(&context,
-                                 &cmd_buf,
-                                 &data->image,
-                                 image_format,
-                                 VK_IMAGE_LAYOUT_UNDEFINED,
-                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-  // Copy data from buffer
-  vulkan_image_copy(&context, &data->image, buf.handle, &cmd_buf);
-
-  // Transition layout from transfer_dst to shader_read_only
-  vulkan_image_transition_layout(&context,
-                                 &cmd_buf,
-                                 &data->image,
-                                 image_format,
-                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-  // End command buffer
-  vulkan_command_buffer_oneshot_end(&context, pool, &cmd_buf, queue);
-  vulkan_buffer_destroy(&context, &buf);
-
-  // Create texture sampler
-  VkSamplerCreateInfo sampler_info = {
-    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-    .magFilter = VK_FILTER_LINEAR,
-    .minFilter = VK_FILTER_LINEAR,
-    .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-    .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-    .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-    .anisotropyEnable = VK_TRUE,
-    .maxAnisotropy = 16,
-    .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-    .unnormalizedCoordinates = VK_FALSE,
-    .compareEnable = VK_FALSE,
-    .compareOp = VK_COMPARE_OP_ALWAYS,
-    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-    .mipLodBias = 0,
-    .minLod = 0,
-    .maxLod = 0
+  // Copy the pixels (recorded into the staging ring, submitted with the next frame)
+  vulkan_staging_ring_upload_image(&context,
+                                   &context.staging_ring,
+                                   &data->image,
+                                   image_format,
+                                   image_size,
+                                   pixels);
+
+  // Textures share samplers by state
+  vulkan_sampler_desc sampler_desc = {
+    .filter = VK_FILTER_LINEAR,
+    .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+    .address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+    .max_anisotropy = 16
   };
-  VkResult result = vkCreateSampler(context.device.logical_device,
-                                    &sampler_info,
-                                    context.allocator,
-                                    &data->sampler);
-  if (!vulkan_result_is_success(result)) {
-    KERROR("Failed to create texture sampler: %s", vulkan_result_string(result, true));
+  data->bindless_index = INVALID_ID;
+  if (!vulkan_sampler_cache_acquire(&context, &context.sampler_cache, &sampler_desc, &data->sampler)) {
+    KERROR("Failed to acquire texture sampler");
+    data->sampler = INVALID_ID;
+    return;
+  }
+  if (context.bindless_textures.enabled &&
+      !vulkan_bindless_textures_register(&context,
+                                         &context.bindless_textures,
+                                         data->image.view,
+                                         vulkan_sampler_cache_get(&context.sampler_cache, data->sampler),
+                                         &data->bindless_index)) {
+    KERROR("Failed to register texture in the bindless table");
+    data->bindless_index = INVALID_ID;
     return;
   }
   ++t->generation;
 }
 
 void vulkan_renderer_backend_destroy_texture(texture *in_texture) {
-  vkDeviceWaitIdle(context.device.logical_device);
-
+  // Pending uploads and frames in flight may still reference the image
   vulkan_texture_data *data = (vulkan_texture_data *) in_texture->data;
   if (data) {
-    vulkan_image_destroy(&context, &data->image);
+    vulkan_deletion_queue_push_image(&context.deletion_queue, &data->image);
     kzero_memory(&data->image, sizeof(vulkan_image));
-    vkDestroySampler(context.device.logical_device,
-                     data->sampler,
-                     context.allocator);
-    data->sampler = 0;
+    if (data->sampler != INVALID_ID) vulkan_sampler_cache_release(&context.sampler_cache, data->sampler);
+    data->sampler = INVALID_ID;
+    if (data->bindless_index != INVALID_ID) {
+      vulkan_deletion_queue_push_bindless_slot(&context.deletion_queue, data->bindless_index);
+    }
     kfree(in_texture->data, sizeof(vulkan_texture_data), MEMORY_TAG_TEXTURE);
   }
   kzero_memory(in_texture, sizeof(texture));
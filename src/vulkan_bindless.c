@@ -0,0 +1,141 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_utils.h>
+#include <vulkan_bindless.h>
+
+b8 vulkan_bindless_textures_create(vulkan_context *context, vulkan_bindless_textures *out_table) {
+  kzero_memory(out_table, sizeof(vulkan_bindless_textures));
+  if (!context->device.supports_bindless) return true;
+
+  // Slots are written while earlier frames are still pending, and unused ones are never written
+  VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                                           VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+  VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+    .bindingCount = 1,
+    .pBindingFlags = &binding_flags
+  };
+  VkDescriptorSetLayoutBinding binding = {
+    .binding = 0,
+    .descriptorCount = VULKAN_BINDLESS_MAX_TEXTURES,
+    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .pImmutableSamplers = 0,
+    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT
+  };
+  VkDescriptorSetLayoutCreateInfo layout_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = &binding_flags_info,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+    .bindingCount = 1,
+    .pBindings = &binding
+  };
+  VkResult result = vkCreateDescriptorSetLayout(context->device.logical_device,
+                                                &layout_info,
+                                                context->allocator,
+                                                &out_table->layout);
+  if (!vulkan_result_is_success(result)) {
+    KERROR("vulkan_bindless_textures_create :: failed to create the descriptor set layout: %s",
+           vulkan_result_string(result, true));
+    return false;
+  }
+
+  VkDescriptorPoolSize pool_size = {
+    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = VULKAN_BINDLESS_MAX_TEXTURES
+  };
+  VkDescriptorPoolCreateInfo pool_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+    .poolSizeCount = 1,
+    .pPoolSizes = &pool_size,
+    .maxSets = 1
+  };
+  VK_CHECK(vkCreateDescriptorPool(context->device.logical_device,
+                                  &pool_info,
+                                  context->allocator,
+                                  &out_table->pool));
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorPool = out_table->pool,
+    .descriptorSetCount = 1,
+    .pSetLayouts = &out_table->layout
+  };
+  VK_CHECK(vkAllocateDescriptorSets(context->device.logical_device, &alloc_info, &out_table->set));
+
+  out_table->enabled = true;
+  KINFO("Bindless texture table created (%u slots)", VULKAN_BINDLESS_MAX_TEXTURES);
+  return true;
+}
+
+void vulkan_bindless_textures_destroy(vulkan_context *context, vulkan_bindless_textures *table) {
+  if (table->pool) {
+    vkDestroyDescriptorPool(context->device.logical_device, table->pool, context->allocator);
+  }
+  if (table->layout) {
+    vkDestroyDescriptorSetLayout(context->device.logical_device, table->layout, context->allocator);
+  }
+  kzero_memory(table, sizeof(vulkan_bindless_textures));
+}
+
+b8 vulkan_bindless_textures_register(vulkan_context *context,
+                                     vulkan_bindless_textures *table,
+                                     VkImageView view,
+                                     VkSampler sampler,
+                                     u32 *out_index) {
+  if (!table->enabled) return false;
+  u32 index;
+  if (table->free_count) index = table->free_slots[--table->free_count];
+  else if (table->next_slot < VULKAN_BINDLESS_MAX_TEXTURES) index = table->next_slot++;
+  else {
+    KERROR("vulkan_bindless_textures_register :: table is full (%u textures)", VULKAN_BINDLESS_MAX_TEXTURES);
+    return false;
+  }
+
+  VkDescriptorImageInfo image_info = {
+    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    .imageView = view,
+    .sampler = sampler
+  };
+  VkWriteDescriptorSet write = {
+    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet = table->set,
+    .dstBinding = 0,
+    .dstArrayElement = index,
+    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = 1,
+    .pImageInfo = &image_info
+  };
+  vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+  *out_index = index;
+  return true;
+}
+
+void vulkan_bindless_textures_release(vulkan_bindless_textures *table, u32 index) {
+  if (!table->enabled || index >= table->next_slot) {
+    KWARN("vulkan_bindless_textures_release :: invalid slot %u", index);
+    return;
+  }
+  table->free_slots[table->free_count++] = index;
+}
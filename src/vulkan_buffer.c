@@ -24,7 +24,10 @@
 #include <vulkan_utils.h>
 #include <vulkan_buffer.h>
 #include <vulkan_device.h>
+#include <vulkan_memory.h>
+#include <vulkan_staging_ring.h>
 #include <vulkan_command_buffer.h>
+#include <vulkan_deletion_queue.h>
 
 b8 vulkan_buffer_create(vulkan_context *context,
                         u64 size,
@@ -48,42 +51,21 @@ b8 vulkan_buffer_create(vulkan_context *context,
                           context->allocator,
                           &out_buffer->handle));
 
-  VkMemoryRequirements requirements;
-  vkGetBufferMemoryRequirements(context->device.logical_device,
-                                out_buffer->handle,
-                                &requirements);
-  out_buffer->memory_index = context->find_memory_index(requirements.memoryTypeBits,
-                                                      out_buffer->memory_property_flags);
-  if (out_buffer->memory_index == -1) {
-    KERROR("vulkan_buffer_create :: required memory type idx not found");
-    return false;
-  }
-
-  VkMemoryAllocateInfo allocate_info = {
-    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .allocationSize = requirements.size,
-    .memoryTypeIndex = (u32) out_buffer->memory_index
-  };
-  VkResult result = vkAllocateMemory(context->device.logical_device,
-                                     &allocate_info,
-                                     context->allocator,
-                                     &out_buffer->memory);
-  if (result != VK_SUCCESS) {
-    KERROR("vulkan_buffer_create :: required memory allocation failed (%i)", result);
+  if (!vulkan_memory_allocate_buffer(context,
+                                     out_buffer->handle,
+                                     out_buffer->memory_property_flags,
+                                     &out_buffer->allocation)) {
+    KERROR("vulkan_buffer_create :: required memory allocation failed");
     return false;
   }
+  out_buffer->memory_index = (i32) out_buffer->allocation.memory_type;
   if (bind_on_create) vulkan_buffer_bind(context, out_buffer, 0);
 
   return true;
 }
 
 void vulkan_buffer_destroy(vulkan_context *context, vulkan_buffer *buffer) {
-  if (buffer->memory) {
-    vkFreeMemory(context->device.logical_device,
-                 buffer->memory,
-                 context->allocator);
-    buffer->memory = 0;
-  }
+  vulkan_memory_free(context, &buffer->allocation);
   if (buffer->handle) {
     vkDestroyBuffer(context->device.logical_device,
                     buffer->handle,
@@ -95,23 +77,26 @@ void vulkan_buffer_destroy(vulkan_context *context, vulkan_buffer *buffer) {
   buffer->is_locked = false;
 }
 
+// Host visible memory stays mapped, so locking just hands out the persistent pointer
 void *vulkan_buffer_lock(vulkan_context *context,
                          vulkan_buffer *buffer,
                          u64 offset,
                          u64 size,
                          u32 flags) {
-  void *data;
-  VK_CHECK(vkMapMemory(context->device.logical_device,
-                       buffer->memory,
-                       offset,
-                       size,
-                       flags,
-                       &data));
-  return data;
+  (void) context;  // Unused parameter
+  (void) size;     // Unused parameter
+  (void) flags;    // Unused parameter
+  if (!buffer->allocation.mapped) {
+    KERROR("vulkan_buffer_lock :: buffer memory is not host visible");
+    return 0;
+  }
+  buffer->is_locked = true;
+  return buffer->allocation.mapped + offset;
 }
 
 void vulkan_buffer_unlock(vulkan_context *context, vulkan_buffer *buffer) {
-  vkUnmapMemory(context->device.logical_device, buffer->memory);
+  (void) context;  // Unused parameter
+  buffer->is_locked = false;
 }
 
 void vulkan_buffer_load(vulkan_context *context,
@@ -120,15 +105,10 @@ void vulkan_buffer_load(vulkan_context *context,
                         u64 size,
                         u32 flags,
                         const void *data) {
-  void *data_ptr;
-  VK_CHECK(vkMapMemory(context->device.logical_device,
-                       buffer->memory,
-                       offset,
-                       size,
-                       flags,
-                       &data_ptr));
+  void *data_ptr = vulkan_buffer_lock(context, buffer, offset, size, flags);
+  if (!data_ptr) return;
   kcopy_memory(data_ptr, data, size);
-  vkUnmapMemory(context->device.logical_device, buffer->memory);
+  vulkan_buffer_unlock(context, buffer);
 }
 
 void vulkan_buffer_copy(vulkan_context *context,
@@ -161,9 +141,7 @@ void vulkan_buffer_copy(vulkan_context *context,
 
 b8 vulkan_buffer_resize(vulkan_context *context,
                         u64 new_size,
-                        vulkan_buffer *buffer,
-                        VkQueue queue,
-                        VkCommandPool pool) {
+                        vulkan_buffer *buffer) {
   VkBufferCreateInfo buffer_info = {
     .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
     .size = new_size,
@@ -176,55 +154,35 @@ b8 vulkan_buffer_resize(vulkan_context *context,
                           context->allocator,
                           &new_buffer));
 
-  VkMemoryRequirements requirements;
-  vkGetBufferMemoryRequirements(context->device.logical_device,
-                                new_buffer,
-                                &requirements);
-
-  VkMemoryAllocateInfo allocate_info = {
-    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .allocationSize = requirements.size,
-    .memoryTypeIndex = (u32) buffer->memory_index
-  };
-  VkDeviceMemory new_memory;
-  VkResult result = vkAllocateMemory(context->device.logical_device,
-                                     &allocate_info,
-                                     context->allocator,
-                                     &new_memory);
-  if (result != VK_SUCCESS) {
-    KERROR("vulkan_buffer_resize :: required memory allocation failed (%i)", result);
+  vulkan_allocation new_allocation;
+  if (!vulkan_memory_allocate_buffer(context,
+                                     new_buffer,
+                                     buffer->memory_property_flags,
+                                     &new_allocation)) {
+    KERROR("vulkan_buffer_resize :: required memory allocation failed");
+    vkDestroyBuffer(context->device.logical_device, new_buffer, context->allocator);
     return false;
   }
   VK_CHECK(vkBindBufferMemory(context->device.logical_device,
                               new_buffer,
-                              new_memory,
-                              0));
-  vulkan_buffer_copy(context,
-                     pool,
-                     0,
-                     queue,
-                     buffer->handle,
-                     0,
-                     new_buffer,
-                     0,
-                     buffer->total_size);
-
-  vkDeviceWaitIdle(context->device.logical_device);
-
-  if (buffer->memory) {
-    vkFreeMemory(context->device.logical_device,
-                 buffer->memory,
-                 context->allocator);
-    buffer->memory = 0;
-  }
-  if (buffer->handle) {
-    vkDestroyBuffer(context->device.logical_device,
-                    buffer->handle,
-                    context->allocator);
-    buffer->handle = 0;
-  }
+                              new_allocation.memory,
+                              new_allocation.offset));
+  vulkan_buffer old_buffer = *buffer;
+  vulkan_buffer resized = *buffer;
+  resized.handle = new_buffer;
+  resized.allocation = new_allocation;
+  resized.total_size = new_size;
+  vulkan_staging_ring_copy_buffer(context,
+                                  &context->staging_ring,
+                                  &old_buffer,
+                                  0,
+                                  &resized,
+                                  0,
+                                  old_buffer.total_size);
+  vulkan_deletion_queue_push_buffer(&context->deletion_queue, &old_buffer);
+
   buffer->total_size = new_size;
-  buffer->memory = new_memory;
+  buffer->allocation = new_allocation;
   buffer->handle = new_buffer;
 
   return true;
@@ -235,6 +193,6 @@ void vulkan_buffer_bind(vulkan_context *context,
                         u64 offset) {
   VK_CHECK(vkBindBufferMemory(context->device.logical_device,
                               buffer->handle,
-                              buffer->memory,
-                              offset));
+                              buffer->allocation.memory,
+                              buffer->allocation.offset + offset));
 }
@@ -0,0 +1,176 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <darray.h>
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_image.h>
+#include <vulkan_buffer.h>
+#include <vulkan_bindless.h>
+#include <vulkan_deletion_queue.h>
+
+static void push(vulkan_deletion_queue *queue, vulkan_deletion *entry) {
+  // Serials only grow, so the queue stays ordered without sorting
+  entry->frame_serial = queue->submitted_serial + 1;
+  darray_push(queue->entries, *entry);
+}
+
+static void destroy_entry(vulkan_context *context, vulkan_deletion *entry) {
+  switch (entry->type) {
+  case VULKAN_DELETION_IMAGE:
+    vulkan_image_destroy(context, &entry->image);
+    break;
+  case VULKAN_DELETION_BUFFER:
+    vulkan_buffer_destroy(context, &entry->buffer);
+    break;
+  case VULKAN_DELETION_BUFFER_RANGE:
+    if (!free_list_free(entry->range.list, entry->range.size, entry->range.offset)) {
+      KWARN("vulkan_deletion_queue :: failed to free range (offset: %u B, size: %u B)",
+            entry->range.offset,
+            entry->range.size);
+    }
+    break;
+  case VULKAN_DELETION_DESCRIPTOR_SETS:
+    if (vkFreeDescriptorSets(context->device.logical_device,
+                             entry->descriptor_sets.pool,
+                             entry->descriptor_sets.count,
+                             entry->descriptor_sets.sets) != VK_SUCCESS) {
+      KERROR("vulkan_deletion_queue :: Failed descriptor sets free");
+    }
+    break;
+  case VULKAN_DELETION_BINDLESS_SLOT:
+    vulkan_bindless_textures_release(&context->bindless_textures, entry->bindless_slot);
+    break;
+  case VULKAN_DELETION_HANDLE:
+    handle_pool_release(entry->handle.pool, entry->handle.handle);
+    break;
+  case VULKAN_DELETION_IMAGE_VIEW:
+    vkDestroyImageView(context->device.logical_device, entry->image_view, context->allocator);
+    break;
+  case VULKAN_DELETION_FRAMEBUFFER:
+    vkDestroyFramebuffer(context->device.logical_device, entry->framebuffer, context->allocator);
+    break;
+  case VULKAN_DELETION_SWAPCHAIN:
+    vkDestroySwapchainKHR(context->device.logical_device, entry->swapchain, context->allocator);
+    break;
+  case VULKAN_DELETION_SEMAPHORE:
+    vkDestroySemaphore(context->device.logical_device, entry->semaphore, context->allocator);
+    break;
+  }
+}
+
+void vulkan_deletion_queue_create(vulkan_deletion_queue *out_queue) {
+  kzero_memory(out_queue, sizeof(vulkan_deletion_queue));
+  out_queue->entries = darray_create(vulkan_deletion);
+}
+
+void vulkan_deletion_queue_destroy(vulkan_context *context, vulkan_deletion_queue *queue) {
+  if (!queue->entries) return;
+  vulkan_deletion_queue_collect(context, queue, queue->submitted_serial + 1);
+  darray_destroy(queue->entries);
+  kzero_memory(queue, sizeof(vulkan_deletion_queue));
+}
+
+void vulkan_deletion_queue_push_image(vulkan_deletion_queue *queue, const vulkan_image *image) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_IMAGE, .image = *image };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_buffer(vulkan_deletion_queue *queue, const vulkan_buffer *buffer) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_BUFFER, .buffer = *buffer };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_range(vulkan_deletion_queue *queue, free_list *list, u32 offset, u32 size) {
+  if (!size) return;
+  vulkan_deletion entry = {
+    .type = VULKAN_DELETION_BUFFER_RANGE,
+    .range = { .list = list, .offset = offset, .size = size }
+  };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_descriptor_sets(vulkan_deletion_queue *queue,
+                                                VkDescriptorPool pool,
+                                                u32 count,
+                                                const VkDescriptorSet *sets) {
+  KASSERT_MSG(count <= FRAME_DESCRIPTOR_COUNT, "vulkan_deletion_queue :: too many descriptor sets");
+  vulkan_deletion entry = {
+    .type = VULKAN_DELETION_DESCRIPTOR_SETS,
+    .descriptor_sets = { .pool = pool, .count = count }
+  };
+  kcopy_memory(entry.descriptor_sets.sets, sets, sizeof(VkDescriptorSet) * count);
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_bindless_slot(vulkan_deletion_queue *queue, u32 slot) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_BINDLESS_SLOT, .bindless_slot = slot };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_image_view(vulkan_deletion_queue *queue, VkImageView view) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_IMAGE_VIEW, .image_view = view };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_framebuffer(vulkan_deletion_queue *queue, VkFramebuffer framebuffer) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_FRAMEBUFFER, .framebuffer = framebuffer };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_swapchain(vulkan_deletion_queue *queue, VkSwapchainKHR swapchain) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_SWAPCHAIN, .swapchain = swapchain };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_semaphore(vulkan_deletion_queue *queue, VkSemaphore semaphore) {
+  vulkan_deletion entry = { .type = VULKAN_DELETION_SEMAPHORE, .semaphore = semaphore };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_push_handle(vulkan_deletion_queue *queue, handle_pool *pool, khandle handle) {
+  vulkan_deletion entry = {
+    .type = VULKAN_DELETION_HANDLE,
+    .handle = { .pool = pool, .handle = handle }
+  };
+  push(queue, &entry);
+}
+
+void vulkan_deletion_queue_frame_submitted(vulkan_deletion_queue *queue, u32 frame) {
+  queue->frame_serials[frame] = ++queue->submitted_serial;
+}
+
+void vulkan_deletion_queue_frame_completed(vulkan_context *context, vulkan_deletion_queue *queue, u32 frame) {
+  // A signaled fence also covers every frame submitted before it
+  vulkan_deletion_queue_collect(context, queue, queue->frame_serials[frame]);
+}
+
+void vulkan_deletion_queue_collect(vulkan_context *context, vulkan_deletion_queue *queue, u64 serial) {
+  if (serial > queue->completed_serial) queue->completed_serial = serial;
+  u64 length = darray_length(queue->entries);
+  u64 done = 0;
+  while (done < length && queue->entries[done].frame_serial <= queue->completed_serial) {
+    destroy_entry(context, &queue->entries[done++]);
+  }
+  if (!done) return;
+  for (u64 i = done; i < length; ++i) queue->entries[i - done] = queue->entries[i];
+  darray_length_set(queue->entries, length - done);
+}
@@ -81,6 +81,20 @@ void vulkan_device_query_swapchain_support(VkPhysicalDevice physical_device,
   }
 }
 
+// Frames in flight are paced with a timeline semaphore (core since 1.2)
+b8 supports_timeline_semaphores(VkPhysicalDevice device, const VkPhysicalDeviceProperties *properties) {
+  if (properties->apiVersion < VK_API_VERSION_1_2) return false;
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES
+  };
+  VkPhysicalDeviceFeatures2 features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    .pNext = &timeline_features
+  };
+  vkGetPhysicalDeviceFeatures2(device, &features);
+  return timeline_features.timelineSemaphore;
+}
+
 b8 physical_device_meets_requirements(VkPhysicalDevice device,
                                       VkSurfaceKHR surface,
                                       const VkPhysicalDeviceProperties* properties,
@@ -213,12 +227,47 @@ b8 physical_device_meets_requirements(VkPhysicalDevice device,
       return false;
     }
 
+    // Timeline semaphores
+    if (!supports_timeline_semaphores(device, properties)) {
+      KINFO("Device skipped (no timelineSemaphore)");
+      return false;
+    }
+
     // All requirements met
     return true;
   }
   return false;
 }
 
+// Descriptor indexing is core since 1.2, the texture table must fit in a single stage
+b8 supports_bindless_textures(VkPhysicalDevice device, const VkPhysicalDeviceProperties *properties) {
+  if (properties->apiVersion < VK_API_VERSION_1_2) return false;
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES
+  };
+  VkPhysicalDeviceFeatures2 features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    .pNext = &indexing_features
+  };
+  vkGetPhysicalDeviceFeatures2(device, &features);
+  VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES
+  };
+  VkPhysicalDeviceProperties2 properties2 = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &indexing_properties
+  };
+  vkGetPhysicalDeviceProperties2(device, &properties2);
+  return features.features.shaderSampledImageArrayDynamicIndexing &&
+         indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+         indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+         indexing_features.descriptorBindingPartiallyBound &&
+         indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= VULKAN_BINDLESS_MAX_TEXTURES &&
+         indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers >= VULKAN_BINDLESS_MAX_TEXTURES &&
+         indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages >= VULKAN_BINDLESS_MAX_TEXTURES &&
+         indexing_properties.maxDescriptorSetUpdateAfterBindSamplers >= VULKAN_BINDLESS_MAX_TEXTURES;
+}
+
 b8 select_physical_device(vulkan_context *context) {
   u32 c = 0;
   VK_CHECK(vkEnumeratePhysicalDevices(context->instance, &c, 0));
@@ -315,8 +364,10 @@ b8 select_physical_device(vulkan_context *context) {
         .properties = properties,
         .features = features,
         .memory = memory,
-        .supports_device_local_host_visible = supports_device_local_host_visible
+        .supports_device_local_host_visible = supports_device_local_host_visible,
+        .supports_bindless = VULKAN_BINDLESS_TEXTURES && supports_bindless_textures(physical_devices[i], &properties)
       };
+      KINFO("Bindless textures: %s", context->device.supports_bindless ? "yes" : "no");
       break;
     }
     darray_destroy(requirements.extensions);
@@ -368,13 +419,26 @@ b8 vulkan_device_create(vulkan_context *context) {
 
   // Device features
   VkPhysicalDeviceFeatures device_features = {
-    .samplerAnisotropy = VK_TRUE
+    .samplerAnisotropy = VK_TRUE,
+    .shaderSampledImageArrayDynamicIndexing = context->device.supports_bindless
+  };
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+    .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+    .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+    .descriptorBindingPartiallyBound = VK_TRUE
+  };
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+    .pNext = context->device.supports_bindless ? &indexing_features : 0,
+    .timelineSemaphore = VK_TRUE
   };
   // Device create info
   const char *extension_names = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
   VkDeviceCreateInfo device_create_info = {
     .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
     .queueCreateInfoCount = index_count,
+    .pNext = &timeline_features,
     .pQueueCreateInfos = queue_create_infos,
     .pEnabledFeatures = &device_features,
     .enabledExtensionCount = 1,
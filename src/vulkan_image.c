@@ -19,15 +19,18 @@
  */
 
 
+#include <kimage.h>
 #include <logger.h>
 #include <kmemory.h>
 #include <vulkan_image.h>
 #include <vulkan_device.h>
+#include <vulkan_memory.h>
 
 void vulkan_image_create(vulkan_context *context,
                          VkImageType image_type,
                          u32 width,
                          u32 height,
+                         u32 mip_levels,
                          VkFormat format,
                          VkImageTiling tiling,
                          VkImageUsageFlags usage,
@@ -37,6 +40,7 @@ void vulkan_image_create(vulkan_context *context,
                          vulkan_image *out_image) {
   out_image->width  = width;
   out_image->height = height;
+  out_image->mip_levels = mip_levels ? mip_levels : 1;
 
   // Image create info
   VkImageCreateInfo image_create_info = {
@@ -45,7 +49,7 @@ void vulkan_image_create(vulkan_context *context,
     .extent.width = width,
     .extent.height = height,
     .extent.depth = 1,
-    .mipLevels = 4,
+    .mipLevels = out_image->mip_levels,
     .arrayLayers = 1,
     .format = format,
     .tiling = tiling,
@@ -61,29 +65,15 @@ void vulkan_image_create(vulkan_context *context,
                          context->allocator,
                          &out_image->handle));
 
-  // Memory requirements
-  VkMemoryRequirements memory_requirements;
-  vkGetImageMemoryRequirements(context->device.logical_device,
-                               out_image->handle,
-                               &memory_requirements);
-  i32 memory_type = context->find_memory_index(memory_requirements.memoryTypeBits,
-                                              memory_flags);
-  if (memory_type == -1) KERROR("Image not valid :: Required memory type not found");
-
-  // Allocate memory
-  VkMemoryAllocateInfo memory_allocate_info = {
-    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .allocationSize = memory_requirements.size,
-    .memoryTypeIndex = memory_type
-  };
-  VK_CHECK(vkAllocateMemory(context->device.logical_device,
-                            &memory_allocate_info,
-                            context->allocator,
-                            &out_image->memory));
+  // Allocate and bind memory
+  if (!vulkan_memory_allocate_image(context, out_image->handle, tiling, memory_flags, &out_image->allocation)) {
+    KERROR("Image not valid :: Required memory allocation failed");
+    return;
+  }
   VK_CHECK(vkBindImageMemory(context->device.logical_device,
                              out_image->handle,
-                             out_image->memory,
-                             0));
+                             out_image->allocation.memory,
+                             out_image->allocation.offset));
 
   // Create view
   if (create_view) {
@@ -103,7 +93,7 @@ void vulkan_image_view_create(vulkan_context *context,
     .format = format,
     .subresourceRange.aspectMask = aspect_flags,
     .subresourceRange.baseMipLevel = 0,
-    .subresourceRange.levelCount = 1,
+    .subresourceRange.levelCount = image->mip_levels,
     .subresourceRange.baseArrayLayer = 0,
     .subresourceRange.layerCount = 1
   };
@@ -130,7 +120,7 @@ void vulkan_image_transition_layout(vulkan_context *context,
     .image = image->handle,
     .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
     .subresourceRange.baseMipLevel = 0,
-    .subresourceRange.levelCount = 1,
+    .subresourceRange.levelCount = image->mip_levels,
     .subresourceRange.baseArrayLayer = 0,
     .subresourceRange.layerCount = 1
   };
@@ -169,11 +159,12 @@ void vulkan_image_transition_layout(vulkan_context *context,
 void vulkan_image_copy(vulkan_context *context,
                        vulkan_image *image,
                        VkBuffer buffer,
+                       u64 buffer_offset,
                        vulkan_command_buffer *command_buffer) {
   (void) context;  // Unused parameter
 
   VkBufferImageCopy region = {
-    .bufferOffset = 0,
+    .bufferOffset = buffer_offset,
     .bufferRowLength = 0,
     .bufferImageHeight = 0,
     .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -192,15 +183,104 @@ void vulkan_image_copy(vulkan_context *context,
                          &region);
 }
 
+void vulkan_image_generate_mipmaps(vulkan_context *context,
+                                   vulkan_image *image,
+                                   vulkan_command_buffer *command_buffer) {
+  VkImageMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcQueueFamilyIndex = context->device.graphics,
+    .dstQueueFamilyIndex = context->device.graphics,
+    .image = image->handle,
+    .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .subresourceRange.levelCount = 1,
+    .subresourceRange.baseArrayLayer = 0,
+    .subresourceRange.layerCount = 1
+  };
+
+  for (u32 level = 1; level < image->mip_levels; ++level) {
+    // Previous level: written -> blit source
+    barrier.subresourceRange.baseMipLevel = level - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer->handle,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         0,
+                         0,
+                         0,
+                         1,
+                         &barrier);
+
+    VkImageBlit blit = {
+      .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .srcSubresource.mipLevel = level - 1,
+      .srcSubresource.baseArrayLayer = 0,
+      .srcSubresource.layerCount = 1,
+      .srcOffsets[1].x = (i32) kimage_mip_extent(image->width, level - 1),
+      .srcOffsets[1].y = (i32) kimage_mip_extent(image->height, level - 1),
+      .srcOffsets[1].z = 1,
+      .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .dstSubresource.mipLevel = level,
+      .dstSubresource.baseArrayLayer = 0,
+      .dstSubresource.layerCount = 1,
+      .dstOffsets[1].x = (i32) kimage_mip_extent(image->width, level),
+      .dstOffsets[1].y = (i32) kimage_mip_extent(image->height, level),
+      .dstOffsets[1].z = 1
+    };
+    vkCmdBlitImage(command_buffer->handle,
+                   image->handle,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   image->handle,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1,
+                   &blit,
+                   VK_FILTER_LINEAR);
+
+    // Previous level is final
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer->handle,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0,
+                         0,
+                         0,
+                         0,
+                         0,
+                         1,
+                         &barrier);
+  }
+
+  // Last level was only written
+  barrier.subresourceRange.baseMipLevel = image->mip_levels - 1;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer->handle,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0,
+                       0,
+                       0,
+                       0,
+                       0,
+                       1,
+                       &barrier);
+}
+
 void vulkan_image_destroy(vulkan_context *context, vulkan_image *image) {
   if (image->view) {
     vkDestroyImageView(context->device.logical_device, image->view, context->allocator);
     image->view = 0;
   }
-  if (image->memory) {
-    vkFreeMemory(context->device.logical_device, image->memory, context->allocator);
-    image->memory = 0;
-  }
+  vulkan_memory_free(context, &image->allocation);
   if (image->handle) {
     vkDestroyImage(context->device.logical_device, image->handle, context->allocator);
     image->handle = 0;
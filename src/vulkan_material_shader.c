@@ -22,16 +22,115 @@
 #include <kmath.h>
 #include <logger.h>
 #include <kmemory.h>
+#include <vulkan_utils.h>
 #include <vulkan_buffer.h>
 #include <texture_system.h>
 #include <vulkan_pipeline.h>
 #include <vulkan_shader_utils.h>
+#include <vulkan_uniform_ring.h>
+#include <vulkan_sampler_cache.h>
+#include <vulkan_deletion_queue.h>
 #include <vulkan_material_shader.h>
 
 #define ATTRIBUTE_COUNT 2
 #define BUILTIN_MATERIAL_SHADER_NAME_OBJECT "builtin.material"
+#define BUILTIN_MATERIAL_BINDLESS_SHADER_NAME_OBJECT "builtin.material_bindless"
+// Live sets plus retiring ones: growth only happens in `update`, so a frame slot has at most one retiring
+// set, freed once the frame that replaced it completes (before the slot grows again)
+#define MATERIAL_SHADER_GLOBAL_SET_COUNT (FRAME_DESCRIPTOR_COUNT * 2)
+
+// Creates the frame's instance buffer (`instance_capacity` matrices) and a global set pointing at it
+b8 create_frame_instances(vulkan_context *context, vulkan_material_shader *shader, u32 frame_idx) {
+  u32 device_local_bits = context->device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
+  if (!vulkan_buffer_create(context,
+                            sizeof(Matrix4) * shader->instance_capacity,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits,
+                            true,
+                            &shader->instance_buffers[frame_idx])) {
+    KERROR("create_frame_instances :: failed to create the instance buffer");
+    return false;
+  }
+
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorPool = shader->global_descriptor_pool,
+    .descriptorSetCount = 1,
+    .pSetLayouts = &shader->global_descriptor_set_layout
+  };
+  VkResult result = vkAllocateDescriptorSets(context->device.logical_device,
+                                             &alloc_info,
+                                             &shader->global_descriptor_sets[frame_idx]);
+  if (result != VK_SUCCESS) {
+    KERROR("create_frame_instances :: failed to allocate the global set (%s)", vulkan_result_string(result, true));
+    vulkan_buffer_destroy(context, &shader->instance_buffers[frame_idx]);
+    return false;
+  }
+
+  // The global descriptor points at the reserved slot, the region is picked with the dynamic offset
+  VkDescriptorBufferInfo ubo_info = {
+    .buffer = shader->uniform_ring.buffer.handle,
+    .offset = 0,
+    .range = sizeof(vulkan_material_shader_global_ubo)
+  };
+  VkDescriptorBufferInfo instance_info = {
+    .buffer = shader->instance_buffers[frame_idx].handle,
+    .offset = 0,
+    .range = VK_WHOLE_SIZE
+  };
+  VkWriteDescriptorSet descriptor_writes[] = {
+    {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = shader->global_descriptor_sets[frame_idx],
+      .dstBinding = 0,
+      .dstArrayElement = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .pBufferInfo = &ubo_info
+    },
+    {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = shader->global_descriptor_sets[frame_idx],
+      .dstBinding = 1,
+      .dstArrayElement = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .pBufferInfo = &instance_info
+    }
+  };
+  vkUpdateDescriptorSets(context->device.logical_device,
+                         2,
+                         descriptor_writes,
+                         0,
+                         0);
+  return true;
+}
+
+// Swaps in a buffer of `instance_capacity` matrices, the frame that last used the old one may still be in flight
+b8 grow_frame_instances(vulkan_context *context, vulkan_material_shader *shader, u32 frame_idx) {
+  vulkan_buffer old_buffer = shader->instance_buffers[frame_idx];
+  VkDescriptorSet old_set = shader->global_descriptor_sets[frame_idx];
+  if (!create_frame_instances(context, shader, frame_idx)) {
+    shader->instance_buffers[frame_idx] = old_buffer;
+    shader->global_descriptor_sets[frame_idx] = old_set;
+    return false;
+  }
+  vulkan_deletion_queue_push_buffer(&context->deletion_queue, &old_buffer);
+  vulkan_deletion_queue_push_descriptor_sets(&context->deletion_queue,
+                                             shader->global_descriptor_pool,
+                                             1,
+                                             &old_set);
+  KDEBUG("grow_frame_instances :: frame %u instance buffer grown to %u matrices", frame_idx, shader->instance_capacity);
+  return true;
+}
 
 b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader *out_shader) {
+  out_shader->bindless = context->bindless_textures.enabled;
+  // Only the fragment stage differs between the two paths
+  const char *stage_names[] = {
+    BUILTIN_MATERIAL_SHADER_NAME_OBJECT,
+    out_shader->bindless ? BUILTIN_MATERIAL_BINDLESS_SHADER_NAME_OBJECT : BUILTIN_MATERIAL_SHADER_NAME_OBJECT
+  };
   char *stage_type_names[] = { "vert", "frag" };
   VkShaderStageFlagBits stage_types[] = {
     VK_SHADER_STAGE_VERTEX_BIT,
@@ -39,56 +138,83 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
   };
   for (u32 i = 0; i < MATERIAL_SHADER_STAGE_COUNT; ++i) {
     if (!create_shader_module(context,
-                              BUILTIN_MATERIAL_SHADER_NAME_OBJECT,
+                              stage_names[i],
                               stage_type_names[i],
                               stage_types[i],
                               i,
                               out_shader->stages)) {
       KERROR("Unable to create %s shader module for `%s`",
              stage_type_names[i],
-             BUILTIN_MATERIAL_SHADER_NAME_OBJECT);
+             stage_names[i]);
       return false;
     }
   }
   // Global Descriptors
-  VkDescriptorSetLayoutBinding global_ubo_layout_binding = {
-    .binding = 0,
-    .descriptorCount = 1,
-    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .pImmutableSamplers = 0,
-    .stageFlags = VK_SHADER_STAGE_VERTEX_BIT
+  VkDescriptorSetLayoutBinding global_layout_bindings[] = {
+    {
+      .binding = 0,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .pImmutableSamplers = 0,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT
+    },
+    {
+      .binding = 1,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // Instance model matrices
+      .pImmutableSamplers = 0,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT
+    }
   };
   VkDescriptorSetLayoutCreateInfo global_layout_info = {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-    .bindingCount = 1,
-    .pBindings = &global_ubo_layout_binding,
+    .bindingCount = 2,
+    .pBindings = global_layout_bindings,
   };
   VK_CHECK(vkCreateDescriptorSetLayout(context->device.logical_device,
                                        &global_layout_info,
                                        context->allocator,
                                        &out_shader->global_descriptor_set_layout));
   // Global descriptor pool
-  VkDescriptorPoolSize global_pool_size = {
-    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .descriptorCount = context->swapchain.image_count
+  VkDescriptorPoolSize global_pool_sizes[] = {
+    {
+      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = MATERIAL_SHADER_GLOBAL_SET_COUNT
+    },
+    {
+      .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = MATERIAL_SHADER_GLOBAL_SET_COUNT
+    }
   };
+  // Sets are replaced when their instance buffer grows, the old ones retire through the deletion queue
   VkDescriptorPoolCreateInfo global_pool_info = {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-    .poolSizeCount = 1,
-    .pPoolSizes = &global_pool_size,
-    .maxSets = context->swapchain.image_count
+    .poolSizeCount = 2,
+    .pPoolSizes = global_pool_sizes,
+    .maxSets = MATERIAL_SHADER_GLOBAL_SET_COUNT,
+    .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
   };
   VK_CHECK(vkCreateDescriptorPool(context->device.logical_device,
                                   &global_pool_info,
                                   context->allocator,
                                   &out_shader->global_descriptor_pool));
 
+  // Material slots
+  u64 material_pool_requirements = 0;
+  handle_pool_create(MATERIAL_SHADER_MAX_MATERIALS, &material_pool_requirements, 0, 0);
+  out_shader->material_pool_block = kallocate(material_pool_requirements, MEMORY_TAG_RENDERER);
+  handle_pool_create(MATERIAL_SHADER_MAX_MATERIALS,
+                     &material_pool_requirements,
+                     out_shader->material_pool_block,
+                     &out_shader->material_pool);
+
   // Sampler uses
   out_shader->sampler_uses[0] = TEXTURE_USE_MAP_DIFFUSE;
 
-  // Local (object) descriptors
+  // Local (object) descriptors, the bindless path keeps only the uniform buffer
+  u32 object_binding_count = out_shader->bindless ? 1 : MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT;
   VkDescriptorType descriptor_types[] = {
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         // Binding 0: uniform buffer
+    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, // Binding 0: uniform buffer
     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER  // Binding 1: diffuse sampler layout
   };
   VkDescriptorSetLayoutBinding bindings[MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT];
@@ -103,7 +229,7 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
   }
   VkDescriptorSetLayoutCreateInfo layout_info = {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-    .bindingCount = MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT,
+    .bindingCount = object_binding_count,
     .pBindings = bindings
   };
   VK_CHECK(vkCreateDescriptorSetLayout(context->device.logical_device,
@@ -111,11 +237,12 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
                                        0,
                                        &out_shader->object_descriptor_set_layout));
 
-  // Local (object) descriptor pool
+  // Local (object) descriptor pool, a single shared set on the bindless path
+  u32 object_set_count = out_shader->bindless ? 1 : MATERIAL_SHADER_MAX_MATERIALS;
   VkDescriptorPoolSize object_pool_sizes[] = {
     {
-      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      .descriptorCount = MATERIAL_SHADER_MAX_MATERIALS
+      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = object_set_count
     },
     {
       .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -124,9 +251,9 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
   };
   VkDescriptorPoolCreateInfo object_pool_info = {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-    .poolSizeCount = MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT,
+    .poolSizeCount = object_binding_count,
     .pPoolSizes = object_pool_sizes,
-    .maxSets = MATERIAL_SHADER_MAX_MATERIALS,
+    .maxSets = object_set_count,
     .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
   };
   VK_CHECK(vkCreateDescriptorPool(context->device.logical_device,
@@ -170,10 +297,11 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
   }
 
   // Descriptor set layouts
-  const i32 descriptor_set_layout_count = 2;
+  const i32 descriptor_set_layout_count = out_shader->bindless ? 3 : 2;
   VkDescriptorSetLayout layouts[] = {
     out_shader->global_descriptor_set_layout,
-    out_shader->object_descriptor_set_layout
+    out_shader->object_descriptor_set_layout,
+    context->bindless_textures.layout
   };
 
   VkPipelineShaderStageCreateInfo stage_create_infos[MATERIAL_SHADER_STAGE_COUNT];
@@ -182,66 +310,96 @@ b8 vulkan_material_shader_create(vulkan_context *context, vulkan_material_shader
     stage_create_infos[i] = out_shader->stages[i].shader_stage_create_info;
   }
 
-  // Create pipeline
-  if (!vulkan_graphics_pipeline_create(context,
-                                       &context->main_renderpass,
-                                       sizeof(vertex_3d),
-                                       ATTRIBUTE_COUNT,
-                                       attribute_descriptions,
-                                       descriptor_set_layout_count,
-                                       layouts,
-                                       MATERIAL_SHADER_STAGE_COUNT,
-                                       stage_create_infos,
-                                       viewport,
-                                       scissor,
-                                       false,
-                                       true,
-                                       &out_shader->pipeline)) {
-    KERROR("vulkan_material_shader_create :: failed to create graphics pipeline");
-    return false;
+  // Create one pipeline per variant, each fragment stage specialized on `vulkan_material_shader_variant`
+  VkSpecializationMapEntry variant_entry = {
+    .constantID = 0,
+    .offset = 0,
+    .size = sizeof(u32)
+  };
+  for (u32 variant = 0; variant < MATERIAL_SHADER_VARIANT_COUNT; ++variant) {
+    VkSpecializationInfo specialization_info = {
+      .mapEntryCount = 1,
+      .pMapEntries = &variant_entry,
+      .dataSize = sizeof(u32),
+      .pData = &variant
+    };
+    stage_create_infos[1].pSpecializationInfo = &specialization_info;
+    if (!vulkan_graphics_pipeline_create(context,
+                                         &context->main_renderpass,
+                                         sizeof(vertex_3d),
+                                         ATTRIBUTE_COUNT,
+                                         attribute_descriptions,
+                                         descriptor_set_layout_count,
+                                         layouts,
+                                         MATERIAL_SHADER_STAGE_COUNT,
+                                         stage_create_infos,
+                                         viewport,
+                                         scissor,
+                                         false,
+                                         true,
+                                         variant != MATERIAL_SHADER_VARIANT_OPAQUE,
+                                         &out_shader->pipelines[variant])) {
+      KERROR("vulkan_material_shader_create :: failed to create graphics pipeline (variant %u)", variant);
+      return false;
+    }
   }
 
-  // Create uniform buffer
-  u32 device_local_bits = context->device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
-  if (!vulkan_buffer_create(context,
-                            sizeof(vulkan_material_shader_global_ubo) * FRAME_DESCRIPTOR_COUNT,
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits,
-                            true,
-                            &out_shader->global_uniform_buffer)) {
-    KERROR("vulkan_material_shader_create :: failed to create object shader's buffer");
+  // Create uniform ring (the global UBO plus room for every instance UBO twice, see `update`)
+  if (!vulkan_uniform_ring_create(context,
+                                  sizeof(vulkan_material_shader_global_ubo),
+                                  sizeof(vulkan_material_shader_instance_ubo),
+                                  MATERIAL_SHADER_MAX_MATERIALS * 2,
+                                  &out_shader->uniform_ring)) {
+    KERROR("vulkan_material_shader_create :: failed to create the uniform ring");
     return false;
   }
 
-  VkDescriptorSetLayout global_layouts[FRAME_DESCRIPTOR_COUNT];
+  // Create instance buffers, each frame's global set points at its own one
+  out_shader->instance_capacity = MATERIAL_SHADER_INITIAL_INSTANCES;
   for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
-    global_layouts[i] = out_shader->global_descriptor_set_layout;
+    if (!create_frame_instances(context, out_shader, i)) {
+      KERROR("vulkan_material_shader_create :: failed to create the frame instance data");
+      return false;
+    }
   }
-  VkDescriptorSetAllocateInfo alloc_info = {
-    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-    .descriptorPool = out_shader->global_descriptor_pool,
-    .descriptorSetCount = FRAME_DESCRIPTOR_COUNT,
-    .pSetLayouts = global_layouts
-  };
-  VK_CHECK(vkAllocateDescriptorSets(context->device.logical_device,
-                                    &alloc_info,
-                                    out_shader->global_descriptor_sets));
 
-  // Create object uniform buffer
-  if (!vulkan_buffer_create(context,
-                            sizeof(vulkan_material_shader_instance_ubo) * MATERIAL_SHADER_MAX_MATERIALS,
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                            true,
-                            &out_shader->object_uniform_buffer)) {
-    KERROR("vulkan_material_shader_create :: Failed material instance buffer creation");
-    return false;
+  // Bindless materials only differ in uniform data, so they all share one set
+  if (out_shader->bindless) {
+    VkDescriptorSetAllocateInfo object_alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = out_shader->object_descriptor_pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &out_shader->object_descriptor_set_layout
+    };
+    VK_CHECK(vkAllocateDescriptorSets(context->device.logical_device,
+                                      &object_alloc_info,
+                                      &out_shader->material_descriptor_set));
+    VkDescriptorBufferInfo material_info = {
+      .buffer = out_shader->uniform_ring.buffer.handle,
+      .offset = 0,
+      .range = sizeof(vulkan_material_shader_instance_ubo)
+    };
+    VkWriteDescriptorSet material_write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = out_shader->material_descriptor_set,
+      .dstBinding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .pBufferInfo = &material_info
+    };
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &material_write, 0, 0);
   }
 
   return true;
 }
 
 void vulkan_material_shader_destroy(vulkan_context *context, vulkan_material_shader *shader) {
+  u64 material_pool_requirements = 0;
+  handle_pool_create(MATERIAL_SHADER_MAX_MATERIALS, &material_pool_requirements, 0, 0);
+  handle_pool_destroy(&shader->material_pool);
+  kfree(shader->material_pool_block, material_pool_requirements, MEMORY_TAG_RENDERER);
+  shader->material_pool_block = 0;
+
   vkDestroyDescriptorPool(context->device.logical_device,
                           shader->object_descriptor_pool,
                           context->allocator);
@@ -249,12 +407,16 @@ void vulkan_material_shader_destroy(vulkan_context *context, vulkan_material_sha
                                shader->object_descriptor_set_layout,
                                context->allocator);
 
-  // Destroy uniform buffers
-  vulkan_buffer_destroy(context, &shader->global_uniform_buffer);
-  vulkan_buffer_destroy(context, &shader->object_uniform_buffer);
+  // Destroy uniform ring and instance buffer
+  vulkan_uniform_ring_destroy(context, &shader->uniform_ring);
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
+    vulkan_buffer_destroy(context, &shader->instance_buffers[i]);
+  }
 
-  // Destroy pipeline
-  vulkan_pipeline_destroy(context, &shader->pipeline);
+  // Destroy pipelines
+  for (u32 i = 0; i < MATERIAL_SHADER_VARIANT_COUNT; ++i) {
+    vulkan_pipeline_destroy(context, &shader->pipelines[i]);
+  }
 
   // Destroy global descriptor pool
   vkDestroyDescriptorPool(context->device.logical_device,
@@ -276,72 +438,102 @@ void vulkan_material_shader_destroy(vulkan_context *context, vulkan_material_sha
 }
 
 void vulkan_material_shader_use(vulkan_context *context, vulkan_material_shader *shader) {
-  u32 img_idx = context->image_index;
-  vulkan_pipeline_bind(&context->graphics_command_buffers[img_idx],
+  u32 frame_idx = context->current_frame;
+  shader->bound_variant = MATERIAL_SHADER_VARIANT_OPAQUE;
+  vulkan_pipeline_bind(&context->frames[frame_idx].command_buffer,
                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-                       &shader->pipeline);
+                       &shader->pipelines[shader->bound_variant]);
+}
+
+vulkan_material_shader_variant vulkan_material_shader_variant_for(const material *material) {
+  // Same split as the frontend's transparent draw ordering
+  texture *t = material->diffuse_map.texture;
+  if (!t) return MATERIAL_SHADER_VARIANT_UNTEXTURED;
+  if (t->has_transparency || material->diffuse_color.a < 1.0f) return MATERIAL_SHADER_VARIANT_ALPHA_TESTED;
+  return MATERIAL_SHADER_VARIANT_OPAQUE;
+}
+
+void vulkan_material_shader_use_variant(vulkan_context *context,
+                                        vulkan_material_shader *shader,
+                                        vulkan_material_shader_variant variant) {
+  if (shader->bound_variant == variant) return;
+  shader->bound_variant = variant;
+  vulkan_pipeline_bind(&context->frames[context->current_frame].command_buffer,
+                       VK_PIPELINE_BIND_POINT_GRAPHICS,
+                       &shader->pipelines[variant]);
 }
 
 void vulkan_material_shader_update(vulkan_context *context,
                                    vulkan_material_shader *shader,
-                                   f32 delta_time) {
+                                   f32 delta_time,
+                                   u32 instance_count) {
   (void) delta_time;  // Unused parameter
 
-  u32 image_idx = context->image_index;
-  VkCommandBuffer command_buffer = context->graphics_command_buffers[image_idx].handle;
-  VkDescriptorSet global_descriptor = shader->global_descriptor_sets[image_idx];
-
-  u32 range = sizeof(vulkan_material_shader_global_ubo);
-  u64 offset = 0;
-  // Copy data to buffer
-  vulkan_buffer_load(context,
-                     &shader->global_uniform_buffer,
-                     offset,
-                     range,
-                     0,
-                     &shader->global_ubo);
-  VkDescriptorBufferInfo buffer_info = {
-    .buffer = shader->global_uniform_buffer.handle,
-    .offset = offset,
-    .range = range
-  };
-  // Update descriptor sets
-  VkWriteDescriptorSet descriptor_write = {
-    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    .dstSet = global_descriptor,
-    .dstBinding = 0,
-    .dstArrayElement = 0,
-    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .descriptorCount = 1,
-    .pBufferInfo = &buffer_info
-  };
-  vkUpdateDescriptorSets(context->device.logical_device,
-                         1,
-                         &descriptor_write,
-                         0,
-                         0);
+  u32 frame_idx = context->current_frame;
+  VkCommandBuffer command_buffer = context->frames[frame_idx].command_buffer.handle;
+  vulkan_uniform_ring *ring = &shader->uniform_ring;
+
+  // Grow once, before the set is bound: other frames catch up with the new capacity in their own update
+  while (shader->instance_capacity < instance_count) shader->instance_capacity *= 2;
+  u64 instance_size = sizeof(Matrix4) * shader->instance_capacity;
+  if (shader->instance_buffers[frame_idx].total_size < instance_size &&
+      !grow_frame_instances(context, shader, frame_idx)) {
+    KERROR("vulkan_material_shader_update :: failed to grow the instance buffer (%u instances)", instance_count);
+  }
+  VkDescriptorSet global_descriptor = shader->global_descriptor_sets[frame_idx];
+
+  // With room for every instance UBO left, a frame can never run out of space mid-recording
+  u64 ubo_size = vulkan_uniform_ring_align(ring, sizeof(vulkan_material_shader_instance_ubo));
+  vulkan_uniform_ring_begin_region(ring, frame_idx, ubo_size * MATERIAL_SHADER_MAX_MATERIALS);
+
+  // Copy data to the region's reserved slot
+  u32 offset = vulkan_uniform_ring_region_offset(ring, frame_idx);
+  vulkan_uniform_ring_write(ring, offset, &shader->global_ubo, sizeof(vulkan_material_shader_global_ubo));
+  shader->instance_count = 0;
 
   // Bind the descriptor set (global) to be updated
   vkCmdBindDescriptorSets(command_buffer,
                           VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          shader->pipeline.pipeline_layout,
+                          shader->pipelines[0].pipeline_layout,
                           0,
                           1,
                           &global_descriptor,
-                          0,
-                          0);
+                          1,
+                          &offset);
+  if (shader->bindless) {
+    vkCmdBindDescriptorSets(command_buffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            shader->pipelines[0].pipeline_layout,
+                            2,
+                            1,
+                            &context->bindless_textures.set,
+                            0,
+                            0);
+  }
 }
 
-void vulkan_material_shader_set_model(vulkan_context *context,
-                                      vulkan_material_shader *shader,
-                                      Matrix4 model) {
-  if (!context || !shader) return;
-  vkCmdPushConstants(context->graphics_command_buffers[context->image_index].handle,
-                     shader->pipeline.pipeline_layout,
-                     VK_SHADER_STAGE_VERTEX_BIT,
-                     0,
-                     sizeof(Matrix4),
-                     &model);
+b8 vulkan_material_shader_push_instances(vulkan_context *context,
+                                         vulkan_material_shader *shader,
+                                         const Matrix4 *models,
+                                         u32 count,
+                                         u32 *out_first_instance) {
+  if (!context || !shader) return false;
+  u32 frame_idx = context->current_frame;
+  // `update` sized the buffer for the whole frame, only more instances than announced (or a failed growth) land here
+  u64 frame_capacity = shader->instance_buffers[frame_idx].total_size / sizeof(Matrix4);
+  if (shader->instance_count + count > frame_capacity) {
+    KERROR("vulkan_material_shader_push_instances :: frame instance buffer full (%u + %u > %llu), draw skipped",
+           shader->instance_count,
+           count,
+           frame_capacity);
+    return false;
+  }
+  *out_first_instance = shader->instance_count;
+  kcopy_memory(shader->instance_buffers[frame_idx].allocation.mapped + sizeof(Matrix4) * *out_first_instance,
+               models,
+               sizeof(Matrix4) * count);
+  shader->instance_count += count;
+  return true;
 }
 
 void vulkan_material_shader_apply_material(vulkan_context *context,
@@ -349,52 +541,54 @@ void vulkan_material_shader_apply_material(vulkan_context *context,
                                            material *material) {
   if (!context || !shader) return;
   
-  u32 image_idx = context->image_index;
-  VkCommandBuffer command_buffer = context->graphics_command_buffers[image_idx].handle;
+  u32 frame_idx = context->current_frame;
+  VkCommandBuffer command_buffer = context->frames[frame_idx].command_buffer.handle;
 
   // Get material data
   vulkan_material_shader_instance_state *object_state = &shader->instance_states[material->internal_id];
-  VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[image_idx];
+  VkDescriptorSet object_descriptor_set = shader->bindless ? shader->material_descriptor_set
+                                                           : object_state->descriptor_sets[frame_idx];
 
   VkWriteDescriptorSet descriptor_writes[MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT];
   kzero_memory(descriptor_writes, sizeof(VkWriteDescriptorSet) * MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT);
 
   u32 descriptor_count = 0, descriptor_idx = 0;
 
-  // Descriptor 0: uniform buffer
-  u32 range = sizeof(vulkan_material_shader_instance_ubo);
-  u64 offset = sizeof(vulkan_material_shader_instance_ubo) * material->internal_id;
-  vulkan_material_shader_instance_ubo instance_ubo;
-
-  // Set instance UBO diffuse color from the material
-  instance_ubo.diffuse_color = material->diffuse_color;
-
-  vulkan_buffer_load(context,
-                     &shader->object_uniform_buffer,
-                     offset,
-                     range,
-                     0,
-                     &instance_ubo);
-
-  // If the descriptor has not been updated yet
-  u32 *global_ubo_generation = &object_state->descriptor_states[descriptor_idx].generations[image_idx];
-  if (*global_ubo_generation == INVALID_ID ||
-      *global_ubo_generation != material->generation) {
-    VkDescriptorBufferInfo buffer_info = {
-      .buffer = shader->object_uniform_buffer.handle,
-      .offset = offset,
-      .range = range
-    };
-    descriptor_writes[descriptor_count] = (VkWriteDescriptorSet) {
-      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      .dstSet = object_descriptor_set,
-      .dstBinding = descriptor_idx,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      .descriptorCount = 1,
-      .pBufferInfo = &buffer_info
-    };
-    ++descriptor_count;
-    *global_ubo_generation = material->generation;
+  // Descriptor 0: uniform buffer (written once in `get_resources`, only the data moves)
+  vulkan_material_shader_instance_ubo instance_ubo = {
+    .diffuse_color = material->diffuse_color
+  };
+  if (shader->bindless) {
+    texture *t = material->diffuse_map.texture;
+    if (!t || t->generation == INVALID_ID || !t->data) t = texture_system_get_fallback();
+    instance_ubo.diffuse_index = ((vulkan_texture_data *) t->data)->bindless_index;
+    // Cached copies hold the previous index once the texture loads or reloads
+    if (object_state->diffuse_index != instance_ubo.diffuse_index) {
+      vulkan_uniform_cache_reset(&object_state->ubo_cache);
+      object_state->diffuse_index = instance_ubo.diffuse_index;
+    }
+  }
+  u32 offset = 0;
+  if (!vulkan_uniform_cache_write(&shader->uniform_ring,
+                                  &object_state->ubo_cache,
+                                  context->current_frame,
+                                  material->generation,
+                                  &instance_ubo,
+                                  sizeof(vulkan_material_shader_instance_ubo),
+                                  &offset)) {
+    KERROR("vulkan_material_shader_apply_material :: failed to write the instance UBO");
+    return;
+  }
+  if (shader->bindless) {
+    vkCmdBindDescriptorSets(command_buffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            shader->pipelines[0].pipeline_layout,
+                            1,
+                            1,
+                            &object_descriptor_set,
+                            1,
+                            &offset);
+    return;
   }
   ++descriptor_idx;
 
@@ -412,8 +606,8 @@ void vulkan_material_shader_apply_material(vulkan_context *context,
       KFATAL("vulkan_material_shader_apply_material :: unable to bind sampler to unknown `texture_use`");
       return;
     }
-    u32 *descriptor_gen = &object_state->descriptor_states[descriptor_idx].generations[image_idx];
-    u32 *descriptor_id = &object_state->descriptor_states[descriptor_idx].ids[image_idx];
+    u32 *descriptor_gen = &object_state->descriptor_states[descriptor_idx].generations[frame_idx];
+    u32 *descriptor_id = &object_state->descriptor_states[descriptor_idx].ids[frame_idx];
 
     // If no texture is loaded, use the fallback one
     if (!t || t->generation == INVALID_ID) {
@@ -430,7 +624,7 @@ void vulkan_material_shader_apply_material(vulkan_context *context,
       image_infos[i] = (VkDescriptorImageInfo) {
         .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         .imageView = internal_data->image.view,
-        .sampler = internal_data->sampler
+        .sampler = vulkan_sampler_cache_get(&context->sampler_cache, internal_data->sampler)
       };
       descriptor_writes[descriptor_count] = (VkWriteDescriptorSet) {
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -456,21 +650,31 @@ void vulkan_material_shader_apply_material(vulkan_context *context,
                                                    0);
   vkCmdBindDescriptorSets(command_buffer,
                           VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          shader->pipeline.pipeline_layout,
+                          shader->pipelines[0].pipeline_layout,
                           1,
                           1,
                           &object_descriptor_set,
-                          0,
-                          0);
+                          1,
+                          &offset);
 }
 
 b8 vulkan_material_shader_get_resources(vulkan_context *context,
                                         vulkan_material_shader *shader,
                                         material *material) {
-  material->internal_id = shader->object_uniform_buffer_index;
-  ++shader->object_uniform_buffer_index;
+  khandle handle;
+  if (!handle_pool_acquire(&shader->material_pool, &handle)) {
+    KERROR("vulkan_material_shader_get_resources :: material limit reached (%u)", MATERIAL_SHADER_MAX_MATERIALS);
+    return false;
+  }
+  material->internal_id = handle.index;
 
   vulkan_material_shader_instance_state *instance_state = &shader->instance_states[material->internal_id];
+  if (shader->bindless) {
+    // No per-material descriptors, textures are picked through `diffuse_index`
+    instance_state->diffuse_index = INVALID_ID;
+    vulkan_uniform_cache_reset(&instance_state->ubo_cache);
+    return true;
+  }
   for (u32 i = 0; i < MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT; ++i) {
     for (u32 j = 0; j < FRAME_DESCRIPTOR_COUNT; ++j) {
       instance_state->descriptor_states[i].generations[j] = INVALID_ID;
@@ -494,8 +698,34 @@ b8 vulkan_material_shader_get_resources(vulkan_context *context,
                                              instance_state->descriptor_sets);
   if (result != VK_SUCCESS) {
     KERROR("vulkan_material_shader_get_resources :: Failed descriptor sets allocation");
+    handle_pool_release(&shader->material_pool, handle);
+    material->internal_id = INVALID_ID;
     return false;
   }
+
+  // The instance UBO descriptor never changes, `apply_material` only moves its dynamic offset
+  VkDescriptorBufferInfo buffer_info = {
+    .buffer = shader->uniform_ring.buffer.handle,
+    .offset = 0,
+    .range = sizeof(vulkan_material_shader_instance_ubo)
+  };
+  VkWriteDescriptorSet descriptor_writes[FRAME_DESCRIPTOR_COUNT];
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
+    descriptor_writes[i] = (VkWriteDescriptorSet) {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = instance_state->descriptor_sets[i],
+      .dstBinding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .pBufferInfo = &buffer_info
+    };
+  }
+  vkUpdateDescriptorSets(context->device.logical_device,
+                         FRAME_DESCRIPTOR_COUNT,
+                         descriptor_writes,
+                         0,
+                         0);
+  vulkan_uniform_cache_reset(&instance_state->ubo_cache);
   return true;
 }
 
@@ -504,15 +734,12 @@ void vulkan_material_shader_release_resources(vulkan_context *context,
                                               material *material) {
   vulkan_material_shader_instance_state *instance_state = &shader->instance_states[material->internal_id];
 
-  // Wait for any pending ops using the DescriptorSet to finish
-  vkDeviceWaitIdle(context->device.logical_device);
-  
-  VkResult result = vkFreeDescriptorSets(context->device.logical_device,
-                                         shader->object_descriptor_pool,
-                                         FRAME_DESCRIPTOR_COUNT,
-                                         instance_state->descriptor_sets);
-  if (result != VK_SUCCESS) {
-    KERROR("vulkan_material_shader_release_resources :: Failed descriptor sets free");
+  // Frames in flight may still bind the descriptor sets
+  if (!shader->bindless) {
+    vulkan_deletion_queue_push_descriptor_sets(&context->deletion_queue,
+                                               shader->object_descriptor_pool,
+                                               FRAME_DESCRIPTOR_COUNT,
+                                               instance_state->descriptor_sets);
   }
 
   for (u32 i = 0; i < MATERIAL_SHADER_OBJECT_DESCRIPTOR_COUNT; ++i) {
@@ -522,5 +749,9 @@ void vulkan_material_shader_release_resources(vulkan_context *context,
     }
   }
 
+  // The slot's instance state must not be reused while a frame in flight may still draw with it
+  vulkan_deletion_queue_push_handle(&context->deletion_queue,
+                                    &shader->material_pool,
+                                    handle_pool_from_index(&shader->material_pool, material->internal_id));
   material->internal_id = INVALID_ID;
 }
@@ -0,0 +1,331 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <darray.h>
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_memory.h>
+
+static u64 align_up(u64 value, u64 alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static vulkan_memory_heap_stats *heap_stats(vulkan_context *context, u32 memory_type) {
+  return &context->memory_allocator.heaps[context->device.memory.memoryTypes[memory_type].heapIndex];
+}
+
+static b8 is_host_visible(vulkan_context *context, u32 memory_type) {
+  return (context->device.memory.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+static b8 allocate_memory(vulkan_context *context,
+                          u32 memory_type,
+                          u64 size,
+                          const void *next,
+                          VkDeviceMemory *out_memory,
+                          u8 **out_mapped) {
+  VkMemoryAllocateInfo allocate_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .pNext = next,
+    .allocationSize = size,
+    .memoryTypeIndex = memory_type
+  };
+  VkResult result = vkAllocateMemory(context->device.logical_device,
+                                     &allocate_info,
+                                     context->allocator,
+                                     out_memory);
+  if (result != VK_SUCCESS) {
+    KERROR("vulkan_memory :: failed to allocate %llu bytes from memory type %u (%i)", size, memory_type, result);
+    return false;
+  }
+  *out_mapped = 0;
+  // Host visible memory is mapped once for its whole lifetime (it cannot be mapped twice)
+  if (is_host_visible(context, memory_type)) {
+    VK_CHECK(vkMapMemory(context->device.logical_device,
+                         *out_memory,
+                         0,
+                         VK_WHOLE_SIZE,
+                         0,
+                         (void **) out_mapped));
+  }
+  return true;
+}
+
+static void free_memory(vulkan_context *context, VkDeviceMemory memory, u8 *mapped) {
+  if (mapped) vkUnmapMemory(context->device.logical_device, memory);
+  vkFreeMemory(context->device.logical_device, memory, context->allocator);
+}
+
+static b8 create_block(vulkan_context *context, u32 memory_type, vulkan_memory_block *out_block) {
+  kzero_memory(out_block, sizeof(vulkan_memory_block));
+  if (!allocate_memory(context, memory_type, VULKAN_MEMORY_BLOCK_SIZE, 0, &out_block->memory, &out_block->mapped)) {
+    return false;
+  }
+  u64 list_requirements = 0;
+  free_list_create_with_max_entries(VULKAN_MEMORY_BLOCK_SIZE, VULKAN_MEMORY_BLOCK_MAX_ENTRIES, &list_requirements, 0, 0);
+  out_block->list_block = kallocate(list_requirements, MEMORY_TAG_RENDERER);
+  free_list_create_with_max_entries(VULKAN_MEMORY_BLOCK_SIZE,
+                                    VULKAN_MEMORY_BLOCK_MAX_ENTRIES,
+                                    &list_requirements,
+                                    out_block->list_block,
+                                    &out_block->list);
+
+  vulkan_memory_heap_stats *stats = heap_stats(context, memory_type);
+  stats->block_bytes += VULKAN_MEMORY_BLOCK_SIZE;
+  ++stats->block_count;
+  KDEBUG("Vulkan memory block created (memory type %u, %u blocks in heap)", memory_type, stats->block_count);
+  return true;
+}
+
+static void destroy_block(vulkan_context *context, u32 memory_type, vulkan_memory_block *block) {
+  if (!block->memory) return;
+  u64 list_requirements = 0;
+  free_list_create_with_max_entries(VULKAN_MEMORY_BLOCK_SIZE, VULKAN_MEMORY_BLOCK_MAX_ENTRIES, &list_requirements, 0, 0);
+  free_list_destroy(&block->list);
+  kfree(block->list_block, list_requirements, MEMORY_TAG_RENDERER);
+  free_memory(context, block->memory, block->mapped);
+
+  vulkan_memory_heap_stats *stats = heap_stats(context, memory_type);
+  stats->block_bytes -= VULKAN_MEMORY_BLOCK_SIZE;
+  --stats->block_count;
+  kzero_memory(block, sizeof(vulkan_memory_block));
+}
+
+static b8 allocate_dedicated(vulkan_context *context,
+                             VkImage image,
+                             VkBuffer buffer,
+                             vulkan_allocation *out_allocation) {
+  VkMemoryDedicatedAllocateInfo dedicated_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+    .image = image,
+    .buffer = buffer
+  };
+  if (!allocate_memory(context,
+                       out_allocation->memory_type,
+                       out_allocation->size,
+                       &dedicated_info,
+                       &out_allocation->memory,
+                       &out_allocation->mapped)) {
+    return false;
+  }
+  vulkan_memory_heap_stats *stats = heap_stats(context, out_allocation->memory_type);
+  stats->dedicated_bytes += out_allocation->size;
+  stats->used_bytes += out_allocation->size;
+  ++stats->dedicated_count;
+  return true;
+}
+
+static b8 allocate(vulkan_context *context,
+                   const VkMemoryRequirements *requirements,
+                   b8 prefers_dedicated,
+                   u32 memory_property_flags,
+                   vulkan_memory_resource_kind kind,
+                   VkImage image,
+                   VkBuffer buffer,
+                   vulkan_allocation *out_allocation) {
+  vulkan_memory_allocator *allocator = &context->memory_allocator;
+  kzero_memory(out_allocation, sizeof(vulkan_allocation));
+  out_allocation->block = INVALID_ID;
+
+  i32 memory_type = context->find_memory_index(requirements->memoryTypeBits, memory_property_flags);
+  if (memory_type == -1) {
+    KERROR("vulkan_memory :: required memory type idx not found");
+    return false;
+  }
+  out_allocation->memory_type = (u32) memory_type;
+  out_allocation->kind = allocator->separate_optimal ? kind : VULKAN_MEMORY_RESOURCE_LINEAR;
+  out_allocation->size = requirements->size;
+  ++allocator->allocation_count;
+
+  if (prefers_dedicated || requirements->size >= VULKAN_MEMORY_DEDICATED_THRESHOLD) {
+    return allocate_dedicated(context, image, buffer, out_allocation);
+  }
+
+  // Ranges are multiples of the minimum alignment, so only bigger alignments need padding
+  u64 alignment = requirements->alignment > VULKAN_MEMORY_MIN_ALIGNMENT ? requirements->alignment : VULKAN_MEMORY_MIN_ALIGNMENT;
+  u32 range_size = (u32) (align_up(requirements->size, VULKAN_MEMORY_MIN_ALIGNMENT) + alignment - VULKAN_MEMORY_MIN_ALIGNMENT);
+
+  vulkan_memory_block **blocks = &allocator->blocks[memory_type][out_allocation->kind];
+  u32 block_count = darray_length(*blocks);
+  u32 range_offset = 0;
+  u32 block_index = INVALID_ID;
+  u32 empty_slot = INVALID_ID;
+  for (u32 i = 0; i < block_count; ++i) {
+    if (!(*blocks)[i].memory) {
+      if (empty_slot == INVALID_ID) empty_slot = i;
+      continue;
+    }
+    if (free_list_alloc_below(&(*blocks)[i].list, range_size, VULKAN_MEMORY_BLOCK_SIZE, &range_offset)) {
+      block_index = i;
+      break;
+    }
+  }
+  if (block_index == INVALID_ID) {
+    vulkan_memory_block block;
+    if (!create_block(context, out_allocation->memory_type, &block)) return false;
+    if (empty_slot == INVALID_ID) {
+      empty_slot = block_count;
+      darray_push(*blocks, block);
+    } else {
+      (*blocks)[empty_slot] = block;
+    }
+    block_index = empty_slot;
+    if (!free_list_alloc(&(*blocks)[block_index].list, range_size, &range_offset)) return false;
+  }
+
+  vulkan_memory_block *block = &(*blocks)[block_index];
+  block->used += range_size;
+  heap_stats(context, out_allocation->memory_type)->used_bytes += requirements->size;
+
+  out_allocation->memory = block->memory;
+  out_allocation->offset = align_up(range_offset, alignment);
+  out_allocation->mapped = block->mapped ? block->mapped + out_allocation->offset : 0;
+  out_allocation->block = block_index;
+  out_allocation->range_offset = range_offset;
+  out_allocation->range_size = range_size;
+  return true;
+}
+
+b8 vulkan_memory_allocator_create(vulkan_context *context, vulkan_memory_allocator *out_allocator) {
+  kzero_memory(out_allocator, sizeof(vulkan_memory_allocator));
+  for (u32 i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    for (u32 j = 0; j < VULKAN_MEMORY_RESOURCE_KIND_COUNT; ++j) {
+      out_allocator->blocks[i][j] = darray_create(vulkan_memory_block);
+    }
+  }
+  out_allocator->separate_optimal = context->device.properties.limits.bufferImageGranularity > VULKAN_MEMORY_MIN_ALIGNMENT;
+  KDEBUG("Vulkan memory allocator created (buffer-image granularity %llu)",
+         context->device.properties.limits.bufferImageGranularity);
+  return true;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context *context, vulkan_memory_allocator *allocator) {
+  vulkan_memory_log_usage(context);
+  for (u32 i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    for (u32 j = 0; j < VULKAN_MEMORY_RESOURCE_KIND_COUNT; ++j) {
+      u32 block_count = darray_length(allocator->blocks[i][j]);
+      for (u32 k = 0; k < block_count; ++k) {
+        if (allocator->blocks[i][j][k].used) KWARN("Vulkan memory block destroyed with live allocations");
+        destroy_block(context, i, &allocator->blocks[i][j][k]);
+      }
+      darray_destroy(allocator->blocks[i][j]);
+      allocator->blocks[i][j] = 0;
+    }
+  }
+}
+
+b8 vulkan_memory_allocate_buffer(vulkan_context *context,
+                                 VkBuffer buffer,
+                                 u32 memory_property_flags,
+                                 vulkan_allocation *out_allocation) {
+  VkBufferMemoryRequirementsInfo2 requirements_info = {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+    .buffer = buffer
+  };
+  VkMemoryDedicatedRequirements dedicated_requirements = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS
+  };
+  VkMemoryRequirements2 requirements = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+    .pNext = &dedicated_requirements
+  };
+  vkGetBufferMemoryRequirements2(context->device.logical_device, &requirements_info, &requirements);
+  return allocate(context,
+                  &requirements.memoryRequirements,
+                  dedicated_requirements.prefersDedicatedAllocation,
+                  memory_property_flags,
+                  VULKAN_MEMORY_RESOURCE_LINEAR,
+                  0,
+                  buffer,
+                  out_allocation);
+}
+
+b8 vulkan_memory_allocate_image(vulkan_context *context,
+                                VkImage image,
+                                VkImageTiling tiling,
+                                u32 memory_property_flags,
+                                vulkan_allocation *out_allocation) {
+  VkImageMemoryRequirementsInfo2 requirements_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+    .image = image
+  };
+  VkMemoryDedicatedRequirements dedicated_requirements = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS
+  };
+  VkMemoryRequirements2 requirements = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+    .pNext = &dedicated_requirements
+  };
+  vkGetImageMemoryRequirements2(context->device.logical_device, &requirements_info, &requirements);
+  return allocate(context,
+                  &requirements.memoryRequirements,
+                  dedicated_requirements.prefersDedicatedAllocation,
+                  memory_property_flags,
+                  tiling == VK_IMAGE_TILING_OPTIMAL ? VULKAN_MEMORY_RESOURCE_OPTIMAL : VULKAN_MEMORY_RESOURCE_LINEAR,
+                  image,
+                  0,
+                  out_allocation);
+}
+
+void vulkan_memory_free(vulkan_context *context, vulkan_allocation *allocation) {
+  if (!allocation->memory) return;
+  vulkan_memory_heap_stats *stats = heap_stats(context, allocation->memory_type);
+  stats->used_bytes -= allocation->size;
+
+  if (allocation->block == INVALID_ID) {
+    free_memory(context, allocation->memory, allocation->mapped);
+    stats->dedicated_bytes -= allocation->size;
+    --stats->dedicated_count;
+  } else {
+    vulkan_memory_block *blocks = context->memory_allocator.blocks[allocation->memory_type][allocation->kind];
+    vulkan_memory_block *block = &blocks[allocation->block];
+    // `used` must keep matching the free list, or the block would be destroyed (or kept) wrongly
+    if (free_list_free(&block->list, allocation->range_size, allocation->range_offset)) {
+      block->used -= allocation->range_size;
+    } else {
+      KERROR("vulkan_memory_free :: failed to return range (offset: %u B, size: %u B) to block %u",
+             allocation->range_offset,
+             allocation->range_size,
+             allocation->block);
+    }
+    // The first block of each pool is kept around to avoid churn on small workloads
+    if (!block->used && allocation->block != 0) destroy_block(context, allocation->memory_type, block);
+  }
+  kzero_memory(allocation, sizeof(vulkan_allocation));
+  allocation->block = INVALID_ID;
+}
+
+void vulkan_memory_log_usage(vulkan_context *context) {
+  const f32 mib = 1024.0f * 1024.0f;
+  for (u32 i = 0; i < context->device.memory.memoryHeapCount; ++i) {
+    vulkan_memory_heap_stats *stats = &context->memory_allocator.heaps[i];
+    KDEBUG("Vulkan heap %u (%s, %.2f MiB) :: %.2f MiB used, %.2f MiB in %u blocks, %.2f MiB in %u dedicated allocations",
+           i,
+           (context->device.memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host",
+           context->device.memory.memoryHeaps[i].size / mib,
+           stats->used_bytes / mib,
+           stats->block_bytes / mib,
+           stats->block_count,
+           stats->dedicated_bytes / mib,
+           stats->dedicated_count);
+  }
+  KDEBUG("Vulkan memory allocations made :: %llu", context->memory_allocator.allocation_count);
+}
@@ -38,6 +38,7 @@ b8 vulkan_graphics_pipeline_create(vulkan_context *context,
                                    VkRect2D scissor,
                                    b8 is_wireframe,
                                    b8 depth_test_enabled,
+                                   b8 blend_enabled,
                                    vulkan_pipeline *out_pipeline) {
   // Dynamic state
   const u32 dynamic_state_count = 3;
@@ -89,7 +90,7 @@ b8 vulkan_graphics_pipeline_create(vulkan_context *context,
     };
   }
   VkPipelineColorBlendAttachmentState color_blend_attachment_state = {
-    .blendEnable = VK_TRUE,
+    .blendEnable = blend_enabled ? VK_TRUE : VK_FALSE,
     .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
     .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
     .colorBlendOp = VK_BLEND_OP_ADD,
@@ -168,7 +169,7 @@ b8 vulkan_graphics_pipeline_create(vulkan_context *context,
 
   // Create graphics pipeline
   VkResult result = vkCreateGraphicsPipelines(context->device.logical_device,
-                                              VK_NULL_HANDLE,
+                                              context->pipeline_cache,
                                               1,
                                               &pipeline_create_info,
                                               context->allocator,
@@ -0,0 +1,175 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <khash.h>
+#include <logger.h>
+#include <kmemory.h>
+#include <kstring.h>
+#include <platform.h>
+#include <filesystem.h>
+#include <vulkan_utils.h>
+#include <vulkan_pipeline_cache.h>
+
+#define PIPELINE_CACHE_MAGIC 0x43504757  // "WGPC"
+#define PIPELINE_CACHE_PATH_MAX_LEN 512
+#define PIPELINE_CACHE_TEMP_SUFFIX ".tmp"
+
+// Prepended to the driver blob, which only identifies the device and not the driver build
+typedef struct {
+  u32 magic;
+  u32 vendor_id;
+  u32 device_id;
+  u32 driver_version;
+  u8 uuid[VK_UUID_SIZE];
+  u64 data_size;
+  u64 data_hash;
+} pipeline_cache_header;
+
+// `out_path` holds PIPELINE_CACHE_PATH_MAX_LEN bytes, with room left for the temp suffix
+static b8 get_cache_path(char *out_path) {
+  char dir[PIPELINE_CACHE_PATH_MAX_LEN];
+  if (!platform_get_executable_dir(dir, PIPELINE_CACHE_PATH_MAX_LEN)) return false;
+  // kstrfmt is unbounded: "<dir>/<file><suffix>\0" must fit before formatting
+  u64 len = kstrlen(dir) + 1 + kstrlen(VULKAN_PIPELINE_CACHE_FILE) + kstrlen(PIPELINE_CACHE_TEMP_SUFFIX);
+  if (len >= PIPELINE_CACHE_PATH_MAX_LEN) {
+    KWARN("vulkan_pipeline_cache :: executable path too long, pipeline cache disabled");
+    return false;
+  }
+  kstrfmt(out_path, "%s/%s", dir, VULKAN_PIPELINE_CACHE_FILE);
+  return true;
+}
+
+static b8 header_matches(vulkan_context *context, const pipeline_cache_header *header) {
+  const VkPhysicalDeviceProperties *properties = &context->device.properties;
+  if (header->magic != PIPELINE_CACHE_MAGIC ||
+      header->vendor_id != properties->vendorID ||
+      header->device_id != properties->deviceID ||
+      header->driver_version != properties->driverVersion) return false;
+  for (u32 i = 0; i < VK_UUID_SIZE; ++i) {
+    if (header->uuid[i] != properties->pipelineCacheUUID[i]) return false;
+  }
+  return true;
+}
+
+// Returns the validated driver blob (owned by the caller) or 0
+static u8 *load_cache_data(vulkan_context *context, const char *path, u64 *out_size) {
+  file_handle fd;
+  if (!filesystem_exists(path) || !filesystem_open(path, FILE_MODE_READ, true, &fd)) return 0;
+  u64 file_size = 0;
+  pipeline_cache_header header;
+  u64 read = 0;
+  u8 *data = 0;
+  if (filesystem_sizeof(&fd, &file_size) &&
+      file_size > sizeof(pipeline_cache_header) &&
+      filesystem_read(&fd, sizeof(pipeline_cache_header), &header, &read) &&
+      read == sizeof(pipeline_cache_header) &&
+      header.data_size == file_size - sizeof(pipeline_cache_header) &&
+      header_matches(context, &header)) {
+    data = kallocate(header.data_size, MEMORY_TAG_RENDERER);
+    if (!filesystem_read(&fd, header.data_size, data, &read) ||
+        read != header.data_size ||
+        khash(data, header.data_size, KHASH_DEFAULT_SEED) != header.data_hash) {
+      kfree(data, header.data_size, MEMORY_TAG_RENDERER);
+      data = 0;
+    }
+  }
+  filesystem_close(&fd);
+  if (!data) {
+    KINFO("vulkan_pipeline_cache :: ignoring stale or corrupt cache '%s'", path);
+    return 0;
+  }
+  *out_size = header.data_size;
+  return data;
+}
+
+void vulkan_pipeline_cache_create(vulkan_context *context, VkPipelineCache *out_cache) {
+  char path[PIPELINE_CACHE_PATH_MAX_LEN];
+  u64 data_size = 0;
+  u8 *data = get_cache_path(path) ? load_cache_data(context, path, &data_size) : 0;
+
+  VkPipelineCacheCreateInfo cache_info = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .initialDataSize = data_size,
+    .pInitialData = data
+  };
+  VkResult result = vkCreatePipelineCache(context->device.logical_device,
+                                          &cache_info,
+                                          context->allocator,
+                                          out_cache);
+  if (!vulkan_result_is_success(result) && data) {
+    // The driver may still reject the blob, start empty rather than without a cache
+    KWARN("vulkan_pipeline_cache :: saved cache rejected (%s)", vulkan_result_string(result, true));
+    cache_info.initialDataSize = 0;
+    cache_info.pInitialData = 0;
+    result = vkCreatePipelineCache(context->device.logical_device,
+                                   &cache_info,
+                                   context->allocator,
+                                   out_cache);
+  }
+  if (!vulkan_result_is_success(result)) {
+    KWARN("vulkan_pipeline_cache :: pipelines will be created uncached (%s)", vulkan_result_string(result, true));
+    *out_cache = VK_NULL_HANDLE;
+  }
+  else if (data) KINFO("Pipeline cache loaded (%llu B)", data_size);
+  if (data) kfree(data, data_size, MEMORY_TAG_RENDERER);
+}
+
+void vulkan_pipeline_cache_destroy(vulkan_context *context, VkPipelineCache cache) {
+  if (!cache) return;
+  char path[PIPELINE_CACHE_PATH_MAX_LEN];
+  size_t data_size = 0;  // not u64, Vulkan takes a `size_t *`
+  if (get_cache_path(path) &&
+      vkGetPipelineCacheData(context->device.logical_device, cache, &data_size, 0) == VK_SUCCESS &&
+      data_size) {
+    // The second query may report fewer bytes than were allocated
+    u64 allocated_size = (u64) data_size;
+    u8 *data = kallocate(allocated_size, MEMORY_TAG_RENDERER);
+    // Written aside and renamed over, so a crash mid-write never leaves a truncated cache behind
+    char temp_path[PIPELINE_CACHE_PATH_MAX_LEN];
+    kstrfmt(temp_path, "%s%s", path, PIPELINE_CACHE_TEMP_SUFFIX);
+    file_handle fd;
+    if (vkGetPipelineCacheData(context->device.logical_device, cache, &data_size, data) == VK_SUCCESS &&
+        filesystem_open(temp_path, FILE_MODE_WRITE, true, &fd)) {
+      const VkPhysicalDeviceProperties *properties = &context->device.properties;
+      pipeline_cache_header header = {
+        .magic = PIPELINE_CACHE_MAGIC,
+        .vendor_id = properties->vendorID,
+        .device_id = properties->deviceID,
+        .driver_version = properties->driverVersion,
+        .data_size = (u64) data_size,
+        .data_hash = khash(data, (u64) data_size, KHASH_DEFAULT_SEED)
+      };
+      kcopy_memory(header.uuid, properties->pipelineCacheUUID, VK_UUID_SIZE);
+      u64 written = 0;
+      b8 saved = filesystem_write(&fd, sizeof(pipeline_cache_header), &header, &written) &&
+        filesystem_write(&fd, (u64) data_size, data, &written);
+      filesystem_close(&fd);
+      if (!saved) {
+        KWARN("vulkan_pipeline_cache :: failed to write '%s'", temp_path);
+      }
+      else if (!filesystem_rename(temp_path, path)) {
+        KWARN("vulkan_pipeline_cache :: failed to replace '%s'", path);
+      }
+    }
+    kfree(data, allocated_size, MEMORY_TAG_RENDERER);
+  }
+  vkDestroyPipelineCache(context->device.logical_device, cache, context->allocator);
+}
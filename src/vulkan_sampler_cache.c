@@ -0,0 +1,116 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_utils.h>
+#include <vulkan_sampler_cache.h>
+
+static b8 desc_equal(const vulkan_sampler_desc *a, const vulkan_sampler_desc *b) {
+  return a->filter == b->filter &&
+         a->mipmap_mode == b->mipmap_mode &&
+         a->address_mode == b->address_mode &&
+         a->max_anisotropy == b->max_anisotropy;
+}
+
+void vulkan_sampler_cache_create(vulkan_sampler_cache *out_cache) {
+  kzero_memory(out_cache, sizeof(vulkan_sampler_cache));
+}
+
+void vulkan_sampler_cache_destroy(vulkan_context *context, vulkan_sampler_cache *cache) {
+  for (u32 i = 0; i < cache->count; ++i) {
+    if (cache->ref_counts[i]) {
+      KWARN("vulkan_sampler_cache_destroy :: sampler %u still has %u references", i, cache->ref_counts[i]);
+    }
+    vkDestroySampler(context->device.logical_device, cache->samplers[i], context->allocator);
+  }
+  KDEBUG("vulkan_sampler_cache :: %u distinct samplers were created", cache->count);
+  kzero_memory(cache, sizeof(vulkan_sampler_cache));
+}
+
+b8 vulkan_sampler_cache_acquire(vulkan_context *context,
+                                vulkan_sampler_cache *cache,
+                                const vulkan_sampler_desc *desc,
+                                u32 *out_handle) {
+  // Clamped first, so requests above the device limit share one entry
+  vulkan_sampler_desc key = *desc;
+  f32 limit = context->device.properties.limits.maxSamplerAnisotropy;
+  if (key.max_anisotropy > limit) key.max_anisotropy = limit;
+  if (key.max_anisotropy < 1.0f) key.max_anisotropy = 0;
+
+  for (u32 i = 0; i < cache->count; ++i) {
+    if (!desc_equal(&cache->descs[i], &key)) continue;
+    ++cache->ref_counts[i];
+    *out_handle = i;
+    return true;
+  }
+
+  if (cache->count == VULKAN_SAMPLER_CACHE_MAX_COUNT) {
+    KERROR("vulkan_sampler_cache_acquire :: cache is full (%u distinct samplers)", VULKAN_SAMPLER_CACHE_MAX_COUNT);
+    return false;
+  }
+  // Views limit the levels, so one sampler serves every mip chain length
+  VkSamplerCreateInfo sampler_info = {
+    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+    .magFilter = key.filter,
+    .minFilter = key.filter,
+    .addressModeU = key.address_mode,
+    .addressModeV = key.address_mode,
+    .addressModeW = key.address_mode,
+    .anisotropyEnable = key.max_anisotropy > 0 ? VK_TRUE : VK_FALSE,
+    .maxAnisotropy = key.max_anisotropy,
+    .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+    .unnormalizedCoordinates = VK_FALSE,
+    .compareEnable = VK_FALSE,
+    .compareOp = VK_COMPARE_OP_ALWAYS,
+    .mipmapMode = key.mipmap_mode,
+    .mipLodBias = 0,
+    .minLod = 0,
+    .maxLod = VK_LOD_CLAMP_NONE
+  };
+  u32 index = cache->count;
+  VkResult result = vkCreateSampler(context->device.logical_device,
+                                    &sampler_info,
+                                    context->allocator,
+                                    &cache->samplers[index]);
+  if (!vulkan_result_is_success(result)) {
+    KERROR("vulkan_sampler_cache_acquire :: failed to create sampler: %s", vulkan_result_string(result, true));
+    return false;
+  }
+  cache->descs[index] = key;
+  cache->ref_counts[index] = 1;
+  ++cache->count;
+  *out_handle = index;
+  return true;
+}
+
+void vulkan_sampler_cache_release(vulkan_sampler_cache *cache, u32 handle) {
+  if (handle >= cache->count || !cache->ref_counts[handle]) {
+    KWARN("vulkan_sampler_cache_release :: invalid sampler handle %u", handle);
+    return;
+  }
+  --cache->ref_counts[handle];
+}
+
+VkSampler vulkan_sampler_cache_get(vulkan_sampler_cache *cache, u32 handle) {
+  KASSERT_MSG(handle < cache->count, "vulkan_sampler_cache_get :: invalid sampler handle");
+  return cache->samplers[handle];
+}
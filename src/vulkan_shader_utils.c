@@ -24,9 +24,21 @@
 #include <kmemory.h>
 #include <resource_system.h>
 #include <vulkan_shader_utils.h>
+#include <vulkan_embedded_shaders.h>
 
 #define FILENAME_MAX_LEN 512
 
+static const vulkan_embedded_shader *find_embedded_shader(const char *name) {
+#if defined(WGE_EMBED_SHADERS)
+  for (u32 i = 0; i < vulkan_embedded_shader_count; ++i) {
+    if (kstrcmp(vulkan_embedded_shaders[i].name, name)) return &vulkan_embedded_shaders[i];
+  }
+#else
+  (void) name;  // Unused parameter
+#endif
+  return 0;
+}
+
 b8 create_shader_module(vulkan_context *context,
                         const char *name,
                         const char *type,
@@ -34,15 +46,27 @@ b8 create_shader_module(vulkan_context *context,
                         u32 stage_idx,
                         vulkan_shader_stage *shader_stages) {
   char filename[FILENAME_MAX_LEN];
-  kstrfmt(filename, "shaders/%s.%s.spv", name, type);
+  kstrfmt(filename, "%s.%s", name, type);
 
-  // Read binary resource
-  resource binary_resource;
-  if (!resource_system_load(filename,
-                            RESOURCE_TYPE_BINARY,
-                            &binary_resource)) {
-    KERROR("create_shader_module :: failed to read shader module '%s'", filename);
-    return false;
+  // Prefer the blob linked into the engine, shaders missing from it still load from disk
+  resource binary_resource = {0};
+  const vulkan_embedded_shader *embedded = find_embedded_shader(filename);
+  const void *code = 0;
+  u64 code_size = 0;
+  if (embedded) {
+    code = embedded->code;
+    code_size = embedded->size;
+  }
+  else {
+    kstrfmt(filename, "shaders/%s.%s.spv", name, type);
+    if (!resource_system_load(filename,
+                              RESOURCE_TYPE_BINARY,
+                              &binary_resource)) {
+      KERROR("create_shader_module :: failed to read shader module '%s'", filename);
+      return false;
+    }
+    code = binary_resource.data;
+    code_size = binary_resource.data_size;
   }
 
   // Save buffer to 'create info' struct and close file
@@ -50,8 +74,8 @@ b8 create_shader_module(vulkan_context *context,
                sizeof(VkShaderModuleCreateInfo));
   shader_stages[stage_idx].create_info = (VkShaderModuleCreateInfo) {
     .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-    .codeSize = binary_resource.data_size,
-    .pCode = (u32 *) binary_resource.data
+    .codeSize = code_size,
+    .pCode = (const u32 *) code
   };
 
   VK_CHECK(vkCreateShaderModule(context->device.logical_device,
@@ -59,7 +83,7 @@ b8 create_shader_module(vulkan_context *context,
                                 context->allocator,
                                 &shader_stages[stage_idx].handle));
 
-  resource_system_unload(&binary_resource);
+  if (!embedded) resource_system_unload(&binary_resource);
 
   kzero_memory(&shader_stages[stage_idx].shader_stage_create_info,
                sizeof(VkPipelineShaderStageCreateInfo));
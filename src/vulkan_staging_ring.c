@@ -0,0 +1,297 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_image.h>
+#include <vulkan_buffer.h>
+#include <vulkan_staging_ring.h>
+#include <vulkan_command_buffer.h>
+
+#define VULKAN_STAGING_MIN_ALIGNMENT 16
+
+static vulkan_staging_batch *current_batch(vulkan_staging_ring *ring) {
+  return &ring->batches[(ring->first_in_flight + ring->in_flight_count) % VULKAN_STAGING_BATCH_COUNT];
+}
+
+// Frees the space of the oldest submitted batch (returns false if it is still running and `wait` is false)
+static b8 retire_oldest_batch(vulkan_context *context, vulkan_staging_ring *ring, b8 wait) {
+  vulkan_staging_batch *batch = &ring->batches[ring->first_in_flight];
+  if (wait) {
+    VK_CHECK(vkWaitForFences(context->device.logical_device, 1, &batch->fence, true, UINT64_MAX));
+  }
+  else if (vkGetFenceStatus(context->device.logical_device, batch->fence) != VK_SUCCESS) return false;
+  ring->tail = batch->end;
+  ring->completed_serial = batch->serial;
+  ring->first_in_flight = (ring->first_in_flight + 1) % VULKAN_STAGING_BATCH_COUNT;
+  --ring->in_flight_count;
+  return true;
+}
+
+static void begin_batch(vulkan_context *context, vulkan_staging_ring *ring) {
+  if (ring->recording) return;
+  if (ring->in_flight_count == VULKAN_STAGING_BATCH_COUNT) {
+    retire_oldest_batch(context, ring, true);
+    ++ring->stats.stall_count;
+  }
+  vulkan_staging_batch *batch = current_batch(ring);
+  VK_CHECK(vkResetFences(context->device.logical_device, 1, &batch->fence));
+  vulkan_command_buffer_begin(&batch->command_buffer, true, false, false);
+  // Copies may overwrite ranges that frames submitted earlier are still reading
+  vkCmdPipelineBarrier(batch->command_buffer.handle,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       0,
+                       0,
+                       0,
+                       0,
+                       0,
+                       0);
+  ring->recording = true;
+}
+
+// Reserves `size` contiguous bytes, only waiting when the ring wraps onto in-flight uploads
+static b8 allocate(vulkan_context *context, vulkan_staging_ring *ring, u64 size, u64 *out_offset) {
+  if (size > ring->size) {
+    KERROR("vulkan_staging_ring :: upload of %llu bytes exceeds the ring size (%llu bytes)",
+           size,
+           ring->size);
+    return false;
+  }
+
+  for (;;) {
+    u64 offset = (ring->head + ring->alignment - 1) & ~(ring->alignment - 1);
+    // Never straddle the end of the buffer: skip to the start of the next lap
+    if (offset % ring->size + size > ring->size) offset = (offset / ring->size + 1) * ring->size;
+    if (offset + size - ring->tail <= ring->size) {
+      ring->head = offset + size;
+      *out_offset = offset % ring->size;
+      break;
+    }
+    if (ring->in_flight_count) {
+      retire_oldest_batch(context, ring, true);
+      ++ring->stats.stall_count;
+    }
+    else if (ring->recording) vulkan_staging_ring_flush(context, ring);
+    // Nothing references the ring anymore, only the padding was in the way
+    else ring->tail = ring->head = offset;
+  }
+
+  begin_batch(context, ring);
+  ++ring->stats.upload_count;
+  ring->stats.uploaded_bytes += size;
+  return true;
+}
+
+b8 vulkan_staging_ring_create(vulkan_context *context,
+                              u64 size,
+                              vulkan_staging_ring *out_ring) {
+  kzero_memory(out_ring, sizeof(vulkan_staging_ring));
+  if (!vulkan_buffer_create(context,
+                            size,
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            true,
+                            &out_ring->buffer)) {
+    KERROR("vulkan_staging_ring_create :: staging buffer creation failed");
+    return false;
+  }
+  // Persistently mapped for the lifetime of the ring
+  out_ring->mapped = vulkan_buffer_lock(context, &out_ring->buffer, 0, size, 0);
+  out_ring->buffer.is_locked = true;
+  out_ring->size = size;
+  u64 alignment = context->device.properties.limits.optimalBufferCopyOffsetAlignment;
+  out_ring->alignment = alignment > VULKAN_STAGING_MIN_ALIGNMENT ? alignment : VULKAN_STAGING_MIN_ALIGNMENT;
+
+  VkFenceCreateInfo fence_create_info = {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    .flags = VK_FENCE_CREATE_SIGNALED_BIT
+  };
+  for (u32 i = 0; i < VULKAN_STAGING_BATCH_COUNT; ++i) {
+    vulkan_command_buffer_allocate(context,
+                                   context->device.graphics_command_pool,
+                                   true,
+                                   &out_ring->batches[i].command_buffer);
+    VK_CHECK(vkCreateFence(context->device.logical_device,
+                           &fence_create_info,
+                           context->allocator,
+                           &out_ring->batches[i].fence));
+  }
+  KDEBUG("Vulkan staging ring created (%llu bytes)", size);
+  return true;
+}
+
+void vulkan_staging_ring_destroy(vulkan_context *context, vulkan_staging_ring *ring) {
+  if (!ring->buffer.handle) return;
+  vulkan_staging_ring_flush(context, ring);
+  while (ring->in_flight_count) retire_oldest_batch(context, ring, true);
+
+  for (u32 i = 0; i < VULKAN_STAGING_BATCH_COUNT; ++i) {
+    vulkan_command_buffer_free(context,
+                               context->device.graphics_command_pool,
+                               &ring->batches[i].command_buffer);
+    vkDestroyFence(context->device.logical_device, ring->batches[i].fence, context->allocator);
+  }
+  vulkan_buffer_unlock(context, &ring->buffer);
+  vulkan_buffer_destroy(context, &ring->buffer);
+  KDEBUG("Vulkan staging ring destroyed (%llu uploads, %llu bytes, %llu submits, %llu stalls)",
+         ring->stats.upload_count,
+         ring->stats.uploaded_bytes,
+         ring->stats.submit_count,
+         ring->stats.stall_count);
+  kzero_memory(ring, sizeof(vulkan_staging_ring));
+}
+
+b8 vulkan_staging_ring_upload_buffer(vulkan_context *context,
+                                     vulkan_staging_ring *ring,
+                                     vulkan_buffer *dst,
+                                     u64 dst_offset,
+                                     u64 size,
+                                     const void *data) {
+  if (!size) return true;
+  u64 offset;
+  if (!allocate(context, ring, size, &offset)) return false;
+  kcopy_memory(ring->mapped + offset, data, size);
+
+  VkBufferCopy copy_region = {
+    .srcOffset = offset,
+    .dstOffset = dst_offset,
+    .size = size
+  };
+  vkCmdCopyBuffer(current_batch(ring)->command_buffer.handle,
+                  ring->buffer.handle,
+                  dst->handle,
+                  1,
+                  &copy_region);
+  return true;
+}
+
+b8 vulkan_staging_ring_upload_image(vulkan_context *context,
+                                    vulkan_staging_ring *ring,
+                                    vulkan_image *image,
+                                    VkFormat format,
+                                    u64 size,
+                                    const void *pixels) {
+  u64 offset;
+  if (!allocate(context, ring, size, &offset)) return false;
+  kcopy_memory(ring->mapped + offset, pixels, size);
+
+  vulkan_command_buffer *command_buffer = &current_batch(ring)->command_buffer;
+  vulkan_image_transition_layout(context,
+                                 command_buffer,
+                                 image,
+                                 format,
+                                 VK_IMAGE_LAYOUT_UNDEFINED,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  vulkan_image_copy(context, image, ring->buffer.handle, offset, command_buffer);
+  if (image->mip_levels > 1) {
+    vulkan_image_generate_mipmaps(context, image, command_buffer);
+    return true;
+  }
+  vulkan_image_transition_layout(context,
+                                 command_buffer,
+                                 image,
+                                 format,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  return true;
+}
+
+u64 vulkan_staging_ring_copy_buffer(vulkan_context *context,
+                                    vulkan_staging_ring *ring,
+                                    vulkan_buffer *src,
+                                    u64 src_offset,
+                                    vulkan_buffer *dst,
+                                    u64 dst_offset,
+                                    u64 size) {
+  begin_batch(context, ring);
+  vulkan_command_buffer *command_buffer = &current_batch(ring)->command_buffer;
+  // The source may have been written earlier in this same batch
+  VkMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+  };
+  vkCmdPipelineBarrier(command_buffer->handle,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       1,
+                       &barrier,
+                       0,
+                       0,
+                       0,
+                       0);
+  VkBufferCopy copy_region = {
+    .srcOffset = src_offset,
+    .dstOffset = dst_offset,
+    .size = size
+  };
+  vkCmdCopyBuffer(command_buffer->handle, src->handle, dst->handle, 1, &copy_region);
+  // Serial the recording batch gets once flushed
+  return ring->stats.submit_count + 1;
+}
+
+b8 vulkan_staging_ring_is_complete(vulkan_context *context, vulkan_staging_ring *ring, u64 serial) {
+  if (serial <= ring->completed_serial) return true;
+  while (ring->in_flight_count && retire_oldest_batch(context, ring, false)) {}
+  return serial <= ring->completed_serial;
+}
+
+void vulkan_staging_ring_flush(vulkan_context *context, vulkan_staging_ring *ring) {
+  if (!ring->recording) return;
+  vulkan_staging_batch *batch = current_batch(ring);
+
+  // Later submissions on this queue (i.e. the frame) must see the copied vertex/index data
+  VkMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+  };
+  vkCmdPipelineBarrier(batch->command_buffer.handle,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       0,
+                       1,
+                       &barrier,
+                       0,
+                       0,
+                       0,
+                       0);
+  vulkan_command_buffer_end(&batch->command_buffer);
+
+  VkSubmitInfo submit_info = {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &batch->command_buffer.handle
+  };
+  VK_CHECK(vkQueueSubmit(context->device.graphics_queue, 1, &submit_info, batch->fence));
+  vulkan_command_buffer_update(&batch->command_buffer);
+  batch->end = ring->head;
+  ++ring->in_flight_count;
+  ring->recording = false;
+  ++ring->stats.submit_count;
+  batch->serial = ring->stats.submit_count;
+
+  // Reclaim whatever already finished without blocking
+  while (ring->in_flight_count && retire_oldest_batch(context, ring, false)) {}
+}
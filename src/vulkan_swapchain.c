@@ -24,8 +24,13 @@
 #include <vulkan_image.h>
 #include <vulkan_device.h>
 #include <vulkan_swapchain.h>
+#include <vulkan_deletion_queue.h>
 
-void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *swapchain) {
+void create(vulkan_context *context,
+            u32 width,
+            u32 height,
+            VkSwapchainKHR old_swapchain,
+            vulkan_swapchain *swapchain) {
   // Query swapchain support for the first time
   vulkan_device_query_swapchain_support(context->device.physical_device,
                                         context->surface,
@@ -72,14 +77,23 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
     Do not wait for a VBLANK period to update the current image.
     i.e. "VSync disabled".
   */
-  VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;  // FIFO by default
+  const VkPresentModeKHR present_modes[] = {
+    [RENDERER_PRESENT_MODE_FIFO]         = VK_PRESENT_MODE_FIFO_KHR,
+    [RENDERER_PRESENT_MODE_FIFO_RELAXED] = VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+    [RENDERER_PRESENT_MODE_MAILBOX]      = VK_PRESENT_MODE_MAILBOX_KHR,
+    [RENDERER_PRESENT_MODE_IMMEDIATE]    = VK_PRESENT_MODE_IMMEDIATE_KHR
+  };
+  VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;  // always supported
   for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; ++i) {
     VkPresentModeKHR mode = context->device.swapchain_support.present_modes[i];
-    if (mode == VK_PRESENT_MODE_IMMEDIATE_KHR) {  // IMMEDIATE if available
+    if (mode == present_modes[context->present_mode]) {
       present_mode = mode;
       break;
     }
   }
+  if (present_mode != present_modes[context->present_mode]) {
+    KWARN("Requested present mode is not supported by the surface (using FIFO)");
+  }
   // Re-query swapchain support
   vulkan_device_query_swapchain_support(context->device.physical_device,
                                         context->surface,
@@ -94,14 +108,19 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
   swapchain_extent.width = KCLAMP(swapchain_extent.width, min.width, max.width);
   swapchain_extent.height = KCLAMP(swapchain_extent.height, min.height, max.height);
 
-  // Get image count
-  u32 image_count = context->device.swapchain_support.capabilities.maxImageCount + 1;
+  // Get image count, images above the minimum let acquires avoid waiting on the presentation engine
+  u32 image_count = context->device.swapchain_support.capabilities.minImageCount + context->present_queue_depth;
   if (context->device.swapchain_support.capabilities.maxImageCount > 0 &&
       image_count > context->device.swapchain_support.capabilities.maxImageCount) {
     image_count = context->device.swapchain_support.capabilities.maxImageCount;
   }
-
-  swapchain->max_frames_in_flight = image_count - 1;  // double of triple buffering
+  // The presentation engine minimum still wins, per-image resources are sized from the returned count
+  u32 max_image_count = context->device.swapchain_support.capabilities.minImageCount > VULKAN_MAX_SWAPCHAIN_IMAGES ?
+    context->device.swapchain_support.capabilities.minImageCount : VULKAN_MAX_SWAPCHAIN_IMAGES;
+  if (image_count > max_image_count) {
+    KWARN("Swapchain image count %u reduced to %u", image_count, max_image_count);
+    image_count = max_image_count;
+  }
 
   // Swapchain create info
   VkSwapchainCreateInfoKHR swapchain_create_info = {
@@ -120,7 +139,7 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
     .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
     .presentMode = present_mode,
     .clipped = VK_TRUE,
-    .oldSwapchain = 0
+    .oldSwapchain = old_swapchain
   };
   if (context->device.graphics != context->device.present) {
     u32 queueFamilyIndices[] = {
@@ -138,8 +157,9 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
                                 context->allocator,
                                 &swapchain->handle));
 
+  swapchain->extent = swapchain_extent;
+
   // Images
-  context->current_frame = 0;
   swapchain->image_count = 0;
   VK_CHECK(vkGetSwapchainImagesKHR(context->device.logical_device,
                                    swapchain->handle,
@@ -149,6 +169,21 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
                                                                   MEMORY_TAG_RENDERER);
   if (!swapchain->views) swapchain->views = (VkImageView *) kallocate(sizeof(VkImageView) * swapchain->image_count,
                                                                     MEMORY_TAG_RENDERER);
+  if (image_count != swapchain->image_count) {
+    KDEBUG("Swapchain created with %u images (requested %u)", swapchain->image_count, image_count);
+  }
+  if (!swapchain->world_framebuffers) {
+    swapchain->world_framebuffers = (VkFramebuffer *) kallocate(sizeof(VkFramebuffer) * swapchain->image_count,
+                                                                MEMORY_TAG_RENDERER);
+  }
+  if (!swapchain->framebuffers) {
+    swapchain->framebuffers = (VkFramebuffer *) kallocate(sizeof(VkFramebuffer) * swapchain->image_count,
+                                                          MEMORY_TAG_RENDERER);
+  }
+  if (!swapchain->render_complete_semaphores) {
+    swapchain->render_complete_semaphores = (VkSemaphore *) kallocate(sizeof(VkSemaphore) * swapchain->image_count,
+                                                                      MEMORY_TAG_RENDERER);
+  }
   VK_CHECK(vkGetSwapchainImagesKHR(context->device.logical_device,
                                    swapchain->handle,
                                    &swapchain->image_count,
@@ -173,6 +208,15 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
                                &swapchain->views[i]));
   }
 
+  // Render complete semaphores
+  VkSemaphoreCreateInfo semaphore_create_info = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+  for (u32 i = 0; i < swapchain->image_count; ++i) {
+    VK_CHECK(vkCreateSemaphore(context->device.logical_device,
+                               &semaphore_create_info,
+                               context->allocator,
+                               &swapchain->render_complete_semaphores[i]));
+  }
+
   // Depth
   if (!vulkan_device_detect_depth_format(&context->device)) {
     context->device.depth_format = VK_FORMAT_UNDEFINED;
@@ -184,6 +228,7 @@ void create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *sw
                       VK_IMAGE_TYPE_2D,
                       swapchain_extent.width,
                       swapchain_extent.height,
+                      1,
                       context->device.depth_format,
                       VK_IMAGE_TILING_OPTIMAL,
                       VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
@@ -202,19 +247,49 @@ void destroy(vulkan_context *context, vulkan_swapchain *swapchain) {
     vkDestroyImageView(context->device.logical_device,
                        swapchain->views[i],
                        context->allocator);
+    vkDestroySemaphore(context->device.logical_device,
+                       swapchain->render_complete_semaphores[i],
+                       context->allocator);
   }
+  kfree(swapchain->render_complete_semaphores, sizeof(VkSemaphore) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  kfree(swapchain->world_framebuffers, sizeof(VkFramebuffer) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  kfree(swapchain->framebuffers, sizeof(VkFramebuffer) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  swapchain->render_complete_semaphores = 0;
+  swapchain->world_framebuffers = 0;
+  swapchain->framebuffers = 0;
   vkDestroySwapchainKHR(context->device.logical_device,
                         swapchain->handle,
                         context->allocator);
 }
 
 void vulkan_swapchain_create(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *swapchain) {
-  create(context, width, height, swapchain);
+  create(context, width, height, 0, swapchain);
 }
 
 void vulkan_swapchain_recreate(vulkan_context *context, u32 width, u32 height, vulkan_swapchain *swapchain) {
-  destroy(context, swapchain);
-  create(context, width, height, swapchain);
+  // Frames in flight may still render to or present the old images, they retire along with those frames
+  VkSwapchainKHR old_swapchain = swapchain->handle;
+  vulkan_deletion_queue_push_image(&context->deletion_queue, &swapchain->depth_attachment);
+  for (u32 i = 0; i < swapchain->image_count; ++i) {
+    vulkan_deletion_queue_push_image_view(&context->deletion_queue, swapchain->views[i]);
+    // Pending presents of the old images still wait on these
+    vulkan_deletion_queue_push_semaphore(&context->deletion_queue, swapchain->render_complete_semaphores[i]);
+  }
+  // The image count may change
+  kfree(swapchain->images, sizeof(VkImage) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  kfree(swapchain->views, sizeof(VkImageView) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  kfree(swapchain->render_complete_semaphores, sizeof(VkSemaphore) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  // Their framebuffers were already queued for deletion by the backend
+  kfree(swapchain->world_framebuffers, sizeof(VkFramebuffer) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  kfree(swapchain->framebuffers, sizeof(VkFramebuffer) * swapchain->image_count, MEMORY_TAG_RENDERER);
+  swapchain->images = 0;
+  swapchain->views = 0;
+  swapchain->render_complete_semaphores = 0;
+  swapchain->world_framebuffers = 0;
+  swapchain->framebuffers = 0;
+
+  create(context, width, height, old_swapchain, swapchain);
+  vulkan_deletion_queue_push_swapchain(&context->deletion_queue, old_swapchain);
 }
 
 void vulkan_swapchain_destroy(vulkan_context *context, vulkan_swapchain *swapchain) {
@@ -233,13 +308,7 @@ b8 vulkan_swapchain_get_next_image_index(vulkan_context *context,
                                           image_available_semaphore,
                                           fence,
                                           out_image_index);
-  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-    vulkan_swapchain_recreate(context,
-                              context->framebuffer_width,
-                              context->framebuffer_height,
-                              swapchain);
-    return false;
-  }
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) return false;
   else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
     KFATAL("Get swapchain image failed");
     return false;
@@ -247,12 +316,13 @@ b8 vulkan_swapchain_get_next_image_index(vulkan_context *context,
   return true;
 }
 
-void vulkan_swapchain_present(vulkan_context *context,
-                              vulkan_swapchain *swapchain,
-                              VkQueue graphics_queue,
-                              VkQueue present_queue,
-                              VkSemaphore render_complete_semaphore,
-                              u32 present_image_index) {
+b8 vulkan_swapchain_present(vulkan_context *context,
+                            vulkan_swapchain *swapchain,
+                            VkQueue graphics_queue,
+                            VkQueue present_queue,
+                            VkSemaphore render_complete_semaphore,
+                            u32 present_image_index) {
+  (void) context;         // Unused parameter
   (void) graphics_queue;  // Unused parameter
 
   VkPresentInfoKHR present_info = {
@@ -265,14 +335,8 @@ void vulkan_swapchain_present(vulkan_context *context,
     .pResults = 0
   };
   VkResult result = vkQueuePresentKHR(present_queue, &present_info);
-  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-    vulkan_swapchain_recreate(context,
-                              context->framebuffer_width,
-                              context->framebuffer_height,
-                              swapchain);
-  }
-  else if (result != VK_SUCCESS) KFATAL("Present swapchain image failed");
-
-  // Increment the current frame counter looping it through 'max_frames_in_flight' as limit
-  context->current_frame = (context->current_frame + 1) % swapchain->max_frames_in_flight;
+  if (result != VK_SUCCESS &&
+      result != VK_ERROR_OUT_OF_DATE_KHR &&
+      result != VK_SUBOPTIMAL_KHR) KFATAL("Present swapchain image failed");
+  return result == VK_SUCCESS;
 }
@@ -22,11 +22,13 @@
 #include <kmath.h>
 #include <logger.h>
 #include <kmemory.h>
-#include <vulkan_buffer.h>
 #include <texture_system.h>
 #include <vulkan_pipeline.h>
 #include <vulkan_ui_shader.h>
 #include <vulkan_shader_utils.h>
+#include <vulkan_uniform_ring.h>
+#include <vulkan_sampler_cache.h>
+#include <vulkan_deletion_queue.h>
 
 #define ATTRIBUTE_COUNT 2
 #define BUILTIN_UI_SHADER_NAME_OBJECT "builtin.ui"
@@ -54,7 +56,7 @@ b8 vulkan_ui_shader_create(vulkan_context *context, vulkan_ui_shader *out_shader
   VkDescriptorSetLayoutBinding global_ubo_layout_binding = {
     .binding = 0,
     .descriptorCount = 1,
-    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
     .pImmutableSamplers = 0,
     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT
   };
@@ -69,26 +71,35 @@ b8 vulkan_ui_shader_create(vulkan_context *context, vulkan_ui_shader *out_shader
                                        &out_shader->global_descriptor_set_layout));
   // Global descriptor pool
   VkDescriptorPoolSize global_pool_size = {
-    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .descriptorCount = context->swapchain.image_count
+    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    .descriptorCount = FRAME_DESCRIPTOR_COUNT
   };
   VkDescriptorPoolCreateInfo global_pool_info = {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
     .poolSizeCount = 1,
     .pPoolSizes = &global_pool_size,
-    .maxSets = context->swapchain.image_count
+    .maxSets = FRAME_DESCRIPTOR_COUNT
   };
   VK_CHECK(vkCreateDescriptorPool(context->device.logical_device,
                                   &global_pool_info,
                                   context->allocator,
                                   &out_shader->global_descriptor_pool));
 
+  // Material slots
+  u64 material_pool_requirements = 0;
+  handle_pool_create(UI_SHADER_MAX_COUNT, &material_pool_requirements, 0, 0);
+  out_shader->material_pool_block = kallocate(material_pool_requirements, MEMORY_TAG_RENDERER);
+  handle_pool_create(UI_SHADER_MAX_COUNT,
+                     &material_pool_requirements,
+                     out_shader->material_pool_block,
+                     &out_shader->material_pool);
+
   // Sampler uses
   out_shader->sampler_uses[0] = TEXTURE_USE_MAP_DIFFUSE;
 
   // Local (object) descriptors
   VkDescriptorType descriptor_types[] = {
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         // Binding 0: uniform buffer
+    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, // Binding 0: uniform buffer
     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER  // Binding 1: diffuse sampler layout
   };
   VkDescriptorSetLayoutBinding bindings[UI_SHADER_OBJECT_DESCRIPTOR_COUNT];
@@ -114,7 +125,7 @@ b8 vulkan_ui_shader_create(vulkan_context *context, vulkan_ui_shader *out_shader
   // Local (object) descriptor pool
   VkDescriptorPoolSize object_pool_sizes[] = {
     {
-      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
       .descriptorCount = UI_SHADER_MAX_COUNT
     },
     {
@@ -196,19 +207,19 @@ b8 vulkan_ui_shader_create(vulkan_context *context, vulkan_ui_shader *out_shader
                                        scissor,
                                        false,
                                        false,
+                                       true,
                                        &out_shader->pipeline)) {
     KERROR("vulkan_ui_shader_create :: failed to create graphics pipeline");
     return false;
   }
 
-  // Create uniform buffer
-  if (!vulkan_buffer_create(context,
-                            sizeof(vulkan_ui_shader_global_ubo),
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                            true,
-                            &out_shader->global_uniform_buffer)) {
-    KERROR("vulkan_ui_shader_create :: failed to create object shader's buffer");
+  // Create uniform ring (the global UBO plus room for every instance UBO twice, see `update`)
+  if (!vulkan_uniform_ring_create(context,
+                                  sizeof(vulkan_ui_shader_global_ubo),
+                                  sizeof(vulkan_ui_shader_instance_ubo),
+                                  UI_SHADER_MAX_COUNT * 2,
+                                  &out_shader->uniform_ring)) {
+    KERROR("vulkan_ui_shader_create :: failed to create the uniform ring");
     return false;
   }
 
@@ -226,21 +237,39 @@ b8 vulkan_ui_shader_create(vulkan_context *context, vulkan_ui_shader *out_shader
                                     &alloc_info,
                                     out_shader->global_descriptor_sets));
 
-  // Create object uniform buffer
-  if (!vulkan_buffer_create(context,
-                            sizeof(vulkan_ui_shader_instance_ubo) * UI_SHADER_MAX_COUNT,
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                            true,
-                            &out_shader->object_uniform_buffer)) {
-    KERROR("vulkan_ui_shader_create :: Failed material instance buffer creation");
-    return false;
+  // Global descriptors always point at the reserved slot, the region is picked with the dynamic offset
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
+    VkDescriptorBufferInfo buffer_info = {
+      .buffer = out_shader->uniform_ring.buffer.handle,
+      .offset = 0,
+      .range = sizeof(vulkan_ui_shader_global_ubo)
+    };
+    VkWriteDescriptorSet descriptor_write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = out_shader->global_descriptor_sets[i],
+      .dstBinding = 0,
+      .dstArrayElement = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .pBufferInfo = &buffer_info
+    };
+    vkUpdateDescriptorSets(context->device.logical_device,
+                           1,
+                           &descriptor_write,
+                           0,
+                           0);
   }
 
   return true;
 }
 
 void vulkan_ui_shader_destroy(vulkan_context *context, vulkan_ui_shader *shader) {
+  u64 material_pool_requirements = 0;
+  handle_pool_create(UI_SHADER_MAX_COUNT, &material_pool_requirements, 0, 0);
+  handle_pool_destroy(&shader->material_pool);
+  kfree(shader->material_pool_block, material_pool_requirements, MEMORY_TAG_RENDERER);
+  shader->material_pool_block = 0;
+
   vkDestroyDescriptorPool(context->device.logical_device,
                           shader->object_descriptor_pool,
                           context->allocator);
@@ -248,9 +277,8 @@ void vulkan_ui_shader_destroy(vulkan_context *context, vulkan_ui_shader *shader)
                                shader->object_descriptor_set_layout,
                                context->allocator);
 
-  // Destroy uniform buffers
-  vulkan_buffer_destroy(context, &shader->global_uniform_buffer);
-  vulkan_buffer_destroy(context, &shader->object_uniform_buffer);
+  // Destroy uniform ring
+  vulkan_uniform_ring_destroy(context, &shader->uniform_ring);
 
   // Destroy pipeline
   vulkan_pipeline_destroy(context, &shader->pipeline);
@@ -275,8 +303,8 @@ void vulkan_ui_shader_destroy(vulkan_context *context, vulkan_ui_shader *shader)
 }
 
 void vulkan_ui_shader_use(vulkan_context *context, vulkan_ui_shader *shader) {
-  u32 img_idx = context->image_index;
-  vulkan_pipeline_bind(&context->graphics_command_buffers[img_idx],
+  u32 frame_idx = context->current_frame;
+  vulkan_pipeline_bind(&context->frames[frame_idx].command_buffer,
                        VK_PIPELINE_BIND_POINT_GRAPHICS,
                        &shader->pipeline);
 }
@@ -286,45 +314,35 @@ void vulkan_ui_shader_update(vulkan_context *context,
                              f32 delta_time) {
   (void) delta_time;  // Unused parameter
 
-  u32 image_idx = context->image_index;
-  VkDescriptorSet global_descriptor = shader->global_descriptor_sets[image_idx];
+  u32 frame_idx = context->current_frame;
+  VkCommandBuffer command_buffer = context->frames[frame_idx].command_buffer.handle;
+  VkDescriptorSet global_descriptor = shader->global_descriptor_sets[frame_idx];
+  vulkan_uniform_ring *ring = &shader->uniform_ring;
 
-  u32 range = sizeof(vulkan_ui_shader_global_ubo);
-  u64 offset = 0;
-  // Copy data to buffer
-  vulkan_buffer_load(context,
-                     &shader->global_uniform_buffer,
-                     offset,
-                     range,
-                     0,
-                     &shader->global_ubo);
-  VkDescriptorBufferInfo buffer_info = {
-    .buffer = shader->global_uniform_buffer.handle,
-    .offset = offset,
-    .range = range
-  };
-  // Update descriptor sets
-  VkWriteDescriptorSet descriptor_write = {
-    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    .dstSet = global_descriptor,
-    .dstBinding = 0,
-    .dstArrayElement = 0,
-    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .descriptorCount = 1,
-    .pBufferInfo = &buffer_info
-  };
-  vkUpdateDescriptorSets(context->device.logical_device,
-                         1,
-                         &descriptor_write,
-                         0,
-                         0);
+  // With room for every instance UBO left, a frame can never run out of space mid-recording
+  u64 instance_size = vulkan_uniform_ring_align(ring, sizeof(vulkan_ui_shader_instance_ubo));
+  vulkan_uniform_ring_begin_region(ring, frame_idx, instance_size * UI_SHADER_MAX_COUNT);
+
+  // Copy data to the region's reserved slot
+  u32 offset = vulkan_uniform_ring_region_offset(ring, frame_idx);
+  vulkan_uniform_ring_write(ring, offset, &shader->global_ubo, sizeof(vulkan_ui_shader_global_ubo));
+
+  // Bind the descriptor set (global) to be updated
+  vkCmdBindDescriptorSets(command_buffer,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          shader->pipeline.pipeline_layout,
+                          0,
+                          1,
+                          &global_descriptor,
+                          1,
+                          &offset);
 }
 
 void vulkan_ui_shader_set_model(vulkan_context *context,
                                 vulkan_ui_shader *shader,
                                 Matrix4 model) {
   if (!context || !shader) return;
-  vkCmdPushConstants(context->graphics_command_buffers[context->image_index].handle,
+  vkCmdPushConstants(context->frames[context->current_frame].command_buffer.handle,
                      shader->pipeline.pipeline_layout,
                      VK_SHADER_STAGE_VERTEX_BIT,
                      0,
@@ -337,52 +355,32 @@ void vulkan_ui_shader_apply_material(vulkan_context *context,
                                      material *material) {
   if (!context || !shader) return;
 
-  u32 image_idx = context->image_index;
-  VkCommandBuffer command_buffer = context->graphics_command_buffers[image_idx].handle;
+  u32 frame_idx = context->current_frame;
+  VkCommandBuffer command_buffer = context->frames[frame_idx].command_buffer.handle;
 
   // Get material data
   vulkan_ui_shader_instance_state *object_state = &shader->instance_states[material->internal_id];
-  VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[image_idx];
+  VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[frame_idx];
 
   VkWriteDescriptorSet descriptor_writes[UI_SHADER_OBJECT_DESCRIPTOR_COUNT];
   kzero_memory(descriptor_writes, sizeof(VkWriteDescriptorSet) * UI_SHADER_OBJECT_DESCRIPTOR_COUNT);
 
   u32 descriptor_count = 0, descriptor_idx = 0;
 
-  // Descriptor 0: uniform buffer
-  u32 range = sizeof(vulkan_ui_shader_instance_ubo);
-  u64 offset = sizeof(vulkan_ui_shader_instance_ubo) * material->internal_id;
-  vulkan_ui_shader_instance_ubo instance_ubo;
-
-  // Set instance UBO diffuse color from the material
-  instance_ubo.diffuse_color = material->diffuse_color;
-
-  vulkan_buffer_load(context,
-                     &shader->object_uniform_buffer,
-                     offset,
-                     range,
-                     0,
-                     &instance_ubo);
-
-  // If the descriptor has not been updated yet
-  u32 *global_ubo_generation = &object_state->descriptor_states[descriptor_idx].generations[image_idx];
-  if (*global_ubo_generation == INVALID_ID ||
-      *global_ubo_generation != material->generation) {
-    VkDescriptorBufferInfo buffer_info = {
-      .buffer = shader->object_uniform_buffer.handle,
-      .offset = offset,
-      .range = range
-    };
-    descriptor_writes[descriptor_count] = (VkWriteDescriptorSet) {
-      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      .dstSet = object_descriptor_set,
-      .dstBinding = descriptor_idx,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      .descriptorCount = 1,
-      .pBufferInfo = &buffer_info
-    };
-    ++descriptor_count;
-    *global_ubo_generation = material->generation;
+  // Descriptor 0: uniform buffer (written once in `get_resources`, only the data moves)
+  vulkan_ui_shader_instance_ubo instance_ubo = {
+    .diffuse_color = material->diffuse_color
+  };
+  u32 offset = 0;
+  if (!vulkan_uniform_cache_write(&shader->uniform_ring,
+                                  &object_state->ubo_cache,
+                                  context->current_frame,
+                                  material->generation,
+                                  &instance_ubo,
+                                  sizeof(vulkan_ui_shader_instance_ubo),
+                                  &offset)) {
+    KERROR("vulkan_ui_shader_apply_material :: failed to write the instance UBO");
+    return;
   }
   ++descriptor_idx;
 
@@ -400,8 +398,8 @@ void vulkan_ui_shader_apply_material(vulkan_context *context,
       KFATAL("vulkan_ui_shader_apply_material :: unable to bind sampler to unknown `texture_use`");
       return;
     }
-    u32 *descriptor_gen = &object_state->descriptor_states[descriptor_idx].generations[image_idx];
-    u32 *descriptor_id = &object_state->descriptor_states[descriptor_idx].ids[image_idx];
+    u32 *descriptor_gen = &object_state->descriptor_states[descriptor_idx].generations[frame_idx];
+    u32 *descriptor_id = &object_state->descriptor_states[descriptor_idx].ids[frame_idx];
 
     // If no texture is loaded, use the fallback one
     if (!t || t->generation == INVALID_ID) {
@@ -418,7 +416,7 @@ void vulkan_ui_shader_apply_material(vulkan_context *context,
       image_infos[i] = (VkDescriptorImageInfo) {
         .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         .imageView = internal_data->image.view,
-        .sampler = internal_data->sampler
+        .sampler = vulkan_sampler_cache_get(&context->sampler_cache, internal_data->sampler)
       };
       descriptor_writes[descriptor_count] = (VkWriteDescriptorSet) {
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -448,15 +446,19 @@ void vulkan_ui_shader_apply_material(vulkan_context *context,
                           1,
                           1,
                           &object_descriptor_set,
-                          0,
-                          0);
+                          1,
+                          &offset);
 }
 
 b8 vulkan_ui_shader_get_resources(vulkan_context *context,
                                   vulkan_ui_shader *shader,
                                   material *material) {
-  material->internal_id = shader->object_uniform_buffer_index;
-  ++shader->object_uniform_buffer_index;
+  khandle handle;
+  if (!handle_pool_acquire(&shader->material_pool, &handle)) {
+    KERROR("vulkan_ui_shader_get_resources :: material limit reached (%u)", UI_SHADER_MAX_COUNT);
+    return false;
+  }
+  material->internal_id = handle.index;
 
   vulkan_ui_shader_instance_state *instance_state = &shader->instance_states[material->internal_id];
   for (u32 i = 0; i < UI_SHADER_OBJECT_DESCRIPTOR_COUNT; ++i) {
@@ -482,8 +484,34 @@ b8 vulkan_ui_shader_get_resources(vulkan_context *context,
                                              instance_state->descriptor_sets);
   if (result != VK_SUCCESS) {
     KERROR("vulkan_ui_shader_get_resources :: Failed descriptor sets allocation");
+    handle_pool_release(&shader->material_pool, handle);
+    material->internal_id = INVALID_ID;
     return false;
   }
+
+  // The instance UBO descriptor never changes, `apply_material` only moves its dynamic offset
+  VkDescriptorBufferInfo buffer_info = {
+    .buffer = shader->uniform_ring.buffer.handle,
+    .offset = 0,
+    .range = sizeof(vulkan_ui_shader_instance_ubo)
+  };
+  VkWriteDescriptorSet descriptor_writes[FRAME_DESCRIPTOR_COUNT];
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
+    descriptor_writes[i] = (VkWriteDescriptorSet) {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = instance_state->descriptor_sets[i],
+      .dstBinding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = 1,
+      .pBufferInfo = &buffer_info
+    };
+  }
+  vkUpdateDescriptorSets(context->device.logical_device,
+                         FRAME_DESCRIPTOR_COUNT,
+                         descriptor_writes,
+                         0,
+                         0);
+  vulkan_uniform_cache_reset(&instance_state->ubo_cache);
   return true;
 }
 
@@ -492,16 +520,11 @@ void vulkan_ui_shader_release_resources(vulkan_context *context,
                                         material *material) {
   vulkan_ui_shader_instance_state *instance_state = &shader->instance_states[material->internal_id];
 
-  // Wait for any pending ops using the DescriptorSet to finish
-  vkDeviceWaitIdle(context->device.logical_device);
-
-  VkResult result = vkFreeDescriptorSets(context->device.logical_device,
-                                         shader->object_descriptor_pool,
-                                         FRAME_DESCRIPTOR_COUNT,
-                                         instance_state->descriptor_sets);
-  if (result != VK_SUCCESS) {
-    KERROR("vulkan_ui_shader_release_resources :: Failed descriptor sets free");
-  }
+  // Frames in flight may still bind the descriptor sets
+  vulkan_deletion_queue_push_descriptor_sets(&context->deletion_queue,
+                                             shader->object_descriptor_pool,
+                                             FRAME_DESCRIPTOR_COUNT,
+                                             instance_state->descriptor_sets);
 
   for (u32 i = 0; i < UI_SHADER_OBJECT_DESCRIPTOR_COUNT; ++i) {
     for (u32 j = 0; j < FRAME_DESCRIPTOR_COUNT; ++j) {
@@ -510,5 +533,9 @@ void vulkan_ui_shader_release_resources(vulkan_context *context,
     }
   }
 
+  // The slot's instance state must not be reused while a frame in flight may still draw with it
+  vulkan_deletion_queue_push_handle(&context->deletion_queue,
+                                    &shader->material_pool,
+                                    handle_pool_from_index(&shader->material_pool, material->internal_id));
   material->internal_id = INVALID_ID;
 }
@@ -0,0 +1,115 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <logger.h>
+#include <kmemory.h>
+#include <vulkan_buffer.h>
+#include <vulkan_uniform_ring.h>
+
+b8 vulkan_uniform_ring_create(vulkan_context *context,
+                              u64 reserved_size,
+                              u64 entry_size,
+                              u32 entry_count,
+                              vulkan_uniform_ring *out_ring) {
+  kzero_memory(out_ring, sizeof(vulkan_uniform_ring));
+  out_ring->alignment = context->device.properties.limits.minUniformBufferOffsetAlignment;
+  if (!out_ring->alignment) out_ring->alignment = 1;
+  out_ring->reserved_size = vulkan_uniform_ring_align(out_ring, reserved_size);
+  // Pushes are aligned one by one
+  out_ring->region_size = out_ring->reserved_size + vulkan_uniform_ring_align(out_ring, entry_size) * entry_count;
+
+  u32 device_local_bits = context->device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
+  if (!vulkan_buffer_create(context,
+                            out_ring->region_size * FRAME_DESCRIPTOR_COUNT,
+                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits,
+                            true,
+                            &out_ring->buffer)) {
+    KERROR("vulkan_uniform_ring_create :: failed to create the uniform buffer");
+    return false;
+  }
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) out_ring->heads[i] = out_ring->reserved_size;
+  return true;
+}
+
+void vulkan_uniform_ring_destroy(vulkan_context *context, vulkan_uniform_ring *ring) {
+  vulkan_buffer_destroy(context, &ring->buffer);
+  kzero_memory(ring, sizeof(vulkan_uniform_ring));
+}
+
+u64 vulkan_uniform_ring_align(vulkan_uniform_ring *ring, u64 size) {
+  return ((size + ring->alignment - 1) / ring->alignment) * ring->alignment;
+}
+
+u32 vulkan_uniform_ring_region_offset(vulkan_uniform_ring *ring, u32 region) {
+  return (u32) (ring->region_size * region);
+}
+
+void vulkan_uniform_ring_begin_region(vulkan_uniform_ring *ring, u32 region, u64 min_free) {
+  // The region's previous frame has already been waited on, so its data can be overwritten
+  if (ring->region_size - ring->heads[region] >= min_free) return;
+  ring->heads[region] = ring->reserved_size;
+  ++ring->epochs[region];
+}
+
+void vulkan_uniform_ring_write(vulkan_uniform_ring *ring, u32 offset, const void *data, u64 size) {
+  kcopy_memory(ring->buffer.allocation.mapped + offset, data, size);
+}
+
+b8 vulkan_uniform_ring_push(vulkan_uniform_ring *ring,
+                            u32 region,
+                            const void *data,
+                            u64 size,
+                            u32 *out_offset) {
+  u64 aligned_size = vulkan_uniform_ring_align(ring, size);
+  if (ring->heads[region] + aligned_size > ring->region_size) {
+    KERROR("vulkan_uniform_ring_push :: region %u is full", region);
+    return false;
+  }
+  *out_offset = vulkan_uniform_ring_region_offset(ring, region) + (u32) ring->heads[region];
+  ring->heads[region] += aligned_size;
+  vulkan_uniform_ring_write(ring, *out_offset, data, size);
+  return true;
+}
+
+void vulkan_uniform_cache_reset(vulkan_uniform_cache *cache) {
+  for (u32 i = 0; i < FRAME_DESCRIPTOR_COUNT; ++i) {
+    cache->offsets[i] = 0;
+    cache->generations[i] = INVALID_ID;
+    cache->epochs[i] = INVALID_ID;
+  }
+}
+
+b8 vulkan_uniform_cache_write(vulkan_uniform_ring *ring,
+                              vulkan_uniform_cache *cache,
+                              u32 region,
+                              u32 generation,
+                              const void *data,
+                              u64 size,
+                              u32 *out_offset) {
+  if (cache->epochs[region] != ring->epochs[region] || cache->generations[region] != generation) {
+    if (!vulkan_uniform_ring_push(ring, region, data, size, &cache->offsets[region])) return false;
+    cache->generations[region] = generation;
+    cache->epochs[region] = ring->epochs[region];
+  }
+  *out_offset = cache->offsets[region];
+  return true;
+}
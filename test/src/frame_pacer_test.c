@@ -0,0 +1,79 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <expect.h>
+#include <platform.h>
+#include <frame_pacer.h>
+#include <test_manager.h>
+#include <frame_pacer_test.h>
+
+u8 frame_pacer_test_fixed_steps(void) {
+  frame_pacer pacer;
+  frame_pacer_create(0, 50, &pacer);
+
+  should_be(0, frame_pacer_accumulate(&pacer, 0.01));
+  float_should_be(0.5f, frame_pacer_interpolation(&pacer));
+  should_be(1, frame_pacer_accumulate(&pacer, 0.015));
+  float_should_be(0.25f, frame_pacer_interpolation(&pacer));
+  should_be(3, frame_pacer_accumulate(&pacer, 0.06));
+  float_should_be(0.25f, frame_pacer_interpolation(&pacer));
+  return true;
+}
+
+u8 frame_pacer_test_stall(void) {
+  frame_pacer pacer;
+  frame_pacer_create(0, 100, &pacer);
+
+  // A long stall runs a bounded number of steps and drops the rest
+  should_be(FRAME_PACER_MAX_STEPS, frame_pacer_accumulate(&pacer, 5.0));
+  float_should_be(0, frame_pacer_interpolation(&pacer));
+  should_be(1, frame_pacer_accumulate(&pacer, 0.01));
+  return true;
+}
+
+u8 frame_pacer_test_wait(void) {
+  frame_pacer pacer;
+  frame_pacer_create(100, 100, &pacer);
+
+  // The first wait only sets the deadline
+  frame_pacer_wait(&pacer);
+  f64 start = platform_get_absolute_time();
+  for (u32 i = 0; i < 5; ++i) {
+    frame_pacer_wait(&pacer);
+    should_be_true((platform_get_absolute_time() >= pacer.deadline));
+  }
+  f64 elapsed = platform_get_absolute_time() - start;
+  should_be_true((elapsed >= 0.05 - 0.001));
+  should_be_true((elapsed < 0.1));
+
+  // Unlimited pacers return right away
+  frame_pacer_set_target_rate(&pacer, 0);
+  start = platform_get_absolute_time();
+  frame_pacer_wait(&pacer);
+  should_be_true((platform_get_absolute_time() - start < 0.005));
+  return true;
+}
+
+void frame_pacer_test_register(void) {
+  REGISTER_TEST(frame_pacer_test_fixed_steps);
+  REGISTER_TEST(frame_pacer_test_stall);
+  REGISTER_TEST(frame_pacer_test_wait);
+}
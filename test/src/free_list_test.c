@@ -186,10 +186,113 @@ u8 free_list_test_alloc_full_and_fail_to_alloc_more(void) {
   return true;
 }
 
+u8 free_list_test_free_after_full_and_double_free(void) {
+  free_list fl;
+
+  u64 memory_requirements = 0;
+  u64 total_size = 512;
+  free_list_create(total_size, &memory_requirements, 0, 0);
+
+  void *block = kallocate(memory_requirements, MEMORY_TAG_APPLICATION);
+  free_list_create(total_size, &memory_requirements, block, &fl);
+
+  u32 offset1 = INVALID_ID, offset2 = INVALID_ID;
+  should_be_true(free_list_alloc(&fl, 256, &offset1));
+  should_be_true(free_list_alloc(&fl, 256, &offset2));
+  should_be(0, free_list_get_free_space(&fl));
+
+  // Freeing past the last free node (or into an empty list) must work
+  should_be_true(free_list_free(&fl, 256, offset2));
+  should_be(256, free_list_get_free_space(&fl));
+  should_be_false(free_list_free(&fl, 256, offset2));
+  should_be_false(free_list_free(&fl, 64, offset2 + 64));
+  should_be_false(free_list_free(&fl, 64, total_size));
+  should_be_true(free_list_free(&fl, 256, offset1));
+  should_be(total_size, free_list_get_free_space(&fl));
+
+  // Everything merged back into a single block
+  should_be_true(free_list_alloc(&fl, total_size, &offset1));
+  should_be(0, offset1);
+
+  free_list_destroy(&fl);
+  kfree(block, memory_requirements, MEMORY_TAG_APPLICATION);
+
+  return true;
+}
+
+u8 free_list_test_resize(void) {
+  free_list fl;
+
+  u64 memory_requirements = 0;
+  u64 total_size = 512;
+  free_list_create_with_max_entries(total_size, 8, &memory_requirements, 0, 0);
+
+  void *block = kallocate(memory_requirements, MEMORY_TAG_APPLICATION);
+  free_list_create_with_max_entries(total_size, 8, &memory_requirements, block, &fl);
+
+  u32 offset1 = INVALID_ID, offset2 = INVALID_ID;
+  should_be_true(free_list_alloc(&fl, 448, &offset1));
+  should_be_false(free_list_alloc(&fl, 128, &offset2));
+
+  // Tail is merged with the trailing free block
+  should_be_true(free_list_resize(&fl, total_size * 2));
+  should_be(total_size * 2 - 448, free_list_get_free_space(&fl));
+  should_be_true(free_list_alloc(&fl, 128, &offset2));
+  should_be(448, offset2);
+  should_be_false(free_list_resize(&fl, total_size));
+
+  // Tail after a used block gets its own node
+  should_be_true(free_list_alloc(&fl, total_size * 2 - 576, &offset1));
+  should_be(0, free_list_get_free_space(&fl));
+  should_be_true(free_list_resize(&fl, total_size * 3));
+  should_be(total_size, free_list_get_free_space(&fl));
+  should_be_true(free_list_alloc(&fl, total_size, &offset1));
+  should_be(total_size * 2, offset1);
+
+  free_list_destroy(&fl);
+  kfree(block, memory_requirements, MEMORY_TAG_APPLICATION);
+
+  return true;
+}
+
+u8 free_list_test_alloc_below(void) {
+  free_list fl;
+
+  u64 memory_requirements = 0;
+  u64 total_size = 512;
+  free_list_create(total_size, &memory_requirements, 0, 0);
+
+  void *block = kallocate(memory_requirements, MEMORY_TAG_APPLICATION);
+  free_list_create(total_size, &memory_requirements, block, &fl);
+
+  u32 offset1 = INVALID_ID, offset2 = INVALID_ID, offset3 = INVALID_ID;
+  should_be_true(free_list_alloc(&fl, 64, &offset1));
+  should_be_true(free_list_alloc(&fl, 64, &offset2));
+  should_be_true(free_list_alloc(&fl, 64, &offset3));
+  should_be_true(free_list_free(&fl, 64, offset1));
+
+  // Only the hole at 0 starts below 64, and it is too small for 128 bytes
+  u32 offset = INVALID_ID;
+  should_be_false(free_list_alloc_below(&fl, 128, offset2, &offset));
+  should_be(INVALID_ID, offset);
+  should_be_true(free_list_alloc_below(&fl, 64, offset3, &offset));
+  should_be(0, offset);
+  should_be_false(free_list_alloc_below(&fl, 64, offset3, &offset));
+  should_be(total_size - 192, free_list_get_free_space(&fl));
+
+  free_list_destroy(&fl);
+  kfree(block, memory_requirements, MEMORY_TAG_APPLICATION);
+
+  return true;
+}
+
 void free_list_test_register(void) {
   REGISTER_TEST(free_list_test_create_destroy);
   REGISTER_TEST(free_list_test_alloc_free);
   REGISTER_TEST(free_list_test_alloc_free_multi);
   REGISTER_TEST(free_list_test_alloc_free_multi_diff_sizes);
   REGISTER_TEST(free_list_test_alloc_full_and_fail_to_alloc_more);
+  REGISTER_TEST(free_list_test_free_after_full_and_double_free);
+  REGISTER_TEST(free_list_test_resize);
+  REGISTER_TEST(free_list_test_alloc_below);
 }
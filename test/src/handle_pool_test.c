@@ -0,0 +1,103 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <expect.h>
+#include <kmemory.h>
+#include <handle_pool.h>
+#include <test_manager.h>
+#include <handle_pool_test.h>
+
+u8 handle_pool_test_acquire_release(void) {
+  const u32 capacity = 4;
+  handle_pool pool;
+  u64 memory_requirements = 0;
+  handle_pool_create(capacity, &memory_requirements, 0, 0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_ARRAY);
+  handle_pool_create(capacity, &memory_requirements, memory, &pool);
+
+  khandle handles[capacity];
+  for (u32 i = 0; i < capacity; ++i) {
+    should_be_true(handle_pool_acquire(&pool, &handles[i]));
+    should_be(i, handles[i].index);
+    should_be_true(handle_pool_is_valid(&pool, handles[i]));
+  }
+  should_be(capacity, pool.count);
+
+  // Full pool
+  khandle extra;
+  should_be_false(handle_pool_acquire(&pool, &extra));
+  should_be_true(khandle_is_invalid(extra));
+
+  // Released slots are reused first (LIFO)
+  should_be_true(handle_pool_release(&pool, handles[1]));
+  should_be_true(handle_pool_release(&pool, handles[2]));
+  should_be(capacity - 2, pool.count);
+  should_be_true(handle_pool_acquire(&pool, &extra));
+  should_be(handles[2].index, extra.index);
+
+  kfree(memory, memory_requirements, MEMORY_TAG_ARRAY);
+  return true;
+}
+
+u8 handle_pool_test_stale_handles(void) {
+  const u32 capacity = 8;
+  handle_pool pool;
+  u64 memory_requirements = 0;
+  handle_pool_create(capacity, &memory_requirements, 0, 0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_ARRAY);
+  handle_pool_create(capacity, &memory_requirements, memory, &pool);
+
+  khandle old;
+  handle_pool_acquire(&pool, &old);
+  should_be_true(handle_pool_release(&pool, old));
+  should_be_false(handle_pool_is_valid(&pool, old));
+  // Double release is rejected
+  should_be_false(handle_pool_release(&pool, old));
+
+  khandle reused;
+  handle_pool_acquire(&pool, &reused);
+  should_be(old.index, reused.index);
+  should_not_be(old.generation, reused.generation);
+  should_be_false(handle_pool_is_valid(&pool, old));
+  should_be_false(handle_pool_release(&pool, old));
+  should_be_true(handle_pool_is_valid(&pool, reused));
+
+  // Never acquired and out of range slots
+  should_be_false(handle_pool_is_valid(&pool, ((khandle) { .index = 5, .generation = 0 })));
+  should_be_false(handle_pool_is_valid(&pool, ((khandle) { .index = capacity, .generation = 0 })));
+  should_be_false(handle_pool_is_valid(&pool, KHANDLE_INVALID));
+
+  khandle from_index = handle_pool_from_index(&pool, reused.index);
+  should_be(reused.generation, from_index.generation);
+  should_be_true(khandle_is_invalid(handle_pool_from_index(&pool, 5)));
+
+  // Clearing invalidates every live handle
+  handle_pool_clear(&pool);
+  should_be(0, pool.count);
+  should_be_false(handle_pool_is_valid(&pool, reused));
+
+  kfree(memory, memory_requirements, MEMORY_TAG_ARRAY);
+  return true;
+}
+
+void handle_pool_test_register(void) {
+  REGISTER_TEST(handle_pool_test_acquire_release);
+  REGISTER_TEST(handle_pool_test_stale_handles);
+}
@@ -21,6 +21,8 @@
 
 #include <expect.h>
 #include <defines.h>
+#include <kmemory.h>
+#include <kstring.h>
 #include <hash_table.h>
 #include <test_manager.h>
 #include <hash_table_test.h>
@@ -35,10 +37,18 @@ u8 hash_table_test_create_destroy(void) {
   hash_table table;
   u64 element_size = sizeof(u64);
   u64 element_count = 3;
-  u64 memory[element_count];
 
+  u64 memory_requirements = 0;
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
                     memory,
                     false,
                     &table);
@@ -50,6 +60,7 @@ u8 hash_table_test_create_destroy(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -58,10 +69,18 @@ u8 hash_table_test_set_get(void) {
   hash_table table;
   u64 element_size = sizeof(u64);
   u64 element_count = 3;
-  u64 memory[element_count];
 
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
                     memory,
                     false,
                     &table);
@@ -79,6 +98,7 @@ u8 hash_table_test_set_get(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -87,10 +107,18 @@ u8 hash_table_test_set_get_ptr(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct *);
   u64 element_count = 3;
-  hash_table_test_struct *memory[element_count];
 
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    true,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
                     memory,
                     true,
                     &table);
@@ -115,6 +143,7 @@ u8 hash_table_test_set_get_ptr(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -123,10 +152,18 @@ u8 hash_table_test_set_get_nonexistant(void) {
   hash_table table;
   u64 element_size = sizeof(u64);
   u64 element_count = 3;
-  u64 memory[element_count];
 
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
                     memory,
                     false,
                     &table);
@@ -145,6 +182,7 @@ u8 hash_table_test_set_get_nonexistant(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -153,10 +191,18 @@ u8 hash_table_test_set_get_ptr_nonexistant(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct *);
   u64 element_count = 3;
-  hash_table_test_struct *memory[element_count];
 
+  u64 memory_requirements = 0;
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
+                    0,
+                    true,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
                     memory,
                     true,
                     &table);
@@ -181,6 +227,7 @@ u8 hash_table_test_set_get_ptr_nonexistant(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -189,10 +236,18 @@ u8 hash_table_test_set_unset_ptr(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct *);
   u64 element_count = 3;
-  hash_table_test_struct *memory[element_count];
 
+  u64 memory_requirements = 0;
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
+                    0,
+                    true,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
                     memory,
                     true,
                     &table);
@@ -227,6 +282,7 @@ u8 hash_table_test_set_unset_ptr(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -235,10 +291,18 @@ u8 hash_table_test_call_non_ptr_funcs_on_ptr_table(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct *);
   u64 element_count = 3;
-  hash_table_test_struct *memory[element_count];
 
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    true,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
                     memory,
                     true,
                     &table);
@@ -261,6 +325,7 @@ u8 hash_table_test_call_non_ptr_funcs_on_ptr_table(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -269,10 +334,18 @@ u8 hash_table_test_call_ptr_funcs_on_non_ptr_table(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct);
   u64 element_count = 3;
-  hash_table_test_struct memory[element_count];
 
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
                     memory,
                     false,
                     &table);
@@ -296,6 +369,7 @@ u8 hash_table_test_call_ptr_funcs_on_non_ptr_table(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -304,10 +378,18 @@ u8 hash_table_test_set_get_update_ptr(void) {
   hash_table table;
   u64 element_size = sizeof(hash_table_test_struct *);
   u64 element_count = 3;
-  hash_table_test_struct *memory[element_count];
 
+  u64 memory_requirements = 0;
   hash_table_create(element_size,
                     element_count,
+                    &memory_requirements,
+                    0,
+                    true,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
                     memory,
                     true,
                     &table);
@@ -343,6 +425,210 @@ u8 hash_table_test_set_get_update_ptr(void) {
   should_be(0, table.memory);
   should_be(0, table.element_size);
   should_be(0, table.element_count);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
+
+  return true;
+}
+
+u8 hash_table_test_capacity_power_of_two(void) {
+  hash_table table;
+  u64 element_size = sizeof(u64);
+  u64 element_count = 1000;
+
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    memory,
+                    false,
+                    &table);
+  should_be(2048, table.capacity);
+  should_be(0, (table.capacity & (table.capacity - 1)));
+  b8 under_max_load = (table.element_count * 100) <= (table.capacity * HASH_TABLE_MAX_LOAD_FACTOR);
+  should_be_true(under_max_load);
+
+  hash_table_destroy(&table);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
+
+  return true;
+}
+
+u8 hash_table_test_no_collision_overwrite(void) {
+  hash_table table;
+  u64 element_size = sizeof(u64);
+  // 921 entries in 1024 slots -> ~0.9 load factor
+  u64 element_count = 921;
+
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    memory,
+                    false,
+                    &table);
+  should_be(1024, table.capacity);
+
+  char name[32];
+  for (u64 i = 0; i < element_count; ++i) {
+    kstrfmt(name, "texture_%llu", i);
+    should_be_true(hash_table_set(&table, name, &i));
+  }
+  should_be(element_count, table.length);
+
+  for (u64 i = 0; i < element_count; ++i) {
+    u64 value = INVALID_ID;
+    kstrfmt(name, "texture_%llu", i);
+    should_be_true(hash_table_get(&table, name, &value));
+    should_be(i, value);
+  }
+
+  // Full table rejects new keys but still accepts updates
+  u64 x = 23;
+  should_be_false(hash_table_set(&table, "not_in_table", &x));
+  should_be_true(hash_table_set(&table, "texture_0", &x));
+  u64 returned_x = 0;
+  hash_table_get(&table, "texture_0", &returned_x);
+  should_be(x, returned_x);
+  should_be(element_count, table.length);
+
+  hash_table_destroy(&table);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
+
+  return true;
+}
+
+u8 hash_table_test_remove(void) {
+  hash_table table;
+  u64 element_size = sizeof(u64);
+  u64 element_count = 256;
+
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    memory,
+                    false,
+                    &table);
+
+  char name[32];
+  for (u64 i = 0; i < element_count; ++i) {
+    kstrfmt(name, "material_%llu", i);
+    should_be_true(hash_table_set(&table, name, &i));
+  }
+  // Remove every even entry, the odd ones must survive the backward shifts
+  for (u64 i = 0; i < element_count; i += 2) {
+    kstrfmt(name, "material_%llu", i);
+    should_be_true(hash_table_remove(&table, name));
+  }
+  should_be(element_count / 2, table.length);
+  should_be_false(hash_table_remove(&table, "material_0"));
+
+  for (u64 i = 0; i < element_count; ++i) {
+    u64 value = INVALID_ID;
+    kstrfmt(name, "material_%llu", i);
+    b8 result = hash_table_get(&table, name, &value);
+    if (i % 2) {
+      should_be_true(result);
+      should_be(i, value);
+    }
+    else should_be_false(result);
+  }
+
+  hash_table_destroy(&table);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
+
+  return true;
+}
+
+u8 hash_table_test_fill_default(void) {
+  hash_table table;
+  u64 element_size = sizeof(hash_table_test_struct);
+  u64 element_count = 3;
+
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    memory,
+                    false,
+                    &table);
+
+  hash_table_test_struct invalid = {
+    .b = false,
+    .u = INVALID_ID,
+    .f = -1.0f
+  };
+  should_be_true(hash_table_fill(&table, &invalid));
+
+  hash_table_test_struct returned_x = {0};
+  should_be_false(hash_table_get(&table, "x", &returned_x));
+  should_be(invalid.u, returned_x.u);
+  float_should_be(invalid.f, returned_x.f);
+  should_be(0, table.length);
+
+  hash_table_destroy(&table);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
+
+  return true;
+}
+
+u8 hash_table_test_key_too_long(void) {
+  hash_table table;
+  u64 element_size = sizeof(u64);
+  u64 element_count = 3;
+
+  u64 memory_requirements = 0;
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    0,
+                    false,
+                    0);
+  void *memory = kallocate(memory_requirements, MEMORY_TAG_DICT);
+  hash_table_create(element_size,
+                    element_count,
+                    &memory_requirements,
+                    memory,
+                    false,
+                    &table);
+
+  char name[HASH_TABLE_KEY_MAX_LEN + 1];
+  kset_memory(name, 'x', HASH_TABLE_KEY_MAX_LEN);
+  name[HASH_TABLE_KEY_MAX_LEN] = 0;
+  u64 x = 23;
+  should_be_false(hash_table_set(&table, name, &x));
+  should_be(0, table.length);
+
+  hash_table_destroy(&table);
+  kfree(memory, memory_requirements, MEMORY_TAG_DICT);
 
   return true;
 }
@@ -357,4 +643,9 @@ void hash_table_test_register(void) {
   REGISTER_TEST(hash_table_test_call_non_ptr_funcs_on_ptr_table);
   REGISTER_TEST(hash_table_test_call_ptr_funcs_on_non_ptr_table);
   REGISTER_TEST(hash_table_test_set_get_update_ptr);
+  REGISTER_TEST(hash_table_test_capacity_power_of_two);
+  REGISTER_TEST(hash_table_test_no_collision_overwrite);
+  REGISTER_TEST(hash_table_test_remove);
+  REGISTER_TEST(hash_table_test_fill_default);
+  REGISTER_TEST(hash_table_test_key_too_long);
 }
@@ -0,0 +1,152 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <expect.h>
+#include <katomic.h>
+#include <kmemory.h>
+#include <job_system.h>
+#include <test_manager.h>
+#include <job_system_test.h>
+
+#define JOB_SYSTEM_TEST_WORKER_COUNT 4
+#define JOB_SYSTEM_TEST_JOB_COUNT 10000
+
+static void *job_system_test_startup(u64 *memory_requirements) {
+  job_system_config config = { .worker_count = JOB_SYSTEM_TEST_WORKER_COUNT };
+  job_system_initialize(memory_requirements, 0, config);
+  void *state = kallocate(*memory_requirements, MEMORY_TAG_JOB);
+  job_system_initialize(memory_requirements, state, config);
+  return state;
+}
+
+static void job_system_test_shutdown(void *state, u64 memory_requirements) {
+  job_system_shutdown(state);
+  kfree(state, memory_requirements, MEMORY_TAG_JOB);
+}
+
+static void increment_job(void *data) {
+  katomic_fetch_add_explicit((katomic_u64 *) data, 1, KATOMIC_RELAXED);
+}
+
+static void spawn_job(void *data) {
+  // Jobs may submit and wait on their own children
+  job_counter counter = {0};
+  for (u32 i = 0; i < 10; ++i) job_system_submit(increment_job, data, &counter);
+  job_system_wait(&counter);
+}
+
+static void sum_range(u32 start, u32 end, void *data) {
+  u32 *values = data;
+  for (u32 i = start; i < end; ++i) values[i] *= 2;
+}
+
+u8 job_system_test_submit_wait(void) {
+  u64 memory_requirements = 0;
+  void *state = job_system_test_startup(&memory_requirements);
+  should_be(JOB_SYSTEM_TEST_WORKER_COUNT, job_system_worker_count());
+
+  katomic_u64 value = 0;
+  job_counter counter = {0};
+  for (u32 i = 0; i < JOB_SYSTEM_TEST_JOB_COUNT; ++i) job_system_submit(increment_job, &value, &counter);
+  job_system_wait(&counter);
+  should_be(JOB_SYSTEM_TEST_JOB_COUNT, katomic_load(&value));
+  should_be(0, katomic_load(&counter.pending));
+
+  job_system_test_shutdown(state, memory_requirements);
+  return true;
+}
+
+u8 job_system_test_nested(void) {
+  u64 memory_requirements = 0;
+  void *state = job_system_test_startup(&memory_requirements);
+
+  katomic_u64 value = 0;
+  job_counter counter = {0};
+  for (u32 i = 0; i < 100; ++i) job_system_submit(spawn_job, &value, &counter);
+  job_system_wait(&counter);
+  should_be(100 * 10, katomic_load(&value));
+
+  job_system_test_shutdown(state, memory_requirements);
+  return true;
+}
+
+u8 job_system_test_parallel_for(void) {
+  u64 memory_requirements = 0;
+  void *state = job_system_test_startup(&memory_requirements);
+
+  const u32 count = 100003;  // not a multiple of the batch size
+  u32 *values = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+  for (u32 i = 0; i < count; ++i) values[i] = i;
+  job_system_parallel_for(count, 64, sum_range, values);
+  for (u32 i = 0; i < count; ++i) {
+    if (values[i] != i * 2) {
+      should_be(i * 2, values[i]);
+    }
+  }
+  kfree(values, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+
+  job_system_test_shutdown(state, memory_requirements);
+  return true;
+}
+
+u8 job_system_test_without_workers(void) {
+  // Before initialization everything runs inline on the caller
+  katomic_u64 value = 0;
+  job_counter counter = {0};
+  job_system_submit(increment_job, &value, &counter);
+  should_be(1, katomic_load(&value));
+  job_system_wait(&counter);
+
+  u32 values[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  job_system_parallel_for(10, 3, sum_range, values);
+  should_be(20, values[9]);
+  return true;
+}
+
+u8 job_system_test_try_run(void) {
+  // A lone worker 0 only makes progress when it polls for jobs
+  job_system_config config = { .worker_count = 1 };
+  u64 memory_requirements = 0;
+  job_system_initialize(&memory_requirements, 0, config);
+  void *state = kallocate(memory_requirements, MEMORY_TAG_JOB);
+  job_system_initialize(&memory_requirements, state, config);
+
+  katomic_u64 value = 0;
+  job_counter counter = {0};
+  for (u32 i = 0; i < 3; ++i) job_system_submit(increment_job, &value, &counter);
+  should_be(0, katomic_load(&value));
+  should_be(true, job_system_try_run());
+  should_be(1, katomic_load(&value));
+  while (job_system_try_run()) {}
+  should_be(3, katomic_load(&value));
+  should_be(0, katomic_load(&counter.pending));
+  should_be(false, job_system_try_run());
+
+  job_system_test_shutdown(state, memory_requirements);
+  return true;
+}
+
+void job_system_test_register(void) {
+  REGISTER_TEST(job_system_test_submit_wait);
+  REGISTER_TEST(job_system_test_nested);
+  REGISTER_TEST(job_system_test_parallel_for);
+  REGISTER_TEST(job_system_test_without_workers);
+  REGISTER_TEST(job_system_test_try_run);
+}
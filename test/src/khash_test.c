@@ -0,0 +1,94 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <khash.h>
+#include <expect.h>
+#include <kstring.h>
+#include <khash_test.h>
+#include <test_manager.h>
+
+#define KHASH_TEST_DATA_SIZE 300
+
+static void fill_test_data(u8 *data, u64 size) {
+  for (u64 i = 0; i < size; ++i) data[i] = (u8) ((i * 131) ^ (i >> 3));
+}
+
+u8 khash_test_deterministic(void) {
+  const char *name = "cobblestone";
+  u64 h = khash(name, kstrlen(name), KHASH_DEFAULT_SEED);
+  should_be(h, khash(name, kstrlen(name), KHASH_DEFAULT_SEED));
+  should_be(h, khash_str(name));
+  return true;
+}
+
+u8 khash_test_distinct(void) {
+  should_not_be(khash_str("KEKL"), khash_str("KEKW"));
+  should_not_be(khash_str("paving"), khash_str("paving2"));
+  should_not_be(khash_str(""), khash_str("a"));
+  // Same bytes, different length
+  should_not_be(khash("ab", 1, KHASH_DEFAULT_SEED), khash("ab", 2, KHASH_DEFAULT_SEED));
+  // Same bytes, different seed
+  should_not_be(khash("ab", 2, 0), khash("ab", 2, 1));
+  return true;
+}
+
+u8 khash_test_streaming_matches_oneshot(void) {
+  u8 data[KHASH_TEST_DATA_SIZE];
+  fill_test_data(data, KHASH_TEST_DATA_SIZE);
+
+  // Cover the short (<= 16), tail (<= 48) and block (> 48) paths
+  for (u64 length = 0; length <= KHASH_TEST_DATA_SIZE; ++length) {
+    u64 expected = khash(data, length, 42);
+    for (u64 chunk = 1; chunk <= 64; chunk += 7) {
+      khash_state state;
+      khash_begin(&state, 42);
+      for (u64 offset = 0; offset < length; offset += chunk) {
+        u64 n = (length - offset) < chunk ? (length - offset) : chunk;
+        khash_update(&state, data + offset, n);
+      }
+      should_be(expected, khash_end(&state));
+    }
+  }
+  return true;
+}
+
+u8 khash_test_low_bits_spread(void) {
+  // Masked low bits must spread sequential names over the buckets
+  const u32 bucket_count = 64;
+  u32 buckets[bucket_count];
+  kzero_memory(buckets, sizeof(buckets));
+  char name[32];
+  for (u32 i = 0; i < bucket_count * 16; ++i) {
+    kstrfmt(name, "texture_%u", i);
+    ++buckets[khash_str(name) & (bucket_count - 1)];
+  }
+  for (u32 i = 0; i < bucket_count; ++i) {
+    b8 used = buckets[i] > 0;
+    should_be_true(used);
+  }
+  return true;
+}
+
+void khash_test_register(void) {
+  REGISTER_TEST(khash_test_deterministic);
+  REGISTER_TEST(khash_test_distinct);
+  REGISTER_TEST(khash_test_streaming_matches_oneshot);
+  REGISTER_TEST(khash_test_low_bits_spread);
+}
@@ -0,0 +1,66 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <kimage.h>
+#include <expect.h>
+#include <kimage_test.h>
+#include <test_manager.h>
+
+u8 kimage_test_mip_count(void) {
+  should_be(1, kimage_mip_count(1, 1));
+  should_be(9, kimage_mip_count(256, 256));
+  should_be(9, kimage_mip_count(256, 1));
+  should_be(9, kimage_mip_count(300, 200));
+  should_be(1, kimage_mip_extent(300, 8));
+  should_be(37, kimage_mip_extent(300, 3));
+  return true;
+}
+
+u8 kimage_test_downsample(void) {
+  // 4x2 RGBA, each 2x2 block averages to its own color
+  u8 pixels[4 * 2 * 4] = {
+    0, 0, 0, 255,  4, 8, 0, 255,  100, 100, 100, 0,  100, 100, 100, 0,
+    4, 8, 0, 255,  0, 0, 0, 255,  100, 100, 100, 0,  100, 100, 100, 0
+  };
+  kimage_downsample(pixels, 4, 2, 4, pixels);
+  should_be(2, pixels[0]);
+  should_be(4, pixels[1]);
+  should_be(0, pixels[2]);
+  should_be(255, pixels[3]);
+  should_be(100, pixels[4]);
+  should_be(0, pixels[7]);
+  return true;
+}
+
+u8 kimage_test_downsample_odd(void) {
+  // 3x1 single channel, the last column and row are clamped
+  u8 pixels[3] = { 10, 30, 200 };
+  u8 out[1];
+  kimage_downsample(pixels, 3, 1, 1, out);
+  should_be(20, out[0]);
+  return true;
+}
+
+void kimage_test_register(void) {
+  REGISTER_TEST(kimage_test_mip_count);
+  REGISTER_TEST(kimage_test_downsample);
+  REGISTER_TEST(kimage_test_downsample_odd);
+}
@@ -0,0 +1,146 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <kname.h>
+#include <expect.h>
+#include <kmemory.h>
+#include <kstring.h>
+#include <kname_test.h>
+#include <test_manager.h>
+
+static void *kname_test_startup(void) {
+  u64 memory_requirements = 0;
+  kname_system_initialize(&memory_requirements, 0);
+  void *state = kallocate(memory_requirements, MEMORY_TAG_APPLICATION);
+  kname_system_initialize(&memory_requirements, state);
+  return state;
+}
+
+static void kname_test_shutdown(void *state) {
+  u64 memory_requirements = 0;
+  kname_system_initialize(&memory_requirements, 0);
+  kname_system_shutdown(state);
+  kfree(state, memory_requirements, MEMORY_TAG_APPLICATION);
+}
+
+u8 kname_test_create_and_find(void) {
+  void *state = kname_test_startup();
+
+  kname cobblestone = kname_create("cobblestone");
+  should_not_be(KNAME_NONE, cobblestone);
+  should_be(cobblestone, kname_create("cobblestone"));
+  should_be(cobblestone, kname_find("cobblestone"));
+  should_be_true(kstrcmp("cobblestone", kname_str(cobblestone)));
+
+  // Names are case sensitive and get sequential IDs
+  kname cobblestone_upper = kname_create("Cobblestone");
+  should_be(cobblestone + 1, cobblestone_upper);
+
+  // Lookups never intern
+  should_be(KNAME_NONE, kname_find("paving"));
+  should_be(KNAME_NONE, kname_find("paving"));
+
+  kname_test_shutdown(state);
+  return true;
+}
+
+u8 kname_test_none(void) {
+  void *state = kname_test_startup();
+
+  should_be(KNAME_NONE, kname_create(0));
+  should_be(KNAME_NONE, kname_create(""));
+  should_be(KNAME_NONE, kname_find(""));
+  should_be_true(kstrcmp("", kname_str(KNAME_NONE)));
+
+  char long_name[KNAME_MAX_LEN + 1];
+  kset_memory(long_name, 'a', KNAME_MAX_LEN);
+  long_name[KNAME_MAX_LEN] = 0;
+  should_be(KNAME_NONE, kname_create(long_name));
+
+  kname_test_shutdown(state);
+  return true;
+}
+
+u8 kname_test_stable_ids(void) {
+  void *state = kname_test_startup();
+
+  char name[32];
+  kname first = KNAME_NONE;
+  for (u32 i = 0; i < 1000; ++i) {
+    kstrfmt(name, "texture_%u", i);
+    kname n = kname_create(name);
+    if (!i) first = n;
+    should_be(first + i, n);
+  }
+  // IDs (and the strings behind them) survive later insertions
+  for (u32 i = 0; i < 1000; ++i) {
+    kstrfmt(name, "texture_%u", i);
+    should_be(first + i, kname_find(name));
+    should_be_true(kstrcmp(name, kname_str(first + i)));
+  }
+
+  kname_test_shutdown(state);
+  return true;
+}
+
+u8 kname_test_reinitialize(void) {
+  void *state = kname_test_startup();
+  kname_create("cobblestone");
+  kname_create("paving");
+  kname_test_shutdown(state);
+
+  // A new system starts empty, nothing survives from the previous one
+  state = kname_test_startup();
+  should_be(KNAME_NONE, kname_find("cobblestone"));
+  kname paving = kname_create("paving");
+  should_be(KNAME_BUILTIN_END, paving);
+  should_be_true(kstrcmp("paving", kname_str(paving)));
+
+  kname_test_shutdown(state);
+  return true;
+}
+
+u8 kname_test_builtins(void) {
+  void *state = kname_test_startup();
+
+  // Builtin IDs are known before the system runs
+  should_be(KNAME_FALLBACK, kname_find("fallback"));
+  should_be(KNAME_FALLBACK, kname_create("fallback"));
+  should_be_true(kstrcmp("fallback", kname_str(KNAME_FALLBACK)));
+  switch (kname_create("fallback")) {
+  case KNAME_FALLBACK:
+    break;
+  default:
+    should_be_true(false);
+  }
+  // Runtime names never collide with them
+  should_be(KNAME_BUILTIN_END, kname_create("cobblestone"));
+
+  kname_test_shutdown(state);
+  return true;
+}
+
+void kname_test_register(void) {
+  REGISTER_TEST(kname_test_create_and_find);
+  REGISTER_TEST(kname_test_none);
+  REGISTER_TEST(kname_test_stable_ids);
+  REGISTER_TEST(kname_test_reinitialize);
+  REGISTER_TEST(kname_test_builtins);
+}
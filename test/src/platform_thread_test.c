@@ -0,0 +1,105 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <expect.h>
+#include <katomic.h>
+#include <platform.h>
+#include <test_manager.h>
+#include <platform_thread_test.h>
+
+#define PLATFORM_THREAD_TEST_THREAD_COUNT 4
+#define PLATFORM_THREAD_TEST_ITERATIONS 20000
+
+typedef struct {
+  platform_mutex mutex;
+  u64 value;  // only touched under `mutex`
+} mutex_test_data;
+
+typedef struct {
+  platform_semaphore ping;
+  platform_semaphore pong;
+  katomic_u32 rounds;
+} semaphore_test_data;
+
+static u32 mutex_test_thread(void *params) {
+  mutex_test_data *data = params;
+  for (u32 i = 0; i < PLATFORM_THREAD_TEST_ITERATIONS; ++i) {
+    platform_mutex_lock(&data->mutex);
+    ++data->value;
+    platform_mutex_unlock(&data->mutex);
+  }
+  return 0;
+}
+
+static u32 semaphore_test_thread(void *params) {
+  semaphore_test_data *data = params;
+  for (u32 i = 0; i < PLATFORM_THREAD_TEST_ITERATIONS; ++i) {
+    platform_semaphore_wait(&data->ping);
+    katomic_fetch_add(&data->rounds, 1);
+    platform_semaphore_signal(&data->pong);
+  }
+  return 0;
+}
+
+u8 platform_thread_test_mutex(void) {
+  mutex_test_data data = {0};
+  platform_mutex_create(&data.mutex);
+
+  platform_thread threads[PLATFORM_THREAD_TEST_THREAD_COUNT];
+  for (u32 i = 0; i < PLATFORM_THREAD_TEST_THREAD_COUNT; ++i) {
+    should_be_true(platform_thread_create(mutex_test_thread, &data, &threads[i]));
+  }
+  for (u32 i = 0; i < PLATFORM_THREAD_TEST_THREAD_COUNT; ++i) platform_thread_join(&threads[i]);
+  should_be(PLATFORM_THREAD_TEST_THREAD_COUNT * PLATFORM_THREAD_TEST_ITERATIONS, data.value);
+
+  should_be_true(platform_mutex_try_lock(&data.mutex));
+  should_be_false(platform_mutex_try_lock(&data.mutex));
+  platform_mutex_unlock(&data.mutex);
+
+  platform_mutex_destroy(&data.mutex);
+  return true;
+}
+
+u8 platform_thread_test_semaphore(void) {
+  semaphore_test_data data;
+  platform_semaphore_create(0, &data.ping);
+  platform_semaphore_create(0, &data.pong);
+  katomic_init(&data.rounds, 0);
+
+  should_be_false(platform_semaphore_try_wait(&data.ping));
+
+  platform_thread thread;
+  should_be_true(platform_thread_create(semaphore_test_thread, &data, &thread));
+  for (u32 i = 0; i < PLATFORM_THREAD_TEST_ITERATIONS; ++i) {
+    platform_semaphore_signal(&data.ping);
+    platform_semaphore_wait(&data.pong);
+    should_be(i + 1, katomic_load(&data.rounds));
+  }
+  platform_thread_join(&thread);
+
+  platform_semaphore_destroy(&data.ping);
+  platform_semaphore_destroy(&data.pong);
+  return true;
+}
+
+void platform_thread_test_register(void) {
+  REGISTER_TEST(platform_thread_test_mutex);
+  REGISTER_TEST(platform_thread_test_semaphore);
+}
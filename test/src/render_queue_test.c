@@ -0,0 +1,103 @@
+/*
+ * GNU WGE --- Wildebeest Game Engine™
+ * Copyright (C) 2023 Wasym A. Alonso
+ *
+ * This file is part of WGE.
+ *
+ * WGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WGE.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <expect.h>
+#include <render_queue.h>
+#include <test_manager.h>
+#include <render_queue_test.h>
+
+u8 render_queue_test_sort(void) {
+  render_queue queue;
+  render_queue_create(4, &queue);
+
+  // Pushing past the capacity grows the queue
+  const u32 count = 1000;
+  u64 state = 0x9E3779B97F4A7C15ull;
+  for (u32 i = 0; i < count; ++i) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    render_queue_push(&queue, state, i);
+  }
+  should_be(count, queue.count);
+  render_queue_sort(&queue);
+
+  u64 index_sum = 0;
+  for (u32 i = 0; i < count; ++i) {
+    if (i) should_be_true((queue.entries[i - 1].key <= queue.entries[i].key));
+    index_sum += queue.entries[i].index;
+  }
+  should_be((u64) count * (count - 1) / 2, index_sum);
+
+  render_queue_destroy(&queue);
+  return true;
+}
+
+u8 render_queue_test_stable(void) {
+  render_queue queue;
+  render_queue_create(8, &queue);
+
+  render_queue_push(&queue, 7, 0);
+  render_queue_push(&queue, 3, 1);
+  render_queue_push(&queue, 7, 2);
+  render_queue_push(&queue, 3, 3);
+  render_queue_push(&queue, 7, 4);
+  render_queue_sort(&queue);
+
+  u32 expected[] = { 1, 3, 0, 2, 4 };
+  for (u32 i = 0; i < 5; ++i) should_be(expected[i], queue.entries[i].index);
+
+  render_queue_clear(&queue);
+  should_be(0, queue.count);
+  render_queue_destroy(&queue);
+  return true;
+}
+
+u8 render_queue_test_key_order(void) {
+  // Passes come first, then opaque before transparent
+  u64 world_opaque = render_queue_make_key(1, false, 9, 9, 1.0f);
+  u64 world_transparent = render_queue_make_key(1, true, 0, 0, 0.0f);
+  u64 ui = render_queue_make_sequence_key(2, 0);
+  should_be(1, render_queue_key_pass(world_opaque));
+  should_be(2, render_queue_key_pass(ui));
+  should_be_true((world_opaque < world_transparent));
+  should_be_true((world_transparent < ui));
+
+  // Opaque draws group by material, then geometry, then front to back
+  should_be_true((render_queue_make_key(1, false, 1, 5, 0.9f) < render_queue_make_key(1, false, 2, 0, 0.1f)));
+  should_be_true((render_queue_make_key(1, false, 1, 1, 0.9f) < render_queue_make_key(1, false, 1, 2, 0.1f)));
+  should_be_true((render_queue_make_key(1, false, 1, 1, 0.1f) < render_queue_make_key(1, false, 1, 1, 0.9f)));
+
+  // Transparent draws go back to front regardless of material
+  should_be_true((render_queue_make_key(1, true, 5, 0, 0.9f) < render_queue_make_key(1, true, 1, 0, 0.1f)));
+
+  // Sequence keys keep submission order
+  should_be_true((render_queue_make_sequence_key(2, 3) < render_queue_make_sequence_key(2, 4)));
+
+  // Out of range depths are clamped
+  should_be(render_queue_make_key(1, false, 0, 0, 1.0f), render_queue_make_key(1, false, 0, 0, 5.0f));
+  should_be(render_queue_make_key(1, false, 0, 0, 0.0f), render_queue_make_key(1, false, 0, 0, -5.0f));
+  return true;
+}
+
+void render_queue_test_register(void) {
+  REGISTER_TEST(render_queue_test_sort);
+  REGISTER_TEST(render_queue_test_stable);
+  REGISTER_TEST(render_queue_test_key_order);
+}
@@ -21,10 +21,18 @@
 
 #include <logger.h>
 #include <clock_test.h>
-#include <test_manager.h>
+#include <khash_test.h>
+#include <kimage_test.h>
+#include <kname_test.h>
 #include <kstring_test.h>
+#include <test_manager.h>
 #include <free_list_test.h>
 #include <hash_table_test.h>
+#include <job_system_test.h>
+#include <frame_pacer_test.h>
+#include <handle_pool_test.h>
+#include <render_queue_test.h>
+#include <platform_thread_test.h>
 #include <linear_allocator_test.h>
 
 int main(void) {
@@ -32,9 +40,17 @@ int main(void) {
 
   clock_test_register();
   kstring_test_register();
+  khash_test_register();
+  kimage_test_register();
+  kname_test_register();
   free_list_test_register();
   hash_table_test_register();
+  handle_pool_test_register();
   linear_allocator_test_register();
+  platform_thread_test_register();
+  job_system_test_register();
+  render_queue_test_register();
+  frame_pacer_test_register();
 
   test_manager_run();
   return 0;